@@ -4,49 +4,125 @@
 #include <raylib.h>
 #include <portaudio.h>
 #include <pthread.h>
+#include <stdio.h>
 
 #include "redefines.h"
 #include "spectrum.h"
+#include "spectrum_view.h"
+#include "spsc_ring.h"
+#include "triple_buffer.h"
+#include "latency.h"
+#include "perf.h"
 
+typedef struct app_state app_state_t;
+
+// One analysed input: the WAV file, or a capture device with its own ring. Each source runs its
+// own analyser on its own thread (FFT plans of matching sizes are shared through the fft_plan
+// cache) and is drawn in its own pane.
 typedef struct
+{
+    app_state_t *app;
+
+    spectrum_state_t spectrum_state;
+    spectrum_view_t view; // its pane: layout, bar texture and waterfall
+
+    // Analysis thread: runs the analyser at ANALYSIS_UPDATE_HZ and publishes each result as a
+    // frame. analysis_lock guards the analyser against input handling and resizes on the
+    // render thread; the render loop takes the newest frame without locking.
+    pthread_t analysis_thread;
+    pthread_mutex_t analysis_lock;
+    i32 analysis_thread_started;
+    i32 analysis_quit;
+    spectrum_frame_t frames[3];
+    triple_buffer_t frame_exchange;
+
+    // Live mic mode
+    i32 device_index; // PortAudio device, -1 = default input (or PA_DEVICE_INDEX)
+    const PaDeviceInfo *device_info;
+    PaStream *stream;
+    f64 input_sample_rate;
+    i32 input_channels;         // interleaved channels captured
+    spsc_ring_t mic_ring;       // interleaved captured frames: callback -> analysis thread
+    ul mic_ring_dropped_frames; // frames the callback found no room for
+    f32 *mic_hops;              // new hops popped for one update (interleaved), fed to the analyser front-end
+
+    // --low-latency: eventfd the callback signals once wake_frames (the hop) are buffered, -1 off
+    i32 wake_fd;
+    i32 wake_frames;
+
+    // Capture-to-display latency (mic mode). Each captured block is stamped with its ADC time
+    // next to the ring; the analysis thread dates each hop it analyzes and the frames it
+    // publishes, and the render loop dates each frame it draws.
+    latency_stamps_t stamps;
+    u64 mic_frames_pushed;           // callback: frames the ring accepted so far
+    u64 mic_frames_popped;           // analysis thread: frames taken out so far
+    f64 input_time;                  // analysis thread: stream time of the newest analyzed sample
+    latency_stats_t hop_latency;     // analysis thread
+    f64 hop_latency_p50;             // published by the analysis thread (atomic)
+    f64 hop_latency_p99;             // published by the analysis thread (atomic)
+    i64 hop_latency_hops;            // published by the analysis thread (atomic)
+    f64 hop_latency_reported;        // analysis thread: when the above were last refreshed
+    latency_stats_t display_latency; // render thread
+    latency_report_t latency;        // render thread: what the overlay and log show
+} app_source_t;
+
+struct app_state
 {
     i32 running;
-    i32 freeze_enabled;
-    i32 cursor_lock_enabled;
+    i32 freeze_enabled;      // toggled by the render loop, read by the analysis threads (atomic)
+    i32 cursor_lock_enabled; // the cursor belongs to the focused source
     i32 cursor_locked_index;
     i32 cursor_hover_index;
     i32 windowed_w;
     i32 windowed_h;
     i32 loop_flag;
     i32 fractional_octave_index_selected;
+    i32 fft_plan_rigor;
+    i32 fft_force_replan;
+    i32 fft_size; // requested on the command line, then tracks the live setting
+    i32 hop_size;
+    i32 average_mode;    // AVERAGE_*, applied once the analyser exists
+    i32 average_count;   // hops
+    f64 average_seconds; // > 0 overrides average_count
+    i32 waterfall_enabled;
+    i32 time_locked;              // file mode: analyze at the playhead, skipping stale hops
+    i32 low_latency;              // mic mode: analyze each hop as soon as it is captured (--low-latency)
+    i32 frames_per_buffer;        // PortAudio buffer size, 0 = host decides (--frames-per-buffer)
+    const char *latency_log_path; // mic mode: CSV of the latency percentiles (--latency-log)
+    const char *perf_log_path;    // CSV of the stage timings (--perf-log)
+    i32 input_channels;           // mic mode: interleaved channels to capture per device (--channels)
+    i32 channel_layout;           // CHANNEL_LAYOUT_*, applied once the analyser exists
+    i32 analyze_mode;             // --analyze: headless file analysis instead of the window
+    const char *analyze_output;
+    i32 analyze_bands;
+    i32 analyze_threads;
 
     Font main_font;
 
-    spectrum_state_t spectrum_state;
+    // The file, or one per --mic device; keys and clicks act on the focused one
+    app_source_t sources[INPUT_MAX_DEVICES];
+    i32 num_sources;
+    i32 focused_source;
 
-    Wave wave;
+    wav_reader_t wav;
     Music music;
-    f32 *samples;
-    f64 playback_time_prev;
-
-    PaDeviceInfo *selected_device_info;
-    PaStream *selected_device_stream;
-    f64 input_sample_rate;
+    f64 playback_time_prev; // analysis thread
+    f64 playhead_seconds;   // GetMusicTimePlayed, stored by the render loop for the analysis thread
 
     // Live mic mode
-    i32 mic_mode;               // 1=use mic input, 0=use WAV file
-    f32 *mic_ring;              // mono ring buffer for captured samples
-    ul mic_ring_capacity;       // capacity in frames
-    volatile ul mic_ring_write; // producer index (callback)
-    volatile ul mic_ring_read;  // consumer index (main thread)
-    ul mic_ring_dropped_frames;
-    pthread_mutex_t mic_ring_mutex;
-    i32 mic_ring_mutex_initialized;
-    f32 mic_window[FFT_WINDOW_SIZE]; // sliding window buffer for FFT
-} app_state_t;
+    i32 mic_mode;         // 1=use mic input, 0=use WAV file
+    FILE *latency_log;    // --latency-log, written by the render loop
+    f64 latency_reported; // GetTime() of the last latency report
+
+    // Stage timing, refreshed every PERF_REPORT_SECONDS by the render loop
+    i32 profiler_enabled; // panel shown (I)
+    perf_report_t perf;
+    FILE *perf_log; // --perf-log
+    f64 perf_reported;
+};
 
 void
-app_parse_input_args(i32 argc, char **argv, char **input_file, i32 *loop_flag, i32 *mic_mode);
+app_parse_input_args(i32 argc, char **argv, char **input_file, app_state_t *app_state);
 
 void
 app_handle_input(app_state_t *app_state);
@@ -54,6 +130,11 @@ app_handle_input(app_state_t *app_state);
 i32
 app_init_audio_capture(app_state_t *app_state);
 
+// Switches a source's analyser to a new FFT size/hop, keeping the playback position (file mode)
+// or the newest captured samples (mic mode). Returns 0 on failure (previous setting kept).
+i32
+app_set_fft_size(app_state_t *app_state, app_source_t *src, i32 fft_size, i32 hop_size);
+
 i32
 app_platform_init(app_state_t *app_state);
 
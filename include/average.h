@@ -0,0 +1,70 @@
+#ifndef AVERAGE_H
+#define AVERAGE_H
+
+#include "redefines.h"
+#include "fft_plan.h"
+
+#define AVERAGE_OFF         0
+#define AVERAGE_LINEAR      1
+#define AVERAGE_EXPONENTIAL 2
+#define AVERAGE_LEQ         3
+#define NUM_AVERAGE_MODES   4
+
+// Bin-domain averaging of |X|^2 across hops:
+//   Linear (Welch)  mean of `target` spectra; the display shows the running mean of the
+//                   first block, then each completed block until the next one completes
+//   Exponential     y += (x - y) / min(count, target), i.e. a time constant of `target`
+//                   hops that starts as a plain mean instead of rising from zero
+//   Leq             mean of every spectrum since the last reset
+// The accumulator is f64 so long Leq runs keep resolving new hops in single precision builds.
+typedef struct
+{
+    i32 mode;
+    i32 bins;
+    i32 target;
+    f64 enbw_bins; // equivalent noise bandwidth of the analysis window, in bins
+
+    f64 *acc;
+    spectrum_real_t *result;
+    i64 count;     // spectra in the current accumulation
+    i64 completed; // linear blocks completed since the reset
+    i32 dirty;     // result needs recomputing from acc
+} spectral_average_t;
+
+// (Re)allocates for `bins` bins and resets; mode and target are kept. Returns 0 on failure.
+i32
+spectral_average_resize(spectral_average_t *avg, i32 bins);
+
+void
+spectral_average_free(spectral_average_t *avg);
+
+void
+spectral_average_reset(spectral_average_t *avg);
+
+// Both restart the accumulation
+void
+spectral_average_set_mode(spectral_average_t *avg, i32 mode);
+
+void
+spectral_average_set_target(spectral_average_t *avg, i32 target);
+
+void
+spectral_average_add(spectral_average_t *avg, const spectrum_real_t *power);
+
+// Averaged power per bin; only computed when asked for, so a burst of hops costs one
+// accumulate per hop and a single normalisation
+const spectrum_real_t *
+spectral_average_result(spectral_average_t *avg);
+
+// n * sum(w^2) / sum(w)^2 (1.5 for Hann)
+f64
+spectral_average_enbw(const spectrum_real_t *window, i32 n);
+
+// Parses "off" / "lin" / "exp" / "leq". Returns -1 if unknown.
+i32
+spectral_average_mode_from_name(const char *name);
+
+const char *
+spectral_average_mode_label(i32 mode);
+
+#endif // AVERAGE_H
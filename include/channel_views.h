@@ -0,0 +1,89 @@
+#ifndef CHANNEL_VIEWS_H
+#define CHANNEL_VIEWS_H
+
+#include "redefines.h"
+#include "config.h"
+#include "fft_plan.h"
+#include "mirror_buffer.h"
+
+#define CHANNEL_LAYOUT_OFF     0
+#define CHANNEL_LAYOUT_OVERLAY 1 // one trace per view over the mono bars
+#define CHANNEL_LAYOUT_STACK   2 // one strip of bars per view in place of the mono bars
+#define NUM_CHANNEL_LAYOUTS    3
+
+// Per-channel spectra next to the mono analysis. Every input channel (up to
+// CHANNEL_VIEW_MAX_INPUTS), plus Mid and Side of the first two, is high-passed into its own
+// mirrored history like the mono front-end; each hop then windows all views back to back and
+// transforms them with one batched plan. The analyser maps and smooths the bars per view;
+// meters, averaging, zoom and the waterfall stay on the mono path.
+typedef struct
+{
+    i32 layout;         // CHANNEL_LAYOUT_*
+    i32 input_channels; // interleaved channels in the source
+    i32 inputs;         // channels analyzed
+    i32 count;          // views: the inputs, then Mid and Side when there are two or more
+
+    // Sizes the buffers below are allocated for; fft_size 0 = none yet
+    i32 fft_size;
+    i32 fft_bins;
+    i32 num_bars;
+
+    f32 *planar; // one feed de-interleaved: max(input_channels, count) rows of fft_size
+    i32 planar_rows;
+
+    mirror_buffer_t history_buf[CHANNEL_VIEW_MAX];
+    spectrum_real_t *history[CHANNEL_VIEW_MAX];
+    i32 history_size; // the same for every view
+    i32 history_pos;
+    spectrum_real_t hpf_prev_x[CHANNEL_VIEW_MAX];
+    spectrum_real_t hpf_prev_y[CHANNEL_VIEW_MAX];
+    i32 hpf_primed;
+
+    const fft_plan_entry_t *plan; // `count` transforms per execution
+    spectrum_real_t *fft_in;      // count * fft_size
+    spectrum_complex_t *fft_out;  // count * fft_bins
+    spectrum_real_t *bin_power;   // fft_bins, scratch for one view
+
+    f64 *bar_target;   // count * num_bars
+    f64 *bar_smoothed; // count * num_bars
+} channel_views_t;
+
+// Sets the source channel count and the views derived from it; buffers are reallocated by
+// the next channel_views_prepare
+void
+channel_views_set_input_channels(channel_views_t *v, i32 channels);
+
+// (Re)allocates for the FFT size and bar count if either changed. A new FFT size restarts the
+// histories. Returns 0 on failure (everything freed).
+i32
+channel_views_prepare(channel_views_t *v, i32 fft_size, i32 num_bars);
+
+void
+channel_views_free(channel_views_t *v);
+
+// Clears the histories and restarts the filters (seek, loop, resync)
+void
+channel_views_reset(channel_views_t *v);
+
+// Filters `count` frames from planar rows 0..inputs-1 (Mid and Side are derived here) into
+// the histories
+void
+channel_views_feed(channel_views_t *v, i32 count, spectrum_real_t hpf_alpha);
+
+// Windows the newest fft_size samples of every view into fft_in and transforms them together
+// into fft_out (view i at fft_out + i * fft_bins)
+void
+channel_views_transform(channel_views_t *v, const spectrum_real_t *window);
+
+// "L"/"R" for stereo, "Ch n" otherwise, "M"/"S" for the derived views
+const char *
+channel_views_label(const channel_views_t *v, i32 view, char *buf, usize size);
+
+// Parses "off" / "overlay" / "stack". Returns -1 if unknown.
+i32
+channel_layout_from_name(const char *name);
+
+const char *
+channel_layout_label(i32 layout);
+
+#endif // CHANNEL_VIEWS_H
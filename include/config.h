@@ -18,15 +18,41 @@
 #define DB_TOP    0.0
 #define DB_OFFSET 0.0
 
-#define FFT_WINDOW_SIZE   8192
-#define FFT_HOP_SIZE      (FFT_WINDOW_SIZE / 16)
-#define HPF_CUTOFF_HZ     1.0
-#define SMOOTH_ATTACK_MS  0.0
-#define SMOOTH_RELEASE_MS 250.0
+// Default FFT size and hop; both can be changed at runtime (--fft-size/--hop, N/B keys)
+#define FFT_WINDOW_SIZE     8192
+#define FFT_HOP_SIZE        (FFT_WINDOW_SIZE / 16)
+#define FFT_MIN_WINDOW_SIZE 1024
+#define FFT_MAX_WINDOW_SIZE 65536
+#define FFT_MAX_BATCH_HOPS  8 // pending hops transformed together by one batched plan (power of two)
+#define HPF_CUTOFF_HZ       1.0
+#define SMOOTH_ATTACK_MS    0.0
+#define SMOOTH_RELEASE_MS   250.0
 
 #define DB_SMOOTH_ATTACK_MS  10.0
 #define DB_SMOOTH_RELEASE_MS 250.0
 
+// Bin-domain averaging length in hops (--average-count/--average-time, X key)
+#define AVERAGE_DEFAULT_COUNT 32
+
+// Zoom-FFT around the locked band: decimate by ZOOM_DECIMATION, then a ZOOM_FFT_SIZE complex FFT
+// (48 kHz: 375 Hz displayed span, 0.37 Hz bins, a new spectrum every ~0.7 s)
+#define ZOOM_DECIMATION 64
+#define ZOOM_FFT_SIZE   2048
+#define ZOOM_HOP        (ZOOM_FFT_SIZE / 4)
+#define ZOOM_FIR_TAPS   (12 * ZOOM_DECIMATION)
+
+// Per-channel spectra (--channel-view, L key): input channels analyzed per view (further
+// channels are left out of the views), plus Mid and Side of the first two
+#define CHANNEL_VIEW_MAX_INPUTS 8
+#define CHANNEL_VIEW_MAX        (CHANNEL_VIEW_MAX_INPUTS + 2)
+
+// Waterfall below the bars (--waterfall, S key): history length in rows, share of the plot
+// height, gap left for the frequency labels, and rows queued between renders (power of two)
+#define WATERFALL_HISTORY_ROWS     512
+#define WATERFALL_HEIGHT_FRACTION  0.4
+#define WATERFALL_GAP              44
+#define WATERFALL_MAX_PENDING_ROWS 64
+
 #define PEAK_HOLD_SEC         0.75
 #define PEAK_DECAY_DB_PER_SEC 1.5
 #define EPSILON_POWER         1e-12
@@ -35,19 +61,54 @@
 #define DEFAULT_CALIBRATOR_TARGET_DB_SPL 94.0
 
 #define METER_READOUT_SMOOTH_MS  350.0
+#define METER_BLOCK_SIZE         64 // samples per Fast/Slow meter block (weight table length)
 #define CURSOR_READOUT_SMOOTH_MS 250.0
 
-#define INPUT_SAMPLE_RATE       44100
-#define INPUT_FRAMES_PER_BUFFER 1024
-#define INPUT_NUM_CHANNELS      1
+// Headless --analyze band count (the bar count of the default window width) and its limit
+#define OFFLINE_DEFAULT_BANDS 145
+#define OFFLINE_MAX_BANDS     4096
+
+// --analyze --threads: longest segment per worker, warm-up ahead of each segment (HPF and
+// smoothing; exponential averaging then runs this many time constants more), thread cap
+#define OFFLINE_SEGMENT_SECONDS       240.0
+#define OFFLINE_WARMUP_SECONDS        4.0
+#define OFFLINE_WARMUP_TIME_CONSTANTS 12
+#define OFFLINE_MAX_THREADS           256
+
+// WAV files are memory-mapped: read-ahead along the analysis cursor and the drop-behind
+// distance both work in chunks of this size (a multiple of the page size)
+#define WAV_READAHEAD_BYTES (4u * 1024u * 1024u)
+
+#define INPUT_SAMPLE_RATE                   44100
+#define INPUT_FRAMES_PER_BUFFER             1024
+#define INPUT_MAX_FRAMES_PER_BUFFER         8192
+#define INPUT_LOW_LATENCY_FRAMES_PER_BUFFER 128 // --low-latency default for --frames-per-buffer
+#define INPUT_NUM_CHANNELS                  1   // default for --channels
+#define INPUT_MAX_CHANNELS                  64
+#define INPUT_MAX_DEVICES                   8 // --mic given several times: one pane each
+#define APP_PANE_MAX_ROWS                   3 // panes stack in one column up to this, then split into two
 
 // Audio output buffering (raylib/miniaudio). Larger buffers reduce underruns under debugger.
 #define AUDIO_STREAM_BUFFER_SAMPLES 16384
 
-// Playback-mode FFT budget per frame (limits CPU bursts that can starve audio updates).
+// Playback-mode FFT budget per analysis update with --time-locked (limits CPU bursts that can
+// starve audio updates); older pending hops are skipped.
 #define MAX_PLAYBACK_WINDOWS_PER_FRAME 1
 
-// Limit analyser updates in file-playback mode to reduce debugger-induced CPU spikes.
-#define PLAYBACK_ANALYSIS_FPS 15.0
+// Analysis thread update rate (file and mic mode). Each update publishes a frame that the
+// render loop picks up without waiting, so this no longer competes with audio refills.
+#define ANALYSIS_UPDATE_HZ 60.0
+
+// --low-latency: the capture callback wakes the analysis thread as soon as a hop is complete.
+// Without a wake-up for this long (freeze, stalled device) the thread updates anyway.
+#define ANALYSIS_WAKE_TIMEOUT_MS 50
+
+// Mic mode latency readout: percentiles over the newest LATENCY_WINDOW hops / drawn frames,
+// refreshed on screen and appended to --latency-log every LATENCY_REPORT_SECONDS
+#define LATENCY_WINDOW         1024
+#define LATENCY_REPORT_SECONDS 0.5
+
+// Stage timing: the profiler panel (I) and --perf-log show min/p50/p99/max over this interval
+#define PERF_REPORT_SECONDS 1.0
 
 #endif // CONFIG_H
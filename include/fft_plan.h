@@ -0,0 +1,102 @@
+#ifndef FFT_PLAN_H
+#define FFT_PLAN_H
+
+#include "redefines.h"
+
+#include <fftw3.h>
+
+// Analysis chain precision (windowing, HPF, FFT, bin power, band mapping).
+// Build with PRECISION=single to run it in f32 on fftwf; display state stays f64.
+#ifdef SPECTRUM_SINGLE_PRECISION
+typedef f32 spectrum_real_t;
+typedef fftwf_complex spectrum_complex_t;
+typedef fftwf_plan spectrum_fft_plan_t;
+#define SPECTRUM_FFTW(name)      fftwf_##name
+#define SPECTRUM_PRECISION_LABEL "f32"
+#else
+typedef f64 spectrum_real_t;
+typedef fftw_complex spectrum_complex_t;
+typedef fftw_plan spectrum_fft_plan_t;
+#define SPECTRUM_FFTW(name)      fftw_##name
+#define SPECTRUM_PRECISION_LABEL "f64"
+#endif
+
+#define FFT_PLAN_RIGOR_ESTIMATE   0
+#define FFT_PLAN_RIGOR_MEASURE    1
+#define FFT_PLAN_RIGOR_PATIENT    2
+#define FFT_PLAN_RIGOR_EXHAUSTIVE 3
+#define NUM_FFT_PLAN_RIGORS       4
+
+#define FFT_PLAN_DEFAULT_RIGOR FFT_PLAN_RIGOR_MEASURE
+
+// Sets planner rigor for subsequent plans. With force_replan set, cached wisdom is
+// ignored and overwritten by freshly measured plans.
+void
+fft_plan_configure(i32 rigor, i32 force_replan);
+
+// Parses "estimate" / "measure" / "patient" / "exhaustive". Returns -1 if unknown.
+i32
+fft_plan_rigor_from_name(const char *name);
+
+const char *
+fft_plan_rigor_name(i32 rigor);
+
+#define FFT_PLAN_CACHE_CAPACITY 128
+#define FFT_PLAN_QUEUE_CAPACITY 32
+
+// A cached n-point r2c plan (batch contiguous transforms) with the Hann window table for n.
+// Plans are created once on scratch arrays and executed on caller buffers via new-array
+// execute, so any fftw_malloc-aligned buffer of the right size can be used with them.
+// A size/batch can be cached twice: a quick FFTW_ESTIMATE plan and its measured upgrade.
+typedef struct
+{
+    i32 size;
+    i32 batch;
+    i32 rigor; // FFT_PLAN_RIGOR_*
+    i32 owns_window;
+    spectrum_fft_plan_t plan;
+    spectrum_real_t *window;
+} fft_plan_entry_t;
+
+// Returns the cached plan for an n-point r2c, planning it on first use with the configured
+// rigor (which can take seconds for large n). Wisdom is loaded from and saved to
+// $XDG_CACHE_HOME/c_fft_visualizer, keyed by size, precision and CPU. Returns NULL on failure.
+const fft_plan_entry_t *
+fft_plan_get(i32 n);
+
+// Same as fft_plan_get() for howmany transforms laid out back to back: inputs n apart,
+// outputs n/2+1 apart (fftw_plan_many_dft_r2c).
+//
+// Both are safe to call from any thread; cached entries stay valid until
+// fft_plan_cache_destroy() and may be executed concurrently on different buffers.
+const fft_plan_entry_t *
+fft_plan_get_batch(i32 n, i32 howmany);
+
+// A usable plan without measuring: the best cached one, one rebuilt from saved wisdom, or an
+// FFTW_ESTIMATE plan. Anything below the configured rigor is queued for the background
+// planner, and fft_plan_find_batch() returns the upgrade once it is ready. May wait for the
+// planner to finish the plan it is working on.
+const fft_plan_entry_t *
+fft_plan_get_batch_fast(i32 n, i32 howmany);
+
+// Best plan cached so far for (n, howmany), or NULL. Never plans and never takes a lock.
+const fft_plan_entry_t *
+fft_plan_find_batch(i32 n, i32 howmany);
+
+// Queues batches 1, 2, 4 .. max_batch of n for the background planner
+void
+fft_plan_prefetch(i32 n, i32 max_batch);
+
+// Serializes planner calls made outside the cache (plan creation and destruction)
+void
+fft_plan_lock(void);
+
+void
+fft_plan_unlock(void);
+
+// Stops the background planner (after the plan in progress) and destroys every cached plan
+// and window table.
+void
+fft_plan_cache_destroy(void);
+
+#endif // FFT_PLAN_H
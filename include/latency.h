@@ -0,0 +1,72 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "redefines.h"
+#include "config.h"
+
+#define LATENCY_STAMP_SLOTS      1024 // power of two; ~2.7 s of 128-frame blocks at 48 kHz
+#define LATENCY_STAMP_CACHE_LINE 64
+
+// ADC time of the first frame of one captured block, and where that frame sits in the
+// sequence of frames the capture ring accepted
+typedef struct
+{
+    u64 frame;
+    f64 adc_time; // PortAudio stream time (seconds)
+} latency_stamp_t;
+
+// Block stamps travelling alongside the capture ring: one producer (the audio callback) and
+// one consumer (the analysis thread), wait-free in the same way as spsc_ring_t. A full queue
+// drops the new stamp; lookups then extrapolate from the last stamp at the stream rate,
+// which is exact for contiguous blocks.
+typedef struct
+{
+    latency_stamp_t slots[LATENCY_STAMP_SLOTS];
+    u64 write; // stamps pushed so far (producer)
+    u8 pad_write[LATENCY_STAMP_CACHE_LINE - sizeof(u64)];
+    u64 read; // stamps released so far (consumer)
+    u8 pad_read[LATENCY_STAMP_CACHE_LINE - sizeof(u64)];
+
+    latency_stamp_t last; // consumer: newest stamp at or before the previous lookup
+    i32 have_last;
+} latency_stamps_t;
+
+// Producer: stamps the block starting at `frame`; never blocks
+void
+latency_stamps_push(latency_stamps_t *q, u64 frame, f64 adc_time);
+
+// Consumer: ADC time of `frame` from the newest stamp at or before it, releasing the stamps
+// older than that. Frames must be looked up in increasing order. Returns 0 while no stamp
+// covers the frame yet.
+i32
+latency_stamps_lookup(latency_stamps_t *q, u64 frame, f64 sample_rate, f64 *adc_time);
+
+// Latency samples (seconds) of the newest LATENCY_WINDOW events; one thread only
+typedef struct
+{
+    f64 samples[LATENCY_WINDOW];
+    f64 sorted[LATENCY_WINDOW];
+    i32 count;
+    i32 pos;
+    i64 total; // samples recorded since start
+} latency_stats_t;
+
+void
+latency_stats_add(latency_stats_t *st, f64 seconds);
+
+// Nearest-rank median and 99th percentile over the window. Returns 0 with no samples yet.
+i32
+latency_stats_percentiles(latency_stats_t *st, f64 *p50, f64 *p99);
+
+// One source's figures as the overlay and --latency-log show them, in milliseconds
+typedef struct
+{
+    f64 hop_p50_ms; // capture -> hop analyzed
+    f64 hop_p99_ms;
+    f64 display_p50_ms; // capture -> frame on screen
+    f64 display_p99_ms;
+    i64 hops;
+    i64 frames;
+} latency_report_t;
+
+#endif // LATENCY_H
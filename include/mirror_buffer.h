@@ -0,0 +1,33 @@
+#ifndef MIRROR_BUFFER_H
+#define MIRROR_BUFFER_H
+
+#include "redefines.h"
+
+// Ring storage mapped twice back to back: byte data[bytes + i] is data[i], so any span of up
+// to `bytes` starting inside the first copy is contiguous and a ring never has to wrap or
+// shift. Built from one memfd mapped at both halves of a reserved range; `bytes` is rounded
+// up to the page size. Where that is unavailable it falls back to a plain 2 * bytes block
+// (mirrored = 0) and mirror_buffer_sync copies writes to the second half instead.
+typedef struct
+{
+    u8 *data;     // 2 * bytes visible
+    usize bytes;  // one copy
+    i32 mirrored; // 1 = second half aliases the first
+} mirror_buffer_t;
+
+// Allocates at least min_bytes per copy, zeroed. Returns 0 if even the fallback fails.
+i32
+mirror_buffer_init(mirror_buffer_t *m, usize min_bytes);
+
+void
+mirror_buffer_free(mirror_buffer_t *m);
+
+void
+mirror_buffer_clear(mirror_buffer_t *m);
+
+// Makes the second half match after writing len bytes at offset (wrapping) in the first half.
+// Nothing to do when mirrored.
+void
+mirror_buffer_sync(mirror_buffer_t *m, usize offset, usize len);
+
+#endif // MIRROR_BUFFER_H
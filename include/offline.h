@@ -0,0 +1,46 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include "redefines.h"
+
+#define OFFLINE_FORMAT_CSV 0
+#define OFFLINE_FORMAT_BIN 1
+
+typedef struct
+{
+    const char *input_path;
+    const char *output_path;
+    i32 format; // OFFLINE_FORMAT_*, picked from the output extension (.bin = binary, else CSV)
+    i32 fft_size;
+    i32 hop_size;
+    i32 num_bands;
+    i32 fractional_octave_index;
+    i32 average_mode;
+    i32 average_count;
+    f64 average_seconds;
+    i32 threads; // 0 = one per online CPU
+} offline_options_t;
+
+// Runs the file through the same analysis chain as playback (front-end, FFT, band mapping,
+// averaging and smoothing), one hop after another as fast as possible, with no window, audio
+// device or font. Writes one row of band levels (dB) per bar update, then the max-hold trace
+// and the power-average of all rows.
+//
+// CSV: "time_s,<band Hz>..." header, one "t,<dB>..." row per update, then "max,..." and "mean,...".
+// Binary (little endian on any host):
+//     char magic[8] = "CFFTBAND", u32 version = 1, u32 num_bands, u32 num_rows, u32 sample_rate,
+//     u32 fft_size, u32 hop_size, f64 band_hz[num_bands],
+//     num_rows x { f64 time_s, f32 db[num_bands] }, f32 max_db[num_bands], f32 mean_db[num_bands]
+// time_s is the end of the newest window in the update.
+//
+// With more than one thread the hops are split into contiguous segments analyzed in parallel,
+// each by its own analyser that starts OFFLINE_WARMUP_SECONDS early (plus
+// OFFLINE_WARMUP_TIME_CONSTANTS for exponential averaging) so the HPF and smoothing have
+// settled when its rows begin. The rows are stitched in order. Segments whose warm-up reaches
+// the file start replay it and match the serial run exactly; later ones keep the residual of
+// the warm-up, within 1e-3 dB. Linear and Leq averaging depend on the whole history and always
+// run serially. Returns 0 on success.
+i32
+offline_analyze(const offline_options_t *opt);
+
+#endif // OFFLINE_H
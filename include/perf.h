@@ -0,0 +1,54 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "redefines.h"
+
+// Timed stages of the hot path
+#define PERF_STAGE_PREPROCESS     0 // front-end: downmix, filters, window (per FFT window)
+#define PERF_STAGE_FFT            1 // one batched r2c transform
+#define PERF_STAGE_BAR_TARGETS    2 // bins -> bars
+#define PERF_STAGE_SMOOTH         3 // bar smoothing, peaks and max-hold
+#define PERF_STAGE_RENDER_TEXTURE 4 // spectrum_view_render_to_texture
+#define PERF_STAGE_RENDER_DRAW    5 // render_draw
+#define PERF_STAGE_MUSIC          6 // UpdateMusicStream
+#define PERF_STAGE_FRAME          7 // one whole render loop iteration
+#define NUM_PERF_STAGES           8
+
+// Histogram bins: 4 per octave of nanoseconds, so about 19% wide; the last one ends at ~8.6 s
+#define PERF_BINS 128
+
+// Per-stage duration histograms shared by every thread. Recording is lock-free: the bins are
+// cumulative atomic counters and min/max atomic extremes, so the analysis threads and the
+// render loop never wait on each other or on the reader. One reader takes snapshots; each
+// covers what was recorded since the previous one (a rolling window of the report interval).
+typedef struct
+{
+    u64 count;
+    f64 min_us;
+    f64 p50_us;
+    f64 p99_us;
+    f64 max_us;
+} perf_stage_report_t;
+
+typedef struct
+{
+    perf_stage_report_t stages[NUM_PERF_STAGES];
+} perf_report_t;
+
+// Monotonic clock in nanoseconds
+u64
+perf_now(void);
+
+// Records the time from start_ns (a perf_now() reading) to now against stage
+void
+perf_record(i32 stage, u64 start_ns);
+
+// Reader (one thread only): min/p50/p99/max of what was recorded since the previous snapshot.
+// Percentiles are the middle of their histogram bin; min and max are exact.
+void
+perf_snapshot(perf_report_t *r);
+
+const char *
+perf_stage_label(i32 stage);
+
+#endif // PERF_H
@@ -3,8 +3,20 @@
 
 #include "redefines.h"
 #include "spectrum.h"
+#include "spectrum_view.h"
+#include "latency.h"
+#include "perf.h"
 
+// Draws v's pane from frame alone, so it runs unlocked while the analysis continues.
+// latency: capture-to-display figures shown under the meters (mic mode), NULL for none
 void
-render_draw(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index, i32 show_paused_overlay);
+render_draw(
+    const spectrum_view_t *v, const spectrum_frame_t *frame, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index,
+    i32 show_paused_overlay, const latency_report_t *latency
+);
+
+// Stage timing table (profiler panel, I) in the top-left of v's pane
+void
+render_draw_profiler(const spectrum_view_t *v, const perf_report_t *r);
 
 #endif // RENDER_H
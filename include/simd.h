@@ -0,0 +1,47 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "redefines.h"
+#include "fft_plan.h"
+
+// Instruction sets the analysis kernels are built for; the best one the CPU supports is
+// picked at startup (x86 only, everything else runs the scalar kernels)
+#define SIMD_ISA_SCALAR 0
+#define SIMD_ISA_SSE2   1
+#define SIMD_ISA_AVX2   2
+#define SIMD_ISA_AVX512 3
+#define NUM_SIMD_ISAS   4
+
+typedef struct
+{
+    i32 isa;
+
+    // mono[i] = 0.5 * (src[2i] + src[2i + 1])
+    void (*downmix_stereo)(const f32 *src, f32 *mono, i32 frames);
+
+    // dst[c * stride + i] = src[i * channels + c]; vectorized for 2, 4 and 8 channels
+    void (*deinterleave)(const f32 *src, i32 channels, f32 *dst, i32 stride, i32 frames);
+
+    // dst[i] = src[i] * window[i]; dst may alias src
+    void (*multiply)(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count);
+
+    // dst[i] = (re^2 + im^2) * scale over interleaved complex values (fftw_complex layout)
+    void (*power)(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale);
+} simd_kernels_t;
+
+// Selects the kernels for this CPU. Safe to call more than once and from any thread.
+void
+simd_init(void);
+
+const simd_kernels_t *
+simd_kernels(void);
+
+const char *
+simd_isa_name(i32 isa);
+
+// Checks every kernel the CPU can run against the scalar reference and prints the results.
+// Returns 1 if all kernels agree.
+i32
+simd_self_test(void);
+
+#endif // SIMD_H
@@ -3,9 +3,14 @@
 
 #include "redefines.h"
 
-#include <raylib.h>
-#include <fftw3.h>
+#include <stdbool.h>
 #include "config.h"
+#include "fft_plan.h"
+#include "zoom.h"
+#include "average.h"
+#include "wav_reader.h"
+#include "mirror_buffer.h"
+#include "channel_views.h"
 
 #define FRACTIONAL_OCTAVE_1_1  1
 #define FRACTIONAL_OCTAVE_1_3  (1.0 / 3.0)
@@ -14,8 +19,10 @@
 #define FRACTIONAL_OCTAVE_1_24 (1.0 / 24.0)
 #define FRACTIONAL_OCTAVE_1_48 (1.0 / 48.0)
 
-#define NUM_FRACTIONAL_OCTAVES 6
-#define NUM_BAR_GRADIENTS      7
+#define NUM_FRACTIONAL_OCTAVES    6
+#define NUM_FFT_SIZE_PRESETS      5
+#define NUM_HOP_DIVISOR_PRESETS   4
+#define NUM_AVERAGE_COUNT_PRESETS 6
 
 #define FREQ_WEIGHTING_Z         0
 #define FREQ_WEIGHTING_A         1
@@ -28,23 +35,71 @@
 #define NUM_TIME_WEIGHTING_MODES 3
 
 extern const f64 FRACTIONAL_OCTAVES[NUM_FRACTIONAL_OCTAVES];
-
+extern const i32 FFT_SIZE_PRESETS[NUM_FFT_SIZE_PRESETS];
+extern const i32 HOP_DIVISOR_PRESETS[NUM_HOP_DIVISOR_PRESETS];
+extern const i32 AVERAGE_COUNT_PRESETS[NUM_AVERAGE_COUNT_PRESETS];
+
+// Fast/Slow/Impulse level meter fed once per input sample. Fast and Slow are one-pole
+// averages of x^2 and |x|, evaluated a block at a time as
+//     y_B = d^B * y_0 + sum_i (1 - d) * d^(B-1-i) * x_i
+// with the weights precomputed per mode; a shorter block L uses the last L weights.
+// Impulse keeps the per-sample recursion with a branch-free attack/release select.
 typedef struct
 {
-    Color bottom;
-    Color top;
-} bar_gradient_t;
-
-typedef struct
+    i32 mode;
+    f64 sample_rate;
+    f64 decay_pow[METER_BLOCK_SIZE + 1]; // d^L
+    f64 block_weight[METER_BLOCK_SIZE];  // (1 - d) * d^(B-1-i)
+    f64 alpha_attack;
+    f64 alpha_release;
+
+    f64 rms_sq;
+    f64 peak_lin;
+    i64 pending; // samples since the last readout
+} meter_state_t;
+
+typedef struct spectrum_state spectrum_state_t;
+
+// Called after every bar update driven by the analysis (once per hop, or once per step with
+// bin averaging), with bar_smoothed/peak_power/max_hold_power current
+typedef void (*spectrum_bars_fn)(spectrum_state_t *s, void *user);
+
+// The analysis engine: front-end, FFT, band mapping, smoothing, peaks and meters. Nothing here
+// touches a window, GPU or audio device; the screen side lives in spectrum_view_t.
+struct spectrum_state
 {
-    i32 bar_gradient_index;
-    bar_gradient_t bar_gradients[NUM_BAR_GRADIENTS];
-
-    f64 fft_in[FFT_WINDOW_SIZE];
-    fftw_complex fft_out[(FFT_WINDOW_SIZE / 2) + 1];
-    fftw_plan fft_plan;
+    // Analysis buffers are fftw_malloc-aligned and sized for fft_size; the plan and
+    // window table are shared per size through the fft_plan cache.
+    i32 fft_size;
+    spectrum_real_t *fft_in;
+    spectrum_complex_t *fft_out;
+    const fft_plan_entry_t *fft_plan;
+    const spectrum_real_t *window;
     i32 fft_bins;
-    f64 bin_mag[(FFT_WINDOW_SIZE / 2) + 1];
+    spectrum_real_t *bin_power;
+    f32 *mono_buf; // downmix scratch for the frames fed in one step (<= fft_size)
+
+    // Streaming front-end: every input frame is downmixed and high-passed once into a
+    // mirrored ring, so the newest fft_size samples are always contiguous ending at
+    // history + history_pos + history_size and a window is just a multiply over that view.
+    mirror_buffer_t history_buf;
+    spectrum_real_t *history; // history_buf.data: 2 * history_size
+    i32 history_size;         // >= fft_size (page-rounded when mirrored)
+    i32 history_pos;          // next write
+    i64 stream_pos;           // next input frame to consume; -1 = resync before the next window
+    i32 hpf_primed;
+
+    zoom_state_t zoom; // fed from the front-end while enabled
+
+    // Bin-domain averaging; while enabled the bars are mapped from the averaged bins once per
+    // step and the per-bar smoothing is bypassed
+    spectral_average_t average;
+    f64 average_seconds; // > 0: the averaging length is a time span and follows the hop
+
+    // Per-channel views; input_channels is the channel count of the live frames (files carry
+    // their own). Buffers are (re)built on the first analysis step after a size change.
+    i32 input_channels;
+    channel_views_t channels;
 
     i32 num_bars;
     i32 sample_rate;
@@ -56,6 +111,20 @@ typedef struct
 
     f64 *peak_hold_timer;
 
+    // Sparse band-to-bin weight matrix (CSR). Weights fold in the fractional bin edges,
+    // frequency weighting and pinking, so a band is a dot product over bin_power.
+    i32 *band_row_start; // num_bars + 1 offsets into band_bin_index / band_bin_weight
+    i32 *band_bin_index;
+    spectrum_real_t *band_bin_weight;
+    i32 band_nnz_capacity;
+    i32 band_map_valid;
+    i32 band_map_num_bars;
+    i32 band_map_sample_rate;
+    i32 band_map_fft_bins;
+    i32 band_map_weighting_mode;
+    bool band_map_pinking;
+    f64 band_map_fractional_octave;
+
     bool pinking_enabled;
     i32 db_smoothing_enabled;
     f64 smooth_attack_ms;
@@ -76,27 +145,19 @@ typedef struct
     f64 accumulator;
 
     i32 hop_size;
-    f64 window[FFT_WINDOW_SIZE];
-    f64 hpf_alpha;
-    f64 hpf_prev_x;
-    f64 hpf_prev_y;
+    spectrum_real_t hpf_alpha;
+    spectrum_real_t hpf_prev_x;
+    spectrum_real_t hpf_prev_y;
 
     i32 window_index;
     i32 total_windows;
-    Texture2D gradient_tex;
-    RenderTexture2D fft_rt;
-    i32 last_width;
-    i32 last_height;
-    i32 plot_left;
-    i32 plot_top;
-    i32 plot_width;
-    i32 plot_height;
-    Font font;
-
-    f64 meter_interval_elapsed;
-    f64 meter_sum_sq;
-    f64 meter_peak_lin;
-    i32 meter_sample_count;
+
+    // spectrum_push_frames: frames of an unfinished hop (input_channels interleaved)
+    f32 *push_buf;
+    i32 push_capacity; // samples
+    i32 push_fill;     // frames
+
+    meter_state_t meter;
     f64 meter_rms_dbfs;
     f64 meter_peak_dbfs;
     f64 meter_rms_dbspl;
@@ -114,25 +175,119 @@ typedef struct
     f64 calibrator_target_db_spl;
     i32 spl_calibrated;
 
-    f64 meter_rms_sq_tw;
-    f64 meter_peak_lin_tw;
-    f64 meter_tw_alpha_fastslow;
-    f64 meter_tw_alpha_attack;
-    f64 meter_tw_alpha_release;
-} spectrum_state_t;
+    spectrum_bars_fn on_bars;
+    void *on_bars_user;
+    i32 bars_window; // newest window reflected in the bars at the last update
+};
+
+// What the renderer shows from one analysis update: everything it reads from the analyser,
+// copied out under the analysis lock so rendering never touches the live state (see app_run).
+// Bars are only drawn while num_bars matches the current layout.
+typedef struct
+{
+    i32 num_bars;
+    i32 capacity;
+    f64 *bar_smoothed;
+    f64 *peak_power;
+    f64 *max_hold_power;
+    f64 *bar_freq_center;
+
+    // Settings shown in the overlay
+    i32 sample_rate;
+    i32 fft_size;
+    i32 hop_size;
+    f64 fractional_octave;
+    f64 f_min;
+    f64 f_max;
+    f64 peak_hold_seconds;
+    f64 seconds_per_window;
+    i32 db_smoothing_enabled;
+    f64 smooth_attack_ms; // of the active (dB or linear) bar smoothing
+    f64 smooth_release_ms;
+    bool pinking_enabled;
+    i32 frequency_weighting_mode;
+    i32 time_weighting_mode;
+    i32 spl_features_enabled;
+    i32 spl_calibrated;
+
+    f64 meter_rms_dbfs_display;
+    f64 meter_peak_dbfs_display;
+    f64 meter_rms_dbspl_display;
+    f64 meter_peak_dbspl_display;
+
+    i32 average_mode;
+    i32 average_target;
+    i64 average_count;
+    f64 average_enbw_hz; // noise bandwidth of the analysis window
+
+    // Zoom-FFT tuning, power (ZOOM_FFT_SIZE bins, allocated on first use) and progress
+    i32 zoom_enabled;
+    f64 zoom_center_hz;
+    f64 zoom_bin_hz;
+    f64 zoom_span_hz;
+    f64 *zoom_power;
+    i32 zoom_spectra;
+    i32 zoom_filled;
+
+    // Per-channel bars: channel_views rows of num_bars (0 rows while the layout is off)
+    i32 channel_layout;
+    i32 channel_views;
+    i32 channel_capacity;
+    f64 *channel_bars;
+    char channel_labels[CHANNEL_VIEW_MAX][16];
+
+    // Set by the caller after capture (mic mode): stream time the newest analyzed sample was
+    // captured at, 0 = unknown
+    f64 input_time;
+} spectrum_frame_t;
+
+// Latest meter readings (NAN before the first analyzed samples)
+typedef struct
+{
+    f64 rms_dbfs;
+    f64 peak_dbfs;
+    f64 rms_dbspl;
+    f64 peak_dbspl;
+} spectrum_meters_t;
 
 void
-spectrum_set_fractional_octave(spectrum_state_t *s, f64 frac, i32 index);
+meter_init(meter_state_t *m, f64 sample_rate, i32 mode);
+
+// Switches Fast/Slow/Impulse, keeping the current levels
+void
+meter_set_mode(meter_state_t *m, i32 mode);
 
-Texture2D
-create_gradient_texture(i32 height, bar_gradient_t grad);
+void
+meter_process(meter_state_t *m, const f32 *samples, i32 count);
 
 void
-spectrum_init(spectrum_state_t *s, Wave *wave, Font font);
+spectrum_set_fractional_octave(spectrum_state_t *s, f64 frac, i32 index);
+
+// Analyser for sample_rate input with num_bars log-spaced bands from 20 Hz to
+// min(20 kHz, Nyquist). Returns 0 on failure (spectrum_destroy is still safe to call).
+i32
+spectrum_init(spectrum_state_t *s, i32 sample_rate, i32 fft_size, i32 hop_size, i32 num_bars);
+
+// Changes the band count (at least 2), carrying each band's levels over from the nearest old
+// band. Returns 0 if allocation fails; the old bands stay then.
+i32
+spectrum_set_num_bars(spectrum_state_t *s, i32 num_bars);
 
 void
 spectrum_destroy(spectrum_state_t *s);
 
+// Switches FFT size and hop. The file playback position is kept (converted to the new
+// hop) and total_windows is left to the caller (see spectrum_windows_for_frames).
+// Returns 0 if the size is unsupported or allocation/planning fails; state is unchanged then.
+i32
+spectrum_set_fft_size(spectrum_state_t *s, i32 fft_size, i32 hop_size);
+
+i32
+spectrum_is_valid_fft_size(i32 fft_size);
+
+i32
+spectrum_windows_for_frames(const spectrum_state_t *s, ul frames);
+
 void
 spectrum_set_total_windows(spectrum_state_t *s, i32 total);
 
@@ -140,13 +295,51 @@ i32
 spectrum_done(const spectrum_state_t *s);
 
 void
-spectrum_handle_resize(spectrum_state_t *s);
+spectrum_update(spectrum_state_t *s, const wav_reader_t *file, f64 dt);
+
+// Time-locked file analysis: analyzes up to max_windows of the newest windows that end at or
+// before the playhead, skipping any older pending hops, so the cost per call is bounded and
+// the bars never trail the audio
+void
+spectrum_update_at(spectrum_state_t *s, const wav_reader_t *file, f64 playback_seconds, i32 max_windows, f64 dt);
+
+// Analyzes the next `windows` file windows (fewer at the end of the file) without pacing, with
+// each hop advancing the smoothing by its own duration
+void
+spectrum_analyze_windows(spectrum_state_t *s, const wav_reader_t *file, i32 windows);
+
+// Streams windows * hop_size new frames (input_channels interleaved) from `samples` through the
+// front-end, analyzing a window after every hop, and advances smoothing, peaks and meters by dt.
+// Used by the live input path; the history ring carries the earlier samples between calls.
+void
+spectrum_update_windows(spectrum_state_t *s, const f32 *samples, i32 windows, f64 dt);
+
+// Streams count frames (input_channels interleaved) of any length: a window is analyzed after
+// every completed hop and the smoothing advances by the hop duration. Frames of an unfinished
+// hop are held for the next call. Returns 0 if the hold buffer cannot grow.
+i32
+spectrum_push_frames(spectrum_state_t *s, const f32 *frames, i32 count);
+
+// Copies up to capacity bands: center frequency and smoothed level in dB, as the bars show
+// them. Either array may be NULL. Returns the band count.
+i32
+spectrum_read_bands(const spectrum_state_t *s, f64 *freq_hz, f64 *level_db, i32 capacity);
+
+// Copies up to capacity bins of the newest window's power spectrum (fft_size / 2 + 1 bins,
+// linear, single-sided). Returns the bin count.
+i32
+spectrum_read_bins(const spectrum_state_t *s, f64 *power, i32 capacity);
 
 void
-spectrum_update(spectrum_state_t *s, Wave *wave, f32 *samples, f64 dt);
+spectrum_read_meters(const spectrum_state_t *s, spectrum_meters_t *m);
+
+// Copies the current analysis results into f. Returns 0 if its buffers cannot grow (f keeps
+// its previous contents then).
+i32
+spectrum_frame_capture(spectrum_frame_t *f, const spectrum_state_t *s);
 
 void
-spectrum_render_to_texture(spectrum_state_t *s);
+spectrum_frame_free(spectrum_frame_t *f);
 
 void
 spectrum_set_peak_hold_seconds(spectrum_state_t *s, f64 seconds);
@@ -163,4 +356,33 @@ spectrum_cycle_time_weighting(spectrum_state_t *s);
 void
 spectrum_calibrate_spl(spectrum_state_t *s, f64 target_db_spl);
 
+// Averaging mode (AVERAGE_*) and length, as a hop count or a time span. Each restarts the average.
+void
+spectrum_set_average_mode(spectrum_state_t *s, i32 mode);
+
+void
+spectrum_set_average_count(spectrum_state_t *s, i32 count);
+
+void
+spectrum_set_average_seconds(spectrum_state_t *s, f64 seconds);
+
+// Power per Hz in bar b of f for its bar power, in the bar scale (a full-scale sine reads 0 dB)
+// with the frequency weighting applied but not the pinking: the mean bin power over the
+// window's noise bandwidth
+f64
+spectrum_frame_bar_density(const spectrum_frame_t *f, i32 b, f64 bar_power);
+
+// Enables the zoom-FFT around center_hz (retuning restarts its history) or disables it.
+// Returns 0 if the zoom buffers cannot be allocated.
+i32
+spectrum_set_zoom(spectrum_state_t *s, i32 enabled, f64 center_hz);
+
+// Channel count of the frames the analysis is fed (the file's, or the live input's)
+void
+spectrum_set_input_channels(spectrum_state_t *s, i32 channels);
+
+// Selects how the per-channel spectra are shown (CHANNEL_LAYOUT_*); off stops analyzing them
+void
+spectrum_set_channel_layout(spectrum_state_t *s, i32 layout);
+
 #endif // SPECTRUM_H
@@ -0,0 +1,23 @@
+#ifndef SPECTRUM_LOG_H
+#define SPECTRUM_LOG_H
+
+#include "redefines.h"
+
+#define SPECTRUM_LOG_INFO    0
+#define SPECTRUM_LOG_WARNING 1
+#define SPECTRUM_LOG_ERROR   2
+
+// message is one line without the trailing newline
+typedef void (*spectrum_log_fn)(i32 level, const char *message, void *user);
+
+// Routes the library's diagnostics (size fallbacks, FFTW planning and wisdom, file errors) to
+// fn. Nothing is printed by default, so a program embedding the library keeps its stdout and
+// stderr to itself. Set it before creating an analyser: the plan worker thread logs too.
+void
+spectrum_set_log(spectrum_log_fn fn, void *user);
+
+// Formats a message for the installed callback; a no-op without one
+void
+spectrum_log(i32 level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // SPECTRUM_LOG_H
@@ -0,0 +1,88 @@
+#ifndef SPECTRUM_VIEW_H
+#define SPECTRUM_VIEW_H
+
+#include "redefines.h"
+
+#include <raylib.h>
+#include "config.h"
+#include "spectrum.h"
+#include "waterfall.h"
+
+#define NUM_BAR_GRADIENTS 7
+
+typedef struct
+{
+    Color bottom;
+    Color top;
+} bar_gradient_t;
+
+// Screen side of one analyser: the pane it is laid out in, the bar texture and waterfall.
+// The analyser's bar count follows the plot width (one bar per BAR_PIXEL_WIDTH + BAR_GAP),
+// set through spectrum_set_num_bars on every layout change.
+typedef struct
+{
+    i32 bar_gradient_index;
+    bar_gradient_t bar_gradients[NUM_BAR_GRADIENTS];
+
+    Texture2D gradient_tex;
+    RenderTexture2D fft_rt;
+    // Screen area to lay out in ({0} = the whole window) and the area the plot rect and
+    // textures were last built for
+    Rectangle viewport;
+    i32 layout_x;
+    i32 layout_y;
+    i32 layout_width;
+    i32 layout_height;
+    i32 plot_left;
+    i32 plot_top;
+    i32 plot_width;
+    i32 plot_height;
+    i32 num_bars; // bars the plot holds
+    Font font;
+
+    // One row per bar update while enabled (pushed from the analyser's on_bars); drawn below
+    // the bars at waterfall_top
+    waterfall_t waterfall;
+    i32 waterfall_top;
+    i32 waterfall_height;
+} spectrum_view_t;
+
+Texture2D
+create_gradient_texture(i32 height, bar_gradient_t grad);
+
+// Lays v out over the whole window and sizes the bars of s (initialized) to fit. Takes s's
+// on_bars for the waterfall; v must stay at the same address while s is analyzed.
+void
+spectrum_view_init(spectrum_view_t *v, spectrum_state_t *s, Font font);
+
+void
+spectrum_view_destroy(spectrum_view_t *v);
+
+// True once the viewport (or the window, without one) differs from the current layout
+// (spectrum_view_handle_resize pending)
+i32
+spectrum_view_resize_pending(const spectrum_view_t *v);
+
+// Lays the plot out in r ({0} for the whole window) on the next spectrum_view_handle_resize
+void
+spectrum_view_set_viewport(spectrum_view_t *v, Rectangle r);
+
+// Rebuilds the layout and textures for a new viewport and resizes the bars of s to match
+void
+spectrum_view_handle_resize(spectrum_view_t *v, spectrum_state_t *s);
+
+// Cycles the bar color gradient
+void
+spectrum_view_cycle_gradient(spectrum_view_t *v);
+
+// Draws the bars, peaks and max-hold of f (skipped if f is from another bar layout) and
+// uploads the pending waterfall rows
+void
+spectrum_view_render_to_texture(spectrum_view_t *v, const spectrum_frame_t *f);
+
+// Shows or hides the waterfall below the bars (the bar plot shrinks to make room).
+// Returns 0 if the waterfall texture cannot be created.
+i32
+spectrum_view_set_waterfall(spectrum_view_t *v, spectrum_state_t *s, i32 enabled);
+
+#endif // SPECTRUM_VIEW_H
@@ -0,0 +1,48 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "redefines.h"
+
+#define SPSC_RING_CACHE_LINE 64
+
+// Wait-free sample ring for exactly one producer thread and one consumer thread. Each side
+// owns one free-running counter and publishes it with release ordering after copying, so
+// neither ever blocks the other (the producer may be a real-time audio callback). The
+// capacity is a power of two: positions are counters masked to the buffer, and a copy that
+// crosses the end is two memcpy spans. The counters sit on separate cache lines.
+typedef struct
+{
+    f32 *data;
+    ul capacity; // samples, power of two
+    ul mask;
+
+    ul write; // samples pushed so far (producer)
+    u8 pad_write[SPSC_RING_CACHE_LINE - sizeof(ul)];
+    ul read; // samples popped so far (consumer)
+    u8 pad_read[SPSC_RING_CACHE_LINE - sizeof(ul)];
+} spsc_ring_t;
+
+// Allocates at least min_capacity samples (rounded up to a power of two). Returns 0 on failure.
+i32
+spsc_ring_init(spsc_ring_t *r, ul min_capacity);
+
+void
+spsc_ring_destroy(spsc_ring_t *r);
+
+// Producer: copies up to n samples in and returns how many fit; the rest are dropped
+ul
+spsc_ring_push(spsc_ring_t *r, const f32 *src, ul n);
+
+// Consumer: copies up to n of the oldest samples out and returns how many there were
+ul
+spsc_ring_pop(spsc_ring_t *r, f32 *dst, ul n);
+
+// Samples queued; exact for the consumer, a lower bound for free space on the producer side
+ul
+spsc_ring_count(const spsc_ring_t *r);
+
+// Consumer: drops everything queued and returns how many samples that was
+ul
+spsc_ring_discard(spsc_ring_t *r);
+
+#endif // SPSC_RING_H
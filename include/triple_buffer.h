@@ -0,0 +1,29 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include "redefines.h"
+
+// Slot handoff for one writer and one reader sharing three buffers. The writer fills slot
+// `back` and publishes it by swapping it with the shared middle slot; the reader swaps its
+// `front` slot with the middle one only when something new was published. Neither side ever
+// waits: the writer overwrites a frame the reader skipped, and the reader keeps its current
+// frame until a newer one is there. The slots themselves belong to the caller.
+typedef struct
+{
+    i32 back;   // writer only
+    i32 front;  // reader only
+    u32 middle; // shared: slot index, plus TRIPLE_BUFFER_FRESH once published and not yet taken
+} triple_buffer_t;
+
+void
+triple_buffer_init(triple_buffer_t *t);
+
+// Writer: hands slot `back` to the reader and moves on to a free one
+void
+triple_buffer_publish(triple_buffer_t *t);
+
+// Reader: moves `front` to the newest published slot. Returns 0 if nothing new was published.
+i32
+triple_buffer_acquire(triple_buffer_t *t);
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,56 @@
+#ifndef WATERFALL_H
+#define WATERFALL_H
+
+#include <raylib.h>
+
+#include "redefines.h"
+#include "config.h"
+
+// Scrolling spectrogram. The texture itself is the history ring: one column per bar,
+// WATERFALL_HISTORY_ROWS rows, and each new row overwrites the oldest with UpdateTextureRec.
+// The wrap is left to the sampler (repeat) by starting the source rect at the write head,
+// so drawing and uploading cost the same whatever the history length.
+//
+// Rows are pushed by the analysis as they are produced and uploaded by the next render,
+// through a small pending ring so pushing never needs the GL context. The ring is
+// single-producer / single-consumer: the analysis thread may push while the render thread
+// uploads. Resizing must exclude both.
+typedef struct
+{
+    i32 enabled;
+    i32 width; // columns (one per bar); 0 = no texture yet
+    i32 head;  // texture row the next upload lands in
+
+    Texture2D tex;
+    Color *pending;    // WATERFALL_MAX_PENDING_ROWS rows of `width`
+    u32 pending_write; // rows pushed so far (producer)
+    u32 pending_read;  // rows uploaded so far (consumer)
+
+    Color palette[256];
+} waterfall_t;
+
+void
+waterfall_init(waterfall_t *w);
+
+void
+waterfall_destroy(waterfall_t *w);
+
+// Matches the column count to num_bars; a change clears the history. Needs the GL context.
+// Returns 0 if the texture or the pending rows cannot be allocated.
+i32
+waterfall_resize(waterfall_t *w, i32 num_bars);
+
+// Queues one row of bar powers (linear, dB-mapped like the bars). When the renderer falls
+// behind the ring fills and the new row is dropped.
+void
+waterfall_push(waterfall_t *w, const f64 *bar_power, i32 count);
+
+// Uploads the queued rows into the texture ring
+void
+waterfall_upload(waterfall_t *w);
+
+// Draws the history into dst, newest row at the top
+void
+waterfall_draw(const waterfall_t *w, Rectangle dst);
+
+#endif // WATERFALL_H
@@ -0,0 +1,46 @@
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include "redefines.h"
+#include "config.h"
+
+#define WAV_SAMPLE_PCM   0 // unsigned 8-bit, signed 16/24/32-bit
+#define WAV_SAMPLE_FLOAT 1 // IEEE 32/64-bit
+
+// WAV / RF64 file memory-mapped read-only. Nothing is decoded up front: frames are converted
+// to f32 as the analysis asks for them, read-ahead is requested along the cursor and pages
+// well behind it are dropped again, so resident memory stays at a few WAV_READAHEAD_BYTES
+// chunks whatever the file length. Reads do not modify the reader, so several threads can
+// share one.
+typedef struct
+{
+    u8 *map;
+    usize map_size;
+    usize data_offset; // first frame, from the start of the file
+    i64 frame_count;
+    i32 sample_rate;
+    i32 channels;
+    i32 bits;
+    i32 sample_format; // WAV_SAMPLE_*
+    i32 frame_bytes;
+} wav_reader_t;
+
+// Maps the file and parses its header (PCM, IEEE float or WAVE_FORMAT_EXTENSIBLE of either).
+// Returns 0 and prints the reason if the file cannot be opened or is not a supported WAV.
+i32
+wav_reader_open(wav_reader_t *r, const char *path);
+
+void
+wav_reader_close(wav_reader_t *r);
+
+// Converts frames [frame, frame + count) to f32 and writes their mono downmix to dst (mono as
+// is, otherwise the mean of the first two channels). The range must lie inside the file.
+void
+wav_reader_read_mono(const wav_reader_t *r, i64 frame, i32 count, f32 *dst);
+
+// Converts the same range channel by channel: channel c (< channels <= r->channels) goes to
+// dst + c * stride.
+void
+wav_reader_read_planar(const wav_reader_t *r, i64 frame, i32 count, i32 channels, f32 *dst, i32 stride);
+
+#endif // WAV_READER_H
@@ -0,0 +1,72 @@
+#ifndef ZOOM_H
+#define ZOOM_H
+
+#include "redefines.h"
+#include "config.h"
+#include "fft_plan.h"
+
+// Zoom-FFT: the band around center_hz is mixed to baseband with a complex oscillator,
+// low-passed and decimated by ZOOM_DECIMATION, and a ZOOM_FFT_SIZE complex FFT of the
+// decimated stream gives fs / (ZOOM_DECIMATION * ZOOM_FFT_SIZE) Hz bins. The outer half
+// of the decimated band is the FIR transition, so only the middle half is displayed.
+typedef struct
+{
+    i32 enabled;
+    f64 sample_rate;
+    f64 center_hz;
+    f64 bin_hz;
+
+    // Oscillator phasor, rotated by step per input sample
+    f64 osc_re;
+    f64 osc_im;
+    f64 step_re;
+    f64 step_im;
+
+    // Decimating FIR (symmetric, unity DC gain) over a double-written complex delay line;
+    // only every ZOOM_DECIMATION-th output is computed
+    f64 *taps;
+    f64 *delay_re;
+    f64 *delay_im;
+    i32 delay_pos;
+    i32 decim_phase;
+
+    // Decimated baseband history (double-written) and the transform
+    f64 *base_re;
+    f64 *base_im;
+    i32 base_pos;
+    i32 base_filled;
+    i32 base_since_fft;
+    spectrum_real_t *window;
+    spectrum_complex_t *fft_in;
+    spectrum_complex_t *fft_out;
+    spectrum_fft_plan_t plan;
+
+    // Power per bin in the bar scale, ordered low to high: bin k sits at
+    // center_hz + (k - ZOOM_FFT_SIZE / 2) * bin_hz
+    f64 *power;
+    i32 spectra; // spectra computed since the last reset
+} zoom_state_t;
+
+// Returns 0 if allocation or planning fails
+i32
+zoom_init(zoom_state_t *z, f64 sample_rate);
+
+void
+zoom_destroy(zoom_state_t *z);
+
+// Retunes the oscillator and restarts the filter and history
+void
+zoom_set_center(zoom_state_t *z, f64 center_hz);
+
+void
+zoom_reset(zoom_state_t *z);
+
+// Feeds high-passed input samples; computes a new spectrum every ZOOM_HOP decimated samples
+void
+zoom_process(zoom_state_t *z, const spectrum_real_t *samples, i32 count);
+
+// Width of the displayed span (middle half of the decimated band)
+f64
+zoom_display_span_hz(const zoom_state_t *z);
+
+#endif // ZOOM_H
@@ -1,9 +1,16 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "app.h"
 
 #include "render.h"
+#include "simd.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 internal void
 print_usage(const char *prog)
@@ -11,10 +18,33 @@ print_usage(const char *prog)
     fprintf(
         stderr,
         "Usage:      %s <wav-file> [options]\n"
-        "Live Usage: %s --mic\n"
+        "Live Usage: %s --mic [device] [--mic <device> ...]\n"
+        "Offline:    %s --analyze <wav-file> --out <result.csv|result.bin> [options]\n"
         "Options:\n"
-        "  -h, --help       Show this help and exit\n"
-        "  -l, --loop       Loop playback\n"
+        "  -h, --help                Show this help and exit\n"
+        "  -l, --loop                Loop playback\n"
+        "  -m, --mic [device]        Capture a PortAudio input device (default input); repeat for up to %d panes\n"
+        "      --fft-size <n>        FFT size, power of two 1024..65536 (default 8192)\n"
+        "      --hop <n>             Hop size in samples (default fft-size/16)\n"
+        "      --fft-rigor <mode>    FFTW planning: estimate, measure (default), patient, exhaustive\n"
+        "      --replan              Ignore cached FFTW wisdom and measure plans again\n"
+        "      --selftest            Check the SIMD kernels against the scalar reference and exit\n"
+        "      --average <mode>      Bin averaging: off (default), lin, exp, leq\n"
+        "      --average-count <n>   Averaging length in hops (default 32)\n"
+        "      --average-time <sec>  Averaging length as a time span (follows the hop)\n"
+        "      --waterfall           Show the scrolling waterfall below the bars\n"
+        "      --time-locked         Analyze only the newest window(s) at the playhead, skipping stale hops\n"
+        "      --channels <n>        Mic channels to capture (default %d, capped by the device)\n"
+        "      --low-latency         Mic: analyze each hop as soon as it is captured, not per display frame\n"
+        "      --frames-per-buffer <n> Mic: PortAudio buffer size, 0 = host decides (default %d, %d with --low-latency)\n"
+        "      --latency-log <path>  Mic: append capture-to-display latency percentiles as CSV\n"
+        "      --perf-log <path>     Append per-stage timings (min/p50/p99/max) as CSV every second\n"
+        "      --channel-view <mode> Per-channel spectra: off (default), overlay, stack\n"
+        "      --octave <n>          Fractional octave smoothing 1/n: 1, 3, 6, 12, 24 (default), 48\n"
+        "      --analyze <wav-file>  Analyze the file as fast as possible without a window and exit\n"
+        "      --out <path>          --analyze output; .bin writes binary, anything else CSV\n"
+        "      --bands <n>           --analyze band count (default %d)\n"
+        "      --threads <n>         --analyze worker threads (default: one per CPU, 1 = serial)\n"
         "\n"
         "Controls:\n"
         "  O   Octave (1/1…1/48)\n"
@@ -25,14 +55,24 @@ print_usage(const char *prog)
         "  H   Peak-hold\n"
         "  W   Frequency weighting (Z/A/C)\n"
         "  T   Time weighting (Fast/Slow/Impulse)\n"
+        "  N   FFT size (2k…32k)\n"
+        "  B   Hop / overlap (1/2…1/16 of FFT size)\n"
         "  K   Calibrate SPL to 94 dB (mic mode only)\n"
         "  G   Peak-find (max-hold)\n"
+        "  Z   Zoom-FFT around the locked band\n"
+        "  V   Bin averaging (Off/Lin/Exp/Leq)\n"
+        "  X   Averaging length (4…128 hops)\n"
+        "  S   Waterfall\n"
+        "  L   Per-channel view (Off/Overlay/Stack)\n"
+        "  Tab Next device pane (several --mic)\n"
+        "  I   Profiler panel (per-stage timings)\n"
         "  Left/Right  Step locked band\n"
         "  Mouse Left  Toggle nearest-band lock\n"
-        "  R   Reset peaks/max-hold\n"
+        "  R   Reset peaks/max-hold/average\n"
         "  Space Pause/Resume (file) or Freeze (mic)\n"
         "  F11 Fullscreen\n",
-        prog, prog
+        prog, prog, prog, INPUT_MAX_DEVICES, INPUT_NUM_CHANNELS, INPUT_FRAMES_PER_BUFFER, INPUT_LOW_LATENCY_FRAMES_PER_BUFFER,
+        OFFLINE_DEFAULT_BANDS
     );
 }
 
@@ -87,8 +127,10 @@ clamp_bar_index(const spectrum_state_t *s, i32 index)
 }
 
 internal i32
-cursor_index_from_mouse(const spectrum_state_t *s)
+cursor_index_from_mouse(const app_source_t *src)
 {
+    const spectrum_state_t *s = &src->spectrum_state;
+    const spectrum_view_t *v = &src->view;
     if (s->num_bars <= 0)
     {
         return -1;
@@ -97,21 +139,47 @@ cursor_index_from_mouse(const spectrum_state_t *s)
     Vector2 mouse = GetMousePosition();
     i32 mx = (i32)mouse.x;
     i32 my = (i32)mouse.y;
-    if (mx < s->plot_left || mx >= s->plot_left + s->plot_width || my < s->plot_top || my >= s->plot_top + s->plot_height)
+    if (mx < v->plot_left || mx >= v->plot_left + v->plot_width || my < v->plot_top || my >= v->plot_top + v->plot_height)
     {
         return -1;
     }
 
     i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
-    i32 index = (mx - s->plot_left) / stride;
+    i32 index = (mx - v->plot_left) / stride;
     return clamp_bar_index(s, index);
 }
 
+// Keys, the cursor and the zoom act on the pane in focus
+internal app_source_t *
+app_focused(app_state_t *app_state)
+{
+    return &app_state->sources[app_state->focused_source];
+}
+
+// Keeps the zoom-FFT on the locked band; it switches off when the lock is released
+internal void
+app_sync_zoom(app_state_t *app_state)
+{
+    spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+    if (!s->zoom.enabled)
+    {
+        return;
+    }
+
+    if (!app_state->cursor_lock_enabled || app_state->cursor_locked_index < 0)
+    {
+        spectrum_set_zoom(s, 0, 0.0);
+        return;
+    }
+
+    spectrum_set_zoom(s, 1, s->bar_freq_center[app_state->cursor_locked_index]);
+}
+
 internal void
 app_sync_cursor_indices(app_state_t *app_state)
 {
-    spectrum_state_t *s = &app_state->spectrum_state;
-    app_state->cursor_hover_index = cursor_index_from_mouse(s);
+    spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+    app_state->cursor_hover_index = cursor_index_from_mouse(app_focused(app_state));
 
     if (app_state->cursor_lock_enabled)
     {
@@ -121,6 +189,8 @@ app_sync_cursor_indices(app_state_t *app_state)
             app_state->cursor_lock_enabled = 0;
         }
     }
+
+    app_sync_zoom(app_state);
 }
 
 internal i32
@@ -151,11 +221,36 @@ find_max_hold_peak_index(const spectrum_state_t *s)
 }
 
 void
-app_parse_input_args(i32 argc, char **argv, char **input_file, i32 *loop_flag, i32 *mic_mode)
+app_parse_input_args(i32 argc, char **argv, char **input_file, app_state_t *app_state)
 {
     *input_file = NULL;
-    *loop_flag = 0;
-    *mic_mode = 0;
+    app_state->loop_flag = 0;
+    app_state->mic_mode = 0;
+    app_state->num_sources = 0;
+    app_state->focused_source = 0;
+    app_state->low_latency = 0;
+    app_state->frames_per_buffer = -1;
+    app_state->latency_log_path = NULL;
+    app_state->perf_log_path = NULL;
+    for (i32 i = 0; i < INPUT_MAX_DEVICES; i++)
+    {
+        app_state->sources[i].wake_fd = -1;
+    }
+    app_state->fft_plan_rigor = FFT_PLAN_DEFAULT_RIGOR;
+    app_state->fft_force_replan = 0;
+    app_state->fft_size = FFT_WINDOW_SIZE;
+    app_state->hop_size = 0;
+    app_state->average_mode = AVERAGE_OFF;
+    app_state->average_count = AVERAGE_DEFAULT_COUNT;
+    app_state->average_seconds = 0.0;
+    app_state->waterfall_enabled = 0;
+    app_state->input_channels = INPUT_NUM_CHANNELS;
+    app_state->channel_layout = CHANNEL_LAYOUT_OFF;
+    app_state->fractional_octave_index_selected = 4; // Default to 1/24 octave
+    app_state->analyze_mode = 0;
+    app_state->analyze_output = NULL;
+    app_state->analyze_bands = OFFLINE_DEFAULT_BANDS;
+    app_state->analyze_threads = 0;
 
     if (argc <= 1)
     {
@@ -174,11 +269,259 @@ app_parse_input_args(i32 argc, char **argv, char **input_file, i32 *loop_flag, i
         }
         else if (strcmp(arg, "--loop") == 0 || strcmp(arg, "-l") == 0)
         {
-            *loop_flag = 1;
+            app_state->loop_flag = 1;
         }
         else if (strcmp(arg, "--mic") == 0 || strcmp(arg, "-m") == 0)
         {
-            *mic_mode = 1;
+            if (app_state->num_sources >= INPUT_MAX_DEVICES)
+            {
+                fprintf(stderr, "Error: at most %d --mic devices.\n\n", INPUT_MAX_DEVICES);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            // The device index is optional: without one, PA_DEVICE_INDEX or the default input
+            char *endptr = NULL;
+            long val = (i + 1 < argc && argv[i + 1][0] != '-') ? strtol(argv[i + 1], &endptr, 10) : -1;
+            if (endptr && (*endptr != '\0' || endptr == argv[i + 1]))
+            {
+                val = -1;
+            }
+            else if (endptr)
+            {
+                i++;
+            }
+
+            app_state->sources[app_state->num_sources++].device_index = (i32)val;
+            app_state->mic_mode = 1;
+        }
+        else if (strcmp(arg, "--fft-rigor") == 0)
+        {
+            i32 rigor = (i + 1 < argc) ? fft_plan_rigor_from_name(argv[i + 1]) : -1;
+            if (rigor < 0)
+            {
+                fprintf(stderr, "Error: --fft-rigor expects estimate, measure, patient or exhaustive.\n\n");
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->fft_plan_rigor = rigor;
+            i++;
+        }
+        else if (strcmp(arg, "--replan") == 0)
+        {
+            app_state->fft_force_replan = 1;
+        }
+        else if (strcmp(arg, "--selftest") == 0)
+        {
+            exit(simd_self_test() ? 0 : 1);
+        }
+        else if (strcmp(arg, "--analyze") == 0 || strcmp(arg, "--out") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "Error: %s expects a path.\n\n", arg);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            if (strcmp(arg, "--analyze") == 0)
+            {
+                app_state->analyze_mode = 1;
+                *input_file = argv[i + 1];
+            }
+            else
+            {
+                app_state->analyze_output = argv[i + 1];
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : -1;
+            if (!endptr || *endptr != '\0' || val < 0 || val > OFFLINE_MAX_THREADS)
+            {
+                fprintf(stderr, "Error: --threads expects 0 (all CPUs) to %d.\n\n", OFFLINE_MAX_THREADS);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->analyze_threads = (i32)val;
+            i++;
+        }
+        else if (strcmp(arg, "--bands") == 0 || strcmp(arg, "--octave") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : 0;
+            i32 index = -1;
+            if (endptr && *endptr == '\0' && strcmp(arg, "--octave") == 0)
+            {
+                for (i32 k = 0; k < NUM_FRACTIONAL_OCTAVES; k++)
+                {
+                    if ((long)(1.0 / FRACTIONAL_OCTAVES[k] + 0.5) == val)
+                    {
+                        index = k;
+                    }
+                }
+            }
+
+            if (strcmp(arg, "--octave") == 0)
+            {
+                if (index < 0)
+                {
+                    fprintf(stderr, "Error: --octave expects 1, 3, 6, 12, 24 or 48.\n\n");
+                    print_usage(argv[0]);
+                    exit(1);
+                }
+                app_state->fractional_octave_index_selected = index;
+            }
+            else
+            {
+                if (!endptr || *endptr != '\0' || val < 2 || val > OFFLINE_MAX_BANDS)
+                {
+                    fprintf(stderr, "Error: --bands expects a band count between 2 and %d.\n\n", OFFLINE_MAX_BANDS);
+                    print_usage(argv[0]);
+                    exit(1);
+                }
+                app_state->analyze_bands = (i32)val;
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--waterfall") == 0)
+        {
+            app_state->waterfall_enabled = 1;
+        }
+        else if (strcmp(arg, "--time-locked") == 0)
+        {
+            app_state->time_locked = 1;
+        }
+        else if (strcmp(arg, "--channels") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : 0;
+            if (!endptr || *endptr != '\0' || val < 1 || val > INPUT_MAX_CHANNELS)
+            {
+                fprintf(stderr, "Error: --channels expects 1 to %d.\n\n", INPUT_MAX_CHANNELS);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->input_channels = (i32)val;
+            i++;
+        }
+        else if (strcmp(arg, "--low-latency") == 0)
+        {
+            app_state->low_latency = 1;
+        }
+        else if (strcmp(arg, "--latency-log") == 0 || strcmp(arg, "--perf-log") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "Error: %s expects a path.\n\n", arg);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            if (strcmp(arg, "--latency-log") == 0)
+            {
+                app_state->latency_log_path = argv[i + 1];
+            }
+            else
+            {
+                app_state->perf_log_path = argv[i + 1];
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--frames-per-buffer") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : -1;
+            if (!endptr || *endptr != '\0' || val < 0 || val > INPUT_MAX_FRAMES_PER_BUFFER)
+            {
+                fprintf(stderr, "Error: --frames-per-buffer expects 0 (host decides) to %d.\n\n", INPUT_MAX_FRAMES_PER_BUFFER);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->frames_per_buffer = (i32)val;
+            i++;
+        }
+        else if (strcmp(arg, "--channel-view") == 0)
+        {
+            i32 layout = (i + 1 < argc) ? channel_layout_from_name(argv[i + 1]) : -1;
+            if (layout < 0)
+            {
+                fprintf(stderr, "Error: --channel-view expects off, overlay or stack.\n\n");
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->channel_layout = layout;
+            i++;
+        }
+        else if (strcmp(arg, "--average") == 0)
+        {
+            i32 mode = (i + 1 < argc) ? spectral_average_mode_from_name(argv[i + 1]) : -1;
+            if (mode < 0)
+            {
+                fprintf(stderr, "Error: --average expects off, lin, exp or leq.\n\n");
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->average_mode = mode;
+            i++;
+        }
+        else if (strcmp(arg, "--average-count") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : 0;
+            if (!endptr || *endptr != '\0' || val <= 0 || val > 1000000)
+            {
+                fprintf(stderr, "Error: --average-count expects a positive hop count.\n\n");
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->average_count = (i32)val;
+            app_state->average_seconds = 0.0;
+            i++;
+        }
+        else if (strcmp(arg, "--average-time") == 0)
+        {
+            char *endptr = NULL;
+            f64 val = (i + 1 < argc) ? strtod(argv[i + 1], &endptr) : 0.0;
+            if (!endptr || *endptr != '\0' || !(val > 0.0))
+            {
+                fprintf(stderr, "Error: --average-time expects a positive number of seconds.\n\n");
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            app_state->average_seconds = val;
+            i++;
+        }
+        else if (strcmp(arg, "--fft-size") == 0 || strcmp(arg, "--hop") == 0)
+        {
+            char *endptr = NULL;
+            long val = (i + 1 < argc) ? strtol(argv[i + 1], &endptr, 10) : 0;
+            if (!endptr || *endptr != '\0' || val <= 0 || val > FFT_MAX_WINDOW_SIZE)
+            {
+                fprintf(stderr, "Error: %s expects a positive sample count.\n\n", arg);
+                print_usage(argv[0]);
+                exit(1);
+            }
+
+            if (strcmp(arg, "--fft-size") == 0)
+            {
+                app_state->fft_size = (i32)val;
+            }
+            else
+            {
+                app_state->hop_size = (i32)val;
+            }
+            i++;
         }
         else if (arg[0] != '-' && !*input_file)
         {
@@ -192,7 +535,44 @@ app_parse_input_args(i32 argc, char **argv, char **input_file, i32 *loop_flag, i
         }
     }
 
-    if (!*input_file && !*mic_mode)
+    if (!spectrum_is_valid_fft_size(app_state->fft_size))
+    {
+        fprintf(stderr, "Error: --fft-size must be a power of two between %d and %d.\n\n", FFT_MIN_WINDOW_SIZE, FFT_MAX_WINDOW_SIZE);
+        print_usage(argv[0]);
+        exit(1);
+    }
+
+    if (app_state->hop_size == 0)
+    {
+        app_state->hop_size = app_state->fft_size / 16;
+    }
+    else if (app_state->hop_size > app_state->fft_size)
+    {
+        fprintf(stderr, "Error: --hop must not exceed the FFT size.\n\n");
+        print_usage(argv[0]);
+        exit(1);
+    }
+
+    if (app_state->analyze_mode && (!app_state->analyze_output || app_state->mic_mode))
+    {
+        fprintf(stderr, "Error: --analyze needs --out and cannot be combined with --mic.\n\n");
+        print_usage(argv[0]);
+        exit(1);
+    }
+
+    if ((app_state->low_latency || app_state->frames_per_buffer >= 0 || app_state->latency_log_path) && !app_state->mic_mode)
+    {
+        fprintf(stderr, "Error: --low-latency, --frames-per-buffer and --latency-log apply to --mic only.\n\n");
+        print_usage(argv[0]);
+        exit(1);
+    }
+
+    if (app_state->frames_per_buffer < 0)
+    {
+        app_state->frames_per_buffer = app_state->low_latency ? INPUT_LOW_LATENCY_FRAMES_PER_BUFFER : INPUT_FRAMES_PER_BUFFER;
+    }
+
+    if (!*input_file && !app_state->mic_mode)
     {
         fprintf(stderr, "Error: missing input WAV file (or use --mic).\n\n");
         print_usage(argv[0]);
@@ -200,6 +580,33 @@ app_parse_input_args(i32 argc, char **argv, char **input_file, i32 *loop_flag, i
     }
 }
 
+i32
+app_set_fft_size(app_state_t *app_state, app_source_t *src, i32 fft_size, i32 hop_size)
+{
+    spectrum_state_t *s = &src->spectrum_state;
+    if (!spectrum_set_fft_size(s, fft_size, hop_size))
+    {
+        return 0;
+    }
+
+    // Live input needs nothing here: the analyser's history ring carries the newest samples over
+    if (!app_state->mic_mode)
+    {
+        s->total_windows = spectrum_windows_for_frames(s, (ul)app_state->wav.frame_count);
+        if (s->window_index > s->total_windows)
+        {
+            s->window_index = s->total_windows;
+        }
+    }
+
+    // Read by the capture callback
+    __atomic_store_n(&src->wake_frames, hop_size, __ATOMIC_RELAXED);
+
+    app_state->fft_size = fft_size;
+    app_state->hop_size = hop_size;
+    return 1;
+}
+
 void
 app_handle_input(app_state_t *app_state)
 {
@@ -220,9 +627,6 @@ app_handle_input(app_state_t *app_state)
             SetWindowSize(mw, mh);
             ToggleFullscreen();
         }
-
-        spectrum_handle_resize(&app_state->spectrum_state);
-        app_sync_cursor_indices(app_state);
     }
 
     if (IsKeyPressed(KEY_O))
@@ -234,36 +638,30 @@ app_handle_input(app_state_t *app_state)
         }
 
         f64 frac = FRACTIONAL_OCTAVES[app_state->fractional_octave_index_selected];
-        spectrum_set_fractional_octave(&app_state->spectrum_state, frac, app_state->fractional_octave_index_selected);
+        spectrum_set_fractional_octave(&app_focused(app_state)->spectrum_state, frac, app_state->fractional_octave_index_selected);
 
-        spectrum_handle_resize(&app_state->spectrum_state);
+        spectrum_view_handle_resize(&app_focused(app_state)->view, &app_focused(app_state)->spectrum_state);
         app_sync_cursor_indices(app_state);
     }
 
     if (IsKeyPressed(KEY_C))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
-        s->bar_gradient_index = (s->bar_gradient_index + 1) % NUM_BAR_GRADIENTS;
-        if (s->gradient_tex.id)
-        {
-            UnloadTexture(s->gradient_tex);
-        }
-        s->gradient_tex = create_gradient_texture(s->plot_height, s->bar_gradients[s->bar_gradient_index]);
+        spectrum_view_cycle_gradient(&app_focused(app_state)->view);
     }
 
     if (IsKeyPressed(KEY_P))
     {
-        app_state->spectrum_state.pinking_enabled ^= 1;
+        app_focused(app_state)->spectrum_state.pinking_enabled ^= 1;
     }
 
     if (IsKeyPressed(KEY_A))
     {
-        app_state->spectrum_state.db_smoothing_enabled ^= 1;
+        app_focused(app_state)->spectrum_state.db_smoothing_enabled ^= 1;
     }
 
     if (IsKeyPressed(KEY_F))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
         local_persist i32 fast = 0;
         fast ^= 1;
         if (fast)
@@ -282,7 +680,7 @@ app_handle_input(app_state_t *app_state)
 
     if (IsKeyPressed(KEY_H))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
         f64 next = s->peak_hold_seconds;
 
         if (next <= 0.0)
@@ -307,21 +705,21 @@ app_handle_input(app_state_t *app_state)
 
     if (IsKeyPressed(KEY_W))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
         spectrum_cycle_frequency_weighting(s);
         TraceLog(LOG_INFO, "Frequency weighting: %s", freq_weight_label(s->frequency_weighting_mode));
     }
 
     if (IsKeyPressed(KEY_T))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
         spectrum_cycle_time_weighting(s);
         TraceLog(LOG_INFO, "Time weighting: %s", time_weight_label(s->time_weighting_mode));
     }
 
     if (IsKeyPressed(KEY_K))
     {
-        spectrum_state_t *s = &app_state->spectrum_state;
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
         if (!s->spl_features_enabled)
         {
             TraceLog(LOG_INFO, "SPL calibration is disabled in file input mode");
@@ -341,14 +739,109 @@ app_handle_input(app_state_t *app_state)
         }
     }
 
+    if (IsKeyPressed(KEY_N) || IsKeyPressed(KEY_B))
+    {
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+        i32 size = s->fft_size;
+        i32 divisor = HOP_DIVISOR_PRESETS[NUM_HOP_DIVISOR_PRESETS - 1];
+        for (i32 i = 0; i < NUM_HOP_DIVISOR_PRESETS; i++)
+        {
+            if (s->hop_size * HOP_DIVISOR_PRESETS[i] >= s->fft_size)
+            {
+                divisor = HOP_DIVISOR_PRESETS[i];
+                break;
+            }
+        }
+
+        if (IsKeyPressed(KEY_N))
+        {
+            size = FFT_SIZE_PRESETS[0];
+            for (i32 i = 0; i < NUM_FFT_SIZE_PRESETS; i++)
+            {
+                if (FFT_SIZE_PRESETS[i] > s->fft_size)
+                {
+                    size = FFT_SIZE_PRESETS[i];
+                    break;
+                }
+            }
+        }
+        else
+        {
+            i32 next = HOP_DIVISOR_PRESETS[0];
+            for (i32 i = 0; i < NUM_HOP_DIVISOR_PRESETS; i++)
+            {
+                if (HOP_DIVISOR_PRESETS[i] > divisor)
+                {
+                    next = HOP_DIVISOR_PRESETS[i];
+                    break;
+                }
+            }
+            divisor = next;
+        }
+
+        if (app_set_fft_size(app_state, app_focused(app_state), size, size / divisor))
+        {
+            TraceLog(LOG_INFO, "FFT size %d, hop %d (%.1f ms)", s->fft_size, s->hop_size, s->seconds_per_window * 1000.0);
+        }
+        else
+        {
+            TraceLog(LOG_WARNING, "FFT size %d / hop %d unavailable", size, size / divisor);
+        }
+    }
+
+    if (IsKeyPressed(KEY_V))
+    {
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+        spectrum_set_average_mode(s, (s->average.mode + 1) % NUM_AVERAGE_MODES);
+        TraceLog(LOG_INFO, "Bin averaging: %s (%d hops)", spectral_average_mode_label(s->average.mode), s->average.target);
+    }
+
+    if (IsKeyPressed(KEY_X))
+    {
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+        i32 next = AVERAGE_COUNT_PRESETS[0];
+        for (i32 i = 0; i < NUM_AVERAGE_COUNT_PRESETS; i++)
+        {
+            if (AVERAGE_COUNT_PRESETS[i] > s->average.target)
+            {
+                next = AVERAGE_COUNT_PRESETS[i];
+                break;
+            }
+        }
+
+        spectrum_set_average_count(s, next);
+        TraceLog(LOG_INFO, "Averaging length: %d hops (%.2f s)", next, (f64)next * s->seconds_per_window);
+    }
+
+    if (IsKeyPressed(KEY_S))
+    {
+        app_source_t *src = app_focused(app_state);
+        if (!spectrum_view_set_waterfall(&src->view, &src->spectrum_state, !src->view.waterfall.enabled))
+        {
+            TraceLog(LOG_WARNING, "Waterfall unavailable: failed to create its texture");
+        }
+    }
+
+    if (IsKeyPressed(KEY_L))
+    {
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+        spectrum_set_channel_layout(s, (s->channels.layout + 1) % NUM_CHANNEL_LAYOUTS);
+        TraceLog(LOG_INFO, "Per-channel view: %s (%d channels)", channel_layout_label(s->channels.layout), s->channels.input_channels);
+    }
+
+    if (IsKeyPressed(KEY_I))
+    {
+        app_state->profiler_enabled ^= 1;
+    }
+
     if (IsKeyPressed(KEY_R))
     {
-        spectrum_reset_peaks(&app_state->spectrum_state);
+        spectrum_reset_peaks(&app_focused(app_state)->spectrum_state);
     }
 
     if (IsKeyPressed(KEY_G))
     {
-        i32 peak_index = find_max_hold_peak_index(&app_state->spectrum_state);
+        i32 peak_index = find_max_hold_peak_index(&app_focused(app_state)->spectrum_state);
         if (peak_index >= 0)
         {
             app_state->cursor_lock_enabled = 1;
@@ -360,12 +853,12 @@ app_handle_input(app_state_t *app_state)
     {
         if (IsKeyPressed(KEY_LEFT))
         {
-            app_state->cursor_locked_index = clamp_bar_index(&app_state->spectrum_state, app_state->cursor_locked_index - 1);
+            app_state->cursor_locked_index = clamp_bar_index(&app_focused(app_state)->spectrum_state, app_state->cursor_locked_index - 1);
         }
 
         if (IsKeyPressed(KEY_RIGHT))
         {
-            app_state->cursor_locked_index = clamp_bar_index(&app_state->spectrum_state, app_state->cursor_locked_index + 1);
+            app_state->cursor_locked_index = clamp_bar_index(&app_focused(app_state)->spectrum_state, app_state->cursor_locked_index + 1);
         }
     }
 
@@ -386,13 +879,33 @@ app_handle_input(app_state_t *app_state)
         }
     }
 
+    if (IsKeyPressed(KEY_Z))
+    {
+        spectrum_state_t *s = &app_focused(app_state)->spectrum_state;
+        if (s->zoom.enabled)
+        {
+            spectrum_set_zoom(s, 0, 0.0);
+        }
+        else if (!app_state->cursor_lock_enabled || app_state->cursor_locked_index < 0)
+        {
+            TraceLog(LOG_INFO, "Zoom needs a locked band (click a band or press G first)");
+        }
+        else if (!spectrum_set_zoom(s, 1, s->bar_freq_center[app_state->cursor_locked_index]))
+        {
+            TraceLog(LOG_WARNING, "Zoom unavailable: failed to allocate zoom buffers");
+        }
+    }
+
+    app_sync_zoom(app_state);
+
     if (IsKeyPressed(KEY_SPACE))
     {
-        app_state->freeze_enabled ^= 1;
+        i32 frozen = !app_state->freeze_enabled;
+        __atomic_store_n(&app_state->freeze_enabled, frozen, __ATOMIC_RELAXED);
 
         if (!app_state->mic_mode)
         {
-            if (app_state->freeze_enabled)
+            if (frozen)
             {
                 PauseMusicStream(app_state->music);
                 SetWindowTitle("FFT Visualizer [PAUSED]");
@@ -405,7 +918,7 @@ app_handle_input(app_state_t *app_state)
         }
         else
         {
-            if (app_state->freeze_enabled)
+            if (frozen)
             {
                 SetWindowTitle("FFT Visualizer [FROZEN]");
             }
@@ -419,159 +932,184 @@ app_handle_input(app_state_t *app_state)
     app_sync_cursor_indices(app_state);
 }
 
-internal inline ul
-mic_ring_count_unlocked(const app_state_t *app)
-{
-    return app->mic_ring_write - app->mic_ring_read;
-}
-
-internal inline ul
-mic_ring_space_unlocked(const app_state_t *app)
-{
-    return app->mic_ring_capacity - mic_ring_count_unlocked(app);
-}
-
+// Producer side, on the audio callback: never blocks; whole frames that do not fit are counted
+// and dropped, so the ring stays aligned to frames. Returns the frames pushed.
 internal ul
-mic_ring_count(app_state_t *app)
+mic_ring_push(app_source_t *src, const f32 *frames_in, ul frames, ul channels)
 {
-    ul count;
-    if (!app->mic_ring_mutex_initialized)
+    ul space = src->mic_ring.capacity - spsc_ring_count(&src->mic_ring);
+    ul fit = (frames < space / channels) ? frames : space / channels;
+    spsc_ring_push(&src->mic_ring, frames_in, fit * channels);
+    if (fit < frames)
     {
-        return 0;
+        __atomic_fetch_add(&src->mic_ring_dropped_frames, frames - fit, __ATOMIC_RELAXED);
     }
 
-    pthread_mutex_lock(&app->mic_ring_mutex);
-    count = mic_ring_count_unlocked(app);
-    pthread_mutex_unlock(&app->mic_ring_mutex);
-    return count;
+    return fit;
 }
 
-internal ul
-mic_ring_push(app_state_t *app, const f32 *src, ul n)
+internal i32
+audio_callback(
+    const void *input_buffer, void *output_buffer, unsigned long frames_per_buffer, const PaStreamCallbackTimeInfo *time_info,
+    PaStreamCallbackFlags status_flags, void *user_data
+)
 {
-    if (!app->mic_ring_mutex_initialized)
-    {
-        return 0;
-    }
-
-    pthread_mutex_lock(&app->mic_ring_mutex);
+    (void)output_buffer;
+    (void)status_flags;
 
-    ul space = mic_ring_space_unlocked(app);
-    if (n > space)
-    {
-        app->mic_ring_dropped_frames += (n - space);
-        n = space; // drop overflow
-    }
+    app_source_t *src = (app_source_t *)user_data;
 
-    ul cap = app->mic_ring_capacity;
-    ul w = app->mic_ring_write;
-    for (ul i = 0; i < n; i++)
+    // If no input, nothing to push
+    if (!input_buffer || !src || !src->mic_ring.data)
     {
-        app->mic_ring[(w + i) % cap] = src[i];
+        return (int)paContinue;
     }
 
-    app->mic_ring_write = w + n;
-    pthread_mutex_unlock(&app->mic_ring_mutex);
-    return n;
-}
+    // Frames go in interleaved as captured; the analyser splits or downmixes them
+    ul pushed = mic_ring_push(src, (const f32 *)input_buffer, (ul)frames_per_buffer, (ul)src->input_channels);
 
-internal ul
-mic_ring_pop(app_state_t *app, f32 *dst, ul n)
-{
-    if (!app->mic_ring_mutex_initialized)
+    // Date the block by its first frame; host APIs without ADC times report when the callback ran
+    f64 adc_time = 0.0;
+    if (time_info)
     {
-        return 0;
+        adc_time = (time_info->inputBufferAdcTime > 0.0) ? time_info->inputBufferAdcTime : time_info->currentTime;
     }
-
-    pthread_mutex_lock(&app->mic_ring_mutex);
-
-    ul avail = mic_ring_count_unlocked(app);
-    if (n > avail)
+    if (pushed > 0 && adc_time > 0.0)
     {
-        n = avail;
+        latency_stamps_push(&src->stamps, src->mic_frames_pushed, adc_time);
     }
+    src->mic_frames_pushed += pushed;
 
-    ul cap = app->mic_ring_capacity;
-    ul r = app->mic_ring_read;
-    for (ul i = 0; i < n; i++)
+    // --low-latency: wake the analysis thread once a whole hop is waiting. The eventfd counter
+    // coalesces signals the thread has not consumed yet, so the write never blocks.
+    i32 wake_frames = __atomic_load_n(&src->wake_frames, __ATOMIC_RELAXED);
+    if (src->wake_fd >= 0 && wake_frames > 0 && spsc_ring_count(&src->mic_ring) >= (ul)wake_frames * (ul)src->input_channels)
     {
-        dst[i] = app->mic_ring[(r + i) % cap];
+        u64 one = 1;
+        ssize_t written = write(src->wake_fd, &one, sizeof(one));
+        (void)written;
     }
 
-    app->mic_ring_read = r + n;
-    pthread_mutex_unlock(&app->mic_ring_mutex);
-    return n;
+    return (int)paContinue;
 }
 
-internal ul
-mic_ring_discard_all(app_state_t *app)
+// Opens and starts the stream of one source. Returns 0 on success, 1 on error.
+internal i32
+open_capture_source(app_state_t *app_state, app_source_t *src, i32 num_devices)
 {
-    ul dropped = 0;
-    if (!app->mic_ring_mutex_initialized)
+    PaError err;
+
+    // Without a device index, PA_DEVICE_INDEX or else the default input
+    i32 device_index = src->device_index;
+    if (device_index < 0)
     {
-        return 0;
+        device_index = Pa_GetDefaultInputDevice();
+        const char *env = getenv("PA_DEVICE_INDEX");
+        if (env)
+        {
+            char *endptr = NULL;
+            long val = strtol(env, &endptr, 10);
+            if (endptr != env && *endptr == '\0' && val >= 0 && val < (long)num_devices)
+            {
+                device_index = (i32)val;
+            }
+        }
     }
 
-    pthread_mutex_lock(&app->mic_ring_mutex);
-    dropped = mic_ring_count_unlocked(app);
-    app->mic_ring_read = app->mic_ring_write;
-    pthread_mutex_unlock(&app->mic_ring_mutex);
-    return dropped;
-}
-
-internal i32
-audio_callback(
-    const void *input_buffer, void *output_buffer, unsigned long frames_per_buffer, const PaStreamCallbackTimeInfo *time_info,
-    PaStreamCallbackFlags status_flags, void *user_data
-)
-{
-    (void)output_buffer;
-    (void)time_info;
-    (void)status_flags;
+    if (device_index == paNoDevice || device_index >= num_devices)
+    {
+        fprintf(stderr, "ERROR: No input audio device %d\n", src->device_index);
+        return 1;
+    }
 
-    app_state_t *app = (app_state_t *)user_data;
+    src->device_index = device_index;
+    src->device_info = Pa_GetDeviceInfo(device_index);
+    src->input_channels = app_state->input_channels;
 
-    // If no input, nothing to push
-    if (!input_buffer || !app || !app->mic_ring)
+    i32 max_channels = src->device_info->maxInputChannels;
+    if (max_channels >= 1 && src->input_channels > max_channels)
     {
-        return (int)paContinue;
+        fprintf(stderr, "WARNING: %s has %d input channels, capturing %d\n", src->device_info->name, max_channels, max_channels);
+        src->input_channels = max_channels;
     }
 
-    const f32 *in = (const f32 *)input_buffer;
+    PaStreamParameters in_params;
+    in_params.device = device_index;
+    in_params.channelCount = src->input_channels;
+    in_params.sampleFormat = paFloat32;
+    in_params.suggestedLatency = src->device_info->defaultLowInputLatency;
+    in_params.hostApiSpecificStreamInfo = NULL;
 
-    // Downmix to mono if needed (config uses INPUT_NUM_CHANNELS = 1)
-#if INPUT_NUM_CHANNELS == 1
-    (void)frames_per_buffer;
-    mic_ring_push(app, in, (ul)frames_per_buffer);
-#else
-    // Generic downmix
-    local_persist f32 downmix_buf[INPUT_FRAMES_PER_BUFFER];
-    ul frames = (ul)frames_per_buffer;
-    if (frames > (ul)INPUT_FRAMES_PER_BUFFER)
+    f64 requested_sample_rate = src->device_info->defaultSampleRate;
+    if (requested_sample_rate <= 0.0)
     {
-        frames = (ul)INPUT_FRAMES_PER_BUFFER;
+        requested_sample_rate = (f64)INPUT_SAMPLE_RATE;
     }
 
-    for (ul i = 0; i < frames; i++)
+    if (app_state->low_latency)
     {
-        f32 sum = 0.0f;
-        for (int c = 0; c < INPUT_NUM_CHANNELS; c++)
+        src->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (src->wake_fd < 0)
         {
-            sum += in[i * INPUT_NUM_CHANNELS + c];
+            fprintf(stderr, "WARNING: eventfd unavailable, %s is analyzed at the display rate\n", src->device_info->name);
         }
+    }
+
+    err = Pa_OpenStream(&src->stream, &in_params, NULL, requested_sample_rate, (ul)app_state->frames_per_buffer, paClipOff, audio_callback, src);
 
-        downmix_buf[i] = sum / (f32)INPUT_NUM_CHANNELS;
+    if (err != paNoError)
+    {
+        printf("PortAudio stream error (%s): %s\n", src->device_info->name, Pa_GetErrorText(err));
+        return 1;
     }
-    mic_ring_push(app, downmix_buf, frames);
-#endif
 
-    return (int)paContinue;
+    const PaStreamInfo *stream_info = Pa_GetStreamInfo(src->stream);
+    if (stream_info && stream_info->sampleRate > 0.0)
+    {
+        src->input_sample_rate = stream_info->sampleRate;
+    }
+    else
+    {
+        src->input_sample_rate = (f64)INPUT_SAMPLE_RATE;
+    }
+
+    // At least ~2 seconds of ring buffer for mic capture (enough for the largest FFT size)
+    ul mic_ring_frames = (ul)(src->input_sample_rate * 2.0);
+    if (mic_ring_frames < (ul)(FFT_MAX_WINDOW_SIZE * 2))
+    {
+        mic_ring_frames = (ul)(FFT_MAX_WINDOW_SIZE * 2);
+    }
+
+    if (!spsc_ring_init(&src->mic_ring, mic_ring_frames * (ul)src->input_channels))
+    {
+        fprintf(stderr, "ERROR: Failed to allocate mic ring buffer\n");
+        return 1;
+    }
+    src->mic_ring_dropped_frames = 0;
+
+    // Staging for the hops analyzed in one frame (hop <= FFT size)
+    src->mic_hops = (f32 *)calloc((size_t)FFT_MAX_BATCH_HOPS * FFT_MAX_WINDOW_SIZE * (size_t)src->input_channels, sizeof(f32));
+    if (!src->mic_hops)
+    {
+        fprintf(stderr, "ERROR: Failed to allocate mic hop buffer\n");
+        return 1;
+    }
+
+    err = Pa_StartStream(src->stream);
+    if (err != paNoError)
+    {
+        printf("PortAudio start stream error (%s): %s\n", src->device_info->name, Pa_GetErrorText(err));
+        return 1;
+    }
+
+    printf("Capturing device %d: %s (%d ch, %.0f Hz)\n", device_index, src->device_info->name, src->input_channels, src->input_sample_rate);
+    return 0;
 }
 
 i32
 app_init_audio_capture(app_state_t *app_state)
 {
-    if (app_state->selected_device_stream)
+    if (app_state->sources[0].stream)
     {
         return 0;
     }
@@ -600,170 +1138,515 @@ app_init_audio_capture(app_state_t *app_state)
         printf("  Device %d: %s\n", i, device_info->name);
     }
 
-    // Allow selecting device via environment variable PA_DEVICE_INDEX, otherwise use default input
-    i32 selected_device_index = Pa_GetDefaultInputDevice();
-    if (selected_device_index == paNoDevice)
+    for (i32 i = 0; i < app_state->num_sources; i++)
+    {
+        if (open_capture_source(app_state, &app_state->sources[i], num_devices) != 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+i32
+app_platform_init(app_state_t *app_state)
+{
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
+    SetAudioStreamBufferSizeDefault(AUDIO_STREAM_BUFFER_SAMPLES);
+    InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "FFT Visualizer");
+    InitAudioDevice();
+    SetTargetFPS(60);
+    SetWindowIcon(LoadImage("assets/icon.png"));
+
+    app_state->main_font = LoadFontEx("assets/fonts/Roboto_Mono/RobotoMono-Regular.ttf", 120, 0, 250);
+    app_state->windowed_w = WINDOW_WIDTH;
+    app_state->windowed_h = WINDOW_HEIGHT;
+    app_state->cursor_lock_enabled = 0;
+    app_state->cursor_locked_index = -1;
+    app_state->cursor_hover_index = -1;
+    TraceLog(
+        LOG_INFO, "Keys: O=Frac octave, P=Pink comp, A=dB avg, F=Avg preset, H=Peak hold, W=Weighting, T=Time weighting, K=Calibrate, G=Peak-find, Arrows=Step "
+                  "lock, Click=Toggle lock, L=Channel view, Tab=Next pane, I=Profiler, R=Reset peaks/max-hold, Space=Pause/Resume (file) or Freeze (mic)"
+    );
+
+    return 0;
+}
+
+i32
+app_load_audio_data(app_state_t *app_state, const char *input_file)
+{
+    // The analysis reads the mapped file directly; playback streams it separately
+    if (!wav_reader_open(&app_state->wav, input_file))
+    {
+        app_cleanup(app_state);
+        return 1;
+    }
+
+    app_state->music = LoadMusicStream(input_file);
+    if (app_state->music.stream.buffer == NULL)
     {
-        fprintf(stderr, "ERROR: No default input audio device available\n");
+        fprintf(stderr, "Failed to load music stream: %s\n", input_file);
+        app_cleanup(app_state);
         return 1;
     }
 
-    const char *env = getenv("PA_DEVICE_INDEX");
-    if (env)
+    return 0;
+}
+
+internal f64
+now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// Follows the playhead published by the render loop
+internal void
+analysis_step_file(app_source_t *src)
+{
+    app_state_t *app_state = src->app;
+    spectrum_state_t *s = &src->spectrum_state;
+    f64 playback_time_now;
+    __atomic_load(&app_state->playhead_seconds, &playback_time_now, __ATOMIC_RELAXED);
+
+    if (__atomic_load_n(&app_state->freeze_enabled, __ATOMIC_RELAXED))
+    {
+        // If frozen, keep sync base current to avoid a large catch-up jump on unfreeze.
+        app_state->playback_time_prev = playback_time_now;
+        return;
+    }
+
+    f64 playback_dt = playback_time_now - app_state->playback_time_prev;
+    if (playback_dt < 0.0)
+    {
+        // Stream looped (or restarted): reset FFT playback cursor
+        spectrum_set_total_windows(s, s->total_windows);
+        playback_dt = playback_time_now;
+    }
+
+    if (app_state->time_locked)
+    {
+        spectrum_update_at(s, &app_state->wav, playback_time_now, MAX_PLAYBACK_WINDOWS_PER_FRAME, playback_dt);
+    }
+    else if (playback_dt > 0.0)
+    {
+        spectrum_update(s, &app_state->wav, playback_dt);
+    }
+
+    app_state->playback_time_prev = playback_time_now;
+
+    if (app_state->loop_flag && spectrum_done(s))
+    {
+        spectrum_set_total_windows(s, s->total_windows);
+    }
+}
+
+// Dates the hops just analyzed by the ADC time of their newest sample, and publishes the
+// percentiles for the overlay every LATENCY_REPORT_SECONDS
+internal void
+record_hop_latency(app_source_t *src, i32 hops, i32 hop)
+{
+    f64 now = Pa_GetStreamTime(src->stream);
+    if (hops <= 0 || now <= 0.0)
     {
-        char *endptr = NULL;
-        long val = strtol(env, &endptr, 10);
-        if (endptr != env && *endptr == '\0' && val >= 0 && val < (long)num_devices)
+        return;
+    }
+
+    for (i32 k = 0; k < hops; k++)
+    {
+        u64 frame = src->mic_frames_popped + (u64)(k + 1) * (u64)hop - 1;
+        f64 adc_time;
+        if (latency_stamps_lookup(&src->stamps, frame, src->input_sample_rate, &adc_time))
         {
-            selected_device_index = (i32)val;
+            latency_stats_add(&src->hop_latency, now - adc_time);
+            src->input_time = adc_time;
         }
     }
 
-    app_state->selected_device_info = (PaDeviceInfo *)Pa_GetDeviceInfo(selected_device_index);
-
-    PaStreamParameters in_params;
-    in_params.device = selected_device_index;
-    in_params.channelCount = INPUT_NUM_CHANNELS;
-    in_params.sampleFormat = paFloat32;
-    in_params.suggestedLatency = app_state->selected_device_info->defaultLowInputLatency;
-    in_params.hostApiSpecificStreamInfo = NULL;
+    f64 p50, p99;
+    if (now - src->hop_latency_reported >= LATENCY_REPORT_SECONDS && latency_stats_percentiles(&src->hop_latency, &p50, &p99))
+    {
+        __atomic_store(&src->hop_latency_p50, &p50, __ATOMIC_RELAXED);
+        __atomic_store(&src->hop_latency_p99, &p99, __ATOMIC_RELAXED);
+        __atomic_store_n(&src->hop_latency_hops, src->hop_latency.total, __ATOMIC_RELAXED);
+        src->hop_latency_reported = now;
+    }
+}
 
-    f64 requested_sample_rate = app_state->selected_device_info->defaultSampleRate;
-    if (requested_sample_rate <= 0.0)
+internal void
+analysis_step_mic(app_source_t *src, f64 dt)
+{
+    spectrum_state_t *s = &src->spectrum_state;
+    if (__atomic_load_n(&src->app->freeze_enabled, __ATOMIC_RELAXED))
     {
-        requested_sample_rate = (f64)INPUT_SAMPLE_RATE;
+        src->mic_frames_popped += spsc_ring_discard(&src->mic_ring) / (ul)src->input_channels;
+        return;
     }
 
-    err = Pa_OpenStream(
-        &app_state->selected_device_stream, &in_params, NULL, requested_sample_rate, (ul)INPUT_FRAMES_PER_BUFFER, paClipOff, audio_callback, app_state
-    );
+    ul channels = (ul)src->input_channels;
+    ul avail = spsc_ring_count(&src->mic_ring) / channels;
+    i32 hop = s->hop_size;
+    ul max_windows_this_update = avail / (ul)hop;
 
-    if (err != paNoError)
+    // Cap to avoid long catch-up bursts; one batched transform covers the cap
+    if (max_windows_this_update > FFT_MAX_BATCH_HOPS)
     {
-        printf("PortAudio stream error: %s\n", Pa_GetErrorText(err));
-        return 1;
+        max_windows_this_update = FFT_MAX_BATCH_HOPS;
     }
 
-    const PaStreamInfo *stream_info = Pa_GetStreamInfo(app_state->selected_device_stream);
-    if (stream_info && stream_info->sampleRate > 0.0)
+    // Pop whole hops straight into the analyser's front-end (pad with zeros if short)
+    ul new_samples = max_windows_this_update * (ul)hop * channels;
+    ul got = spsc_ring_pop(&src->mic_ring, src->mic_hops, new_samples);
+    if (got < new_samples)
+    {
+        memset(src->mic_hops + got, 0, (size_t)(new_samples - got) * sizeof(f32));
+    }
+
+    // One window per hop; the update interval is spread across them
+    spectrum_update_windows(s, src->mic_hops, (i32)max_windows_this_update, dt);
+
+    record_hop_latency(src, (i32)max_windows_this_update, hop);
+    src->mic_frames_popped += got / channels;
+}
+
+// Runs one analyser update and publishes the result to the render loop
+internal void
+analysis_step(app_source_t *src, f64 dt)
+{
+    if (src->app->mic_mode)
     {
-        app_state->input_sample_rate = stream_info->sampleRate;
+        analysis_step_mic(src, dt);
     }
     else
     {
-        app_state->input_sample_rate = (f64)INPUT_SAMPLE_RATE;
+        analysis_step_file(src);
     }
 
-    if (pthread_mutex_init(&app_state->mic_ring_mutex, NULL) != 0)
+    triple_buffer_t *exchange = &src->frame_exchange;
+    if (spectrum_frame_capture(&src->frames[exchange->back], &src->spectrum_state))
     {
-        fprintf(stderr, "ERROR: Failed to initialize mic ring mutex\n");
-        return 1;
+        src->frames[exchange->back].input_time = src->input_time;
+        triple_buffer_publish(exchange);
     }
-    app_state->mic_ring_mutex_initialized = 1;
+}
+
+// --low-latency: each hop is analyzed as soon as the callback reports it complete, so its
+// latency is the hop plus the device buffer rather than up to a display frame more
+internal void
+analysis_loop_woken(app_source_t *src)
+{
+    struct pollfd pfd;
+    pfd.fd = src->wake_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
 
-    // Allocate ~2 seconds of ring buffer for mic capture
-    app_state->mic_ring_capacity = (ul)(app_state->input_sample_rate * 2.0);
-    if (app_state->mic_ring_capacity < (ul)(FFT_WINDOW_SIZE * 2))
+    f64 prev = now_seconds();
+    while (!__atomic_load_n(&src->analysis_quit, __ATOMIC_ACQUIRE))
     {
-        app_state->mic_ring_capacity = (ul)(FFT_WINDOW_SIZE * 2);
+        if (poll(&pfd, 1, ANALYSIS_WAKE_TIMEOUT_MS) > 0)
+        {
+            u64 signals;
+            ssize_t got = read(src->wake_fd, &signals, sizeof(signals));
+            (void)got;
+        }
+
+        f64 now = now_seconds();
+        pthread_mutex_lock(&src->analysis_lock);
+        analysis_step(src, now - prev);
+        pthread_mutex_unlock(&src->analysis_lock);
+        prev = now;
     }
+}
 
-    app_state->mic_ring = (f32 *)calloc(app_state->mic_ring_capacity, sizeof(f32));
-    if (!app_state->mic_ring)
+internal void *
+analysis_thread_main(void *arg)
+{
+    app_source_t *src = (app_source_t *)arg;
+    if (src->wake_fd >= 0)
     {
-        fprintf(stderr, "ERROR: Failed to allocate mic ring buffer\n");
-        return 1;
+        analysis_loop_woken(src);
+        return NULL;
     }
 
-    app_state->mic_ring_write = 0;
-    app_state->mic_ring_read = 0;
-    app_state->mic_ring_dropped_frames = 0;
-    memset(app_state->mic_window, 0, sizeof(app_state->mic_window));
+    const f64 interval = 1.0 / ANALYSIS_UPDATE_HZ;
 
-    err = Pa_StartStream(app_state->selected_device_stream);
-    if (err != paNoError)
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    f64 prev = now_seconds();
+    while (!__atomic_load_n(&src->analysis_quit, __ATOMIC_ACQUIRE))
     {
-        printf("PortAudio start stream error: %s\n", Pa_GetErrorText(err));
-        return 1;
+        f64 now = now_seconds();
+        pthread_mutex_lock(&src->analysis_lock);
+        analysis_step(src, now - prev);
+        pthread_mutex_unlock(&src->analysis_lock);
+        prev = now;
+
+        // Absolute deadlines keep the rate steady; after an overrun, restart from now
+        // instead of bursting to catch up
+        next.tv_nsec += (long)(interval * 1e9);
+        while (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        if (ts.tv_sec > next.tv_sec || (ts.tv_sec == next.tv_sec && ts.tv_nsec > next.tv_nsec))
+        {
+            next = ts;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
     }
 
-    return 0;
+    return NULL;
 }
 
-i32
-app_platform_init(app_state_t *app_state)
+internal i32
+app_start_analysis_thread(app_source_t *src)
 {
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
-    SetAudioStreamBufferSizeDefault(AUDIO_STREAM_BUFFER_SAMPLES);
-    InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "FFT Visualizer");
-    InitAudioDevice();
-    SetTargetFPS(60);
-    SetWindowIcon(LoadImage("assets/icon.png"));
+    if (pthread_mutex_init(&src->analysis_lock, NULL) != 0)
+    {
+        return 0;
+    }
+
+    src->analysis_quit = 0;
+    if (pthread_create(&src->analysis_thread, NULL, analysis_thread_main, src) != 0)
+    {
+        pthread_mutex_destroy(&src->analysis_lock);
+        return 0;
+    }
+
+    src->analysis_thread_started = 1;
+    return 1;
+}
+
+internal void
+app_stop_analysis_thread(app_source_t *src)
+{
+    if (!src->analysis_thread_started)
+    {
+        return;
+    }
+
+    __atomic_store_n(&src->analysis_quit, 1, __ATOMIC_RELEASE);
+    if (src->wake_fd >= 0)
+    {
+        u64 one = 1;
+        ssize_t written = write(src->wake_fd, &one, sizeof(one));
+        (void)written;
+    }
+    pthread_join(src->analysis_thread, NULL);
+    pthread_mutex_destroy(&src->analysis_lock);
+    src->analysis_thread_started = 0;
+}
+
+// Waits for at most the analysis update in flight
+internal void
+app_lock_source(app_source_t *src)
+{
+    if (src->analysis_thread_started)
+    {
+        pthread_mutex_lock(&src->analysis_lock);
+    }
+}
+
+internal void
+app_unlock_source(app_source_t *src)
+{
+    if (src->analysis_thread_started)
+    {
+        pthread_mutex_unlock(&src->analysis_lock);
+    }
+}
+
+// Panes in one column, or two once there are more than APP_PANE_MAX_ROWS sources
+internal void
+app_layout_panes(app_state_t *app_state)
+{
+    i32 n = app_state->num_sources;
+    i32 cols = (n > APP_PANE_MAX_ROWS) ? 2 : 1;
+    i32 rows = (n + cols - 1) / cols;
+    f32 pane_w = (f32)(GetScreenWidth() / cols);
+    f32 pane_h = (f32)(GetScreenHeight() / rows);
+    for (i32 i = 0; i < n; i++)
+    {
+        Rectangle pane = {(f32)(i / rows) * pane_w, (f32)(i % rows) * pane_h, pane_w, pane_h};
+        spectrum_view_set_viewport(&app_state->sources[i].view, pane);
+    }
+}
+
+// Tab, or a click in another pane, moves the focus; the cursor lock stays with the pane it
+// was made in only until then
+internal void
+app_handle_focus(app_state_t *app_state)
+{
+    i32 next = app_state->focused_source;
+    if (IsKeyPressed(KEY_TAB))
+    {
+        next = (next + 1) % app_state->num_sources;
+    }
+    else if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    {
+        Vector2 mouse = GetMousePosition();
+        for (i32 i = 0; i < app_state->num_sources; i++)
+        {
+            if (CheckCollisionPointRec(mouse, app_state->sources[i].view.viewport))
+            {
+                next = i;
+            }
+        }
+    }
+
+    if (next == app_state->focused_source)
+    {
+        return;
+    }
+
+    app_source_t *prev = app_focused(app_state);
+    app_lock_source(prev);
+    spectrum_set_zoom(&prev->spectrum_state, 0, 0.0);
+    app_unlock_source(prev);
 
-    app_state->main_font = LoadFontEx("assets/fonts/Roboto_Mono/RobotoMono-Regular.ttf", 120, 0, 250);
-    app_state->windowed_w = WINDOW_WIDTH;
-    app_state->windowed_h = WINDOW_HEIGHT;
     app_state->cursor_lock_enabled = 0;
     app_state->cursor_locked_index = -1;
     app_state->cursor_hover_index = -1;
-    app_state->input_sample_rate = (f64)INPUT_SAMPLE_RATE;
-    app_state->fractional_octave_index_selected = 4; // Default to 1/24 octave
-    TraceLog(
-        LOG_INFO, "Keys: O=Frac octave, P=Pink comp, A=dB avg, F=Avg preset, H=Peak hold, W=Weighting, T=Time weighting, K=Calibrate, G=Peak-find, Arrows=Step "
-                  "lock, Click=Toggle lock, R=Reset peaks/max-hold, Space=Pause/Resume (file) or Freeze (mic)"
-    );
+    app_state->focused_source = next;
+}
 
-    return 0;
+// Every control acts on a key or click edge, so frames without one leave the analyser alone
+internal i32
+app_input_pending(void)
+{
+    return GetKeyPressed() != 0 || IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
 }
 
-i32
-app_load_audio_data(app_state_t *app_state, const char *input_file)
+// Outline and device name of each pane, with the focused one highlighted
+internal void
+draw_pane_frame(const app_state_t *app_state, i32 index)
 {
-    app_state->wave = LoadWave(input_file);
-    if (app_state->wave.frameCount == 0)
+    const app_source_t *src = &app_state->sources[index];
+    const spectrum_view_t *v = &src->view;
+    i32 focused = index == app_state->focused_source;
+    Color border = focused ? (Color){255, 220, 80, 160} : (Color){80, 80, 80, 200};
+    DrawRectangleLines(v->layout_x, v->layout_y, v->layout_width, v->layout_height, border);
+
+    char label[160];
+    snprintf(label, sizeof(label), "%d: %s", src->device_index, src->device_info ? src->device_info->name : "?");
+    f32 text_size = (f32)(18.0 * UI_SCALE);
+    Vector2 ts = MeasureTextEx(v->font, label, text_size, 0);
+    f32 x = (f32)(v->plot_left + v->plot_width) - ts.x - 8.0f;
+    f32 y = (f32)(v->plot_top + v->plot_height) - ts.y - 6.0f;
+    DrawTextEx(v->font, label, (Vector2){x, y}, text_size, 0, focused ? WHITE : (Color){170, 170, 170, 255});
+}
+
+// Dates the frames just presented by the ADC time of their newest sample, and refreshes the
+// overlay figures and the --latency-log rows every LATENCY_REPORT_SECONDS
+internal void
+record_display_latency(app_state_t *app_state, const spectrum_frame_t *const *frames)
+{
+    f64 t = GetTime();
+    i32 report = t - app_state->latency_reported >= LATENCY_REPORT_SECONDS;
+    for (i32 i = 0; i < app_state->num_sources; i++)
     {
-        fprintf(stderr, "Failed to load WAV: %s\n", input_file);
-        app_cleanup(app_state);
-        return 1;
+        app_source_t *src = &app_state->sources[i];
+        f64 now = Pa_GetStreamTime(src->stream);
+        if (frames[i]->input_time > 0.0 && now > 0.0)
+        {
+            latency_stats_add(&src->display_latency, now - frames[i]->input_time);
+        }
+
+        f64 p50, p99;
+        if (!report || !latency_stats_percentiles(&src->display_latency, &p50, &p99))
+        {
+            continue;
+        }
+
+        latency_report_t *r = &src->latency;
+        f64 hop_p50, hop_p99;
+        __atomic_load(&src->hop_latency_p50, &hop_p50, __ATOMIC_RELAXED);
+        __atomic_load(&src->hop_latency_p99, &hop_p99, __ATOMIC_RELAXED);
+        r->hop_p50_ms = hop_p50 * 1000.0;
+        r->hop_p99_ms = hop_p99 * 1000.0;
+        r->hops = __atomic_load_n(&src->hop_latency_hops, __ATOMIC_RELAXED);
+        r->display_p50_ms = p50 * 1000.0;
+        r->display_p99_ms = p99 * 1000.0;
+        r->frames = src->display_latency.total;
+
+        if (app_state->latency_log)
+        {
+            fprintf(
+                app_state->latency_log, "%.3f,%d,%.3f,%.3f,%.3f,%.3f,%lld,%lld\n", t, src->device_index, r->hop_p50_ms, r->hop_p99_ms,
+                r->display_p50_ms, r->display_p99_ms, (long long)r->hops, (long long)r->frames
+            );
+        }
     }
 
-    app_state->music = LoadMusicStream(input_file);
-    if (app_state->music.stream.buffer == NULL)
+    if (report)
     {
-        fprintf(stderr, "Failed to load music stream: %s\n", input_file);
-        app_cleanup(app_state);
-        return 1;
+        app_state->latency_reported = t;
+        if (app_state->latency_log)
+        {
+            fflush(app_state->latency_log);
+        }
+    }
+}
+
+// Takes the stage timings of the last PERF_REPORT_SECONDS for the profiler panel and --perf-log
+internal void
+report_stage_timings(app_state_t *app_state)
+{
+    f64 t = GetTime();
+    if (t - app_state->perf_reported < PERF_REPORT_SECONDS)
+    {
+        return;
     }
 
-    app_state->samples = LoadWaveSamples(app_state->wave);
-    if (!app_state->samples)
+    app_state->perf_reported = t;
+    perf_snapshot(&app_state->perf);
+    if (!app_state->perf_log)
     {
-        fprintf(stderr, "Failed to load wave samples: %s\n", input_file);
-        app_cleanup(app_state);
-        return 1;
+        return;
     }
 
-    return 0;
+    for (i32 i = 0; i < NUM_PERF_STAGES; i++)
+    {
+        const perf_stage_report_t *st = &app_state->perf.stages[i];
+        fprintf(
+            app_state->perf_log, "%.3f,%s,%llu,%.3f,%.3f,%.3f,%.3f\n", t, perf_stage_label(i), (unsigned long long)st->count, st->min_us, st->p50_us,
+            st->p99_us, st->max_us
+        );
+    }
+    fflush(app_state->perf_log);
 }
 
 void
 app_run(app_state_t *app_state)
 {
-    f64 playback_analysis_accum = 0.0;
-    f64 *interp_from_bar = NULL;
-    f64 *interp_to_bar = NULL;
-    f64 *interp_curr_bar = NULL;
-    f64 *interp_from_peak = NULL;
-    f64 *interp_to_peak = NULL;
-    f64 *interp_curr_peak = NULL;
-    i32 interp_bar_count = 0;
-    i32 interp_ready = 0;
-
     if (!app_state->mic_mode)
     {
         app_state->music.looping = (app_state->loop_flag != 0);
         PlayMusicStream(app_state->music);
         app_state->playback_time_prev = 0.0;
+        app_state->playhead_seconds = 0.0;
+    }
+
+    app_layout_panes(app_state);
+    for (i32 i = 0; i < app_state->num_sources; i++)
+    {
+        app_source_t *src = &app_state->sources[i];
+        src->app = app_state;
+        spectrum_view_handle_resize(&src->view, &src->spectrum_state);
+        triple_buffer_init(&src->frame_exchange);
+        spectrum_frame_capture(&src->frames[src->frame_exchange.front], &src->spectrum_state);
+
+        // Without the thread the analyser runs inline once per frame, as before
+        if (!app_start_analysis_thread(src))
+        {
+            TraceLog(LOG_WARNING, "Analysis thread unavailable: analyzing on the render thread");
+        }
     }
 
     app_state->running = true;
@@ -771,270 +1654,128 @@ app_run(app_state_t *app_state)
     while (!WindowShouldClose())
     {
         const f64 frame_dt = GetFrameTime();
+        u64 frame_start = perf_now();
 
-        app_handle_input(app_state);
-
-        spectrum_handle_resize(&app_state->spectrum_state);
-        app_sync_cursor_indices(app_state);
-
-        if (!app_state->mic_mode)
+        i32 input = app_input_pending();
+        if (input)
         {
-            spectrum_state_t *s = &app_state->spectrum_state;
-
-            if (!app_state->freeze_enabled)
-            {
-                UpdateMusicStream(app_state->music);
-            }
-
-            playback_analysis_accum += frame_dt;
-
-            f64 analysis_interval = 1.0 / PLAYBACK_ANALYSIS_FPS;
-            if (analysis_interval <= 0.0)
-            {
-                analysis_interval = 1.0 / 30.0;
-            }
+            app_handle_focus(app_state);
+        }
+        app_layout_panes(app_state);
 
-            i32 run_analysis_now = (playback_analysis_accum >= analysis_interval);
-            if (run_analysis_now)
+        for (i32 i = 0; i < app_state->num_sources; i++)
+        {
+            app_source_t *src = &app_state->sources[i];
+            spectrum_state_t *s = &src->spectrum_state;
+            i32 focused = i == app_state->focused_source;
+            if (!(input && focused) && !spectrum_view_resize_pending(&src->view))
             {
-                while (playback_analysis_accum >= analysis_interval)
+                if (focused)
                 {
-                    playback_analysis_accum -= analysis_interval;
-                }
-            }
-
-            if (s->num_bars > 0 && s->num_bars != interp_bar_count)
-            {
-                i32 n = s->num_bars;
-                f64 *new_from_bar = (f64 *)calloc((size_t)n, sizeof(f64));
-                f64 *new_to_bar = (f64 *)calloc((size_t)n, sizeof(f64));
-                f64 *new_curr_bar = (f64 *)calloc((size_t)n, sizeof(f64));
-                f64 *new_from_peak = (f64 *)calloc((size_t)n, sizeof(f64));
-                f64 *new_to_peak = (f64 *)calloc((size_t)n, sizeof(f64));
-                f64 *new_curr_peak = (f64 *)calloc((size_t)n, sizeof(f64));
-
-                if (new_from_bar && new_to_bar && new_curr_bar && new_from_peak && new_to_peak && new_curr_peak)
-                {
-                    free(interp_from_bar);
-                    free(interp_to_bar);
-                    free(interp_curr_bar);
-                    free(interp_from_peak);
-                    free(interp_to_peak);
-                    free(interp_curr_peak);
-
-                    interp_from_bar = new_from_bar;
-                    interp_to_bar = new_to_bar;
-                    interp_curr_bar = new_curr_bar;
-                    interp_from_peak = new_from_peak;
-                    interp_to_peak = new_to_peak;
-                    interp_curr_peak = new_curr_peak;
-                    interp_bar_count = n;
-
-                    for (i32 b = 0; b < n; b++)
-                    {
-                        f64 bar = s->bar_smoothed[b];
-                        f64 peak = s->peak_power[b];
-                        interp_from_bar[b] = bar;
-                        interp_to_bar[b] = bar;
-                        interp_curr_bar[b] = bar;
-                        interp_from_peak[b] = peak;
-                        interp_to_peak[b] = peak;
-                        interp_curr_peak[b] = peak;
-                    }
-
-                    interp_ready = 1;
-                }
-                else
-                {
-                    free(new_from_bar);
-                    free(new_to_bar);
-                    free(new_curr_bar);
-                    free(new_from_peak);
-                    free(new_to_peak);
-                    free(new_curr_peak);
+                    // Layout and bar count only change below, so this needs no lock
+                    app_state->cursor_hover_index = cursor_index_from_mouse(src);
                 }
+                continue;
             }
 
-            if (!app_state->freeze_enabled && run_analysis_now)
+            app_lock_source(src);
+            if (input && focused)
             {
-                f64 playback_time_now = GetMusicTimePlayed(app_state->music);
-                f64 playback_dt = playback_time_now - app_state->playback_time_prev;
-
-                if (playback_dt < 0.0)
-                {
-                    // Stream looped (or restarted): reset FFT playback cursor
-                    spectrum_set_total_windows(s, s->total_windows);
-                    playback_dt = playback_time_now;
-                }
-
-                if (playback_dt > 0.0)
-                {
-                    spectrum_update(s, &app_state->wave, app_state->samples, playback_dt);
-                }
-
-                if (interp_ready)
-                {
-                    for (i32 b = 0; b < interp_bar_count; b++)
-                    {
-                        interp_from_bar[b] = interp_curr_bar[b];
-                        interp_to_bar[b] = s->bar_smoothed[b];
-                        interp_from_peak[b] = interp_curr_peak[b];
-                        interp_to_peak[b] = s->peak_power[b];
-                    }
-                }
-
-                app_state->playback_time_prev = playback_time_now;
+                app_handle_input(app_state);
             }
-            else if (app_state->freeze_enabled)
+            spectrum_view_handle_resize(&src->view, s);
+            if (focused)
             {
-                // If frozen, keep sync base current to avoid a large catch-up jump on unfreeze.
-                app_state->playback_time_prev = GetMusicTimePlayed(app_state->music);
+                app_sync_cursor_indices(app_state);
             }
 
+            // Show the change this frame: replace whatever frame is pending with the new state
+            triple_buffer_acquire(&src->frame_exchange);
+            spectrum_frame_capture(&src->frames[src->frame_exchange.front], s);
+            src->frames[src->frame_exchange.front].input_time = src->input_time;
+            app_unlock_source(src);
+        }
+
+        if (!app_state->mic_mode)
+        {
             if (!app_state->freeze_enabled)
             {
+                u64 t = perf_now();
                 UpdateMusicStream(app_state->music);
+                perf_record(PERF_STAGE_MUSIC, t);
             }
 
-            if (interp_ready && !app_state->freeze_enabled)
-            {
-                f64 alpha = playback_analysis_accum / analysis_interval;
-                if (alpha < 0.0)
-                {
-                    alpha = 0.0;
-                }
-                if (alpha > 1.0)
-                {
-                    alpha = 1.0;
-                }
-
-                for (i32 b = 0; b < interp_bar_count; b++)
-                {
-                    interp_curr_bar[b] = interp_from_bar[b] + (interp_to_bar[b] - interp_from_bar[b]) * alpha;
-                    interp_curr_peak[b] = interp_from_peak[b] + (interp_to_peak[b] - interp_from_peak[b]) * alpha;
-                }
-
-                f64 *saved_bars = s->bar_smoothed;
-                f64 *saved_peaks = s->peak_power;
-                s->bar_smoothed = interp_curr_bar;
-                s->peak_power = interp_curr_peak;
-                spectrum_render_to_texture(s);
-                s->bar_smoothed = saved_bars;
-                s->peak_power = saved_peaks;
-            }
-            else
-            {
-                spectrum_render_to_texture(s);
-            }
+            f64 playhead = GetMusicTimePlayed(app_state->music);
+            __atomic_store(&app_state->playhead_seconds, &playhead, __ATOMIC_RELAXED);
 
             if (!app_state->loop_flag && !app_state->freeze_enabled && !IsMusicStreamPlaying(app_state->music))
             {
                 break;
             }
-
-            if (app_state->loop_flag && spectrum_done(&app_state->spectrum_state))
-            {
-                spectrum_set_total_windows(&app_state->spectrum_state, app_state->spectrum_state.total_windows);
-            }
         }
-        else
-        {
-            spectrum_state_t *s = &app_state->spectrum_state;
 
-            if (app_state->freeze_enabled)
+        const spectrum_frame_t *frames[INPUT_MAX_DEVICES];
+        for (i32 i = 0; i < app_state->num_sources; i++)
+        {
+            app_source_t *src = &app_state->sources[i];
+            if (!src->analysis_thread_started)
             {
-                mic_ring_discard_all(app_state);
-                spectrum_render_to_texture(&app_state->spectrum_state);
-
-                BeginDrawing();
-                ClearBackground(BLACK);
-                render_draw(&app_state->spectrum_state, app_state->cursor_lock_enabled, app_state->cursor_locked_index, app_state->cursor_hover_index, 0);
-                EndDrawing();
-                continue;
+                analysis_step(src, frame_dt);
             }
 
-            ul avail = mic_ring_count(app_state);
-            i32 hop = s->hop_size;
-            ul max_windows_this_frame = avail / (ul)hop;
+            triple_buffer_acquire(&src->frame_exchange);
+            frames[i] = &src->frames[src->frame_exchange.front];
+            u64 t = perf_now();
+            spectrum_view_render_to_texture(&src->view, frames[i]);
+            perf_record(PERF_STAGE_RENDER_TEXTURE, t);
+        }
 
-            // Cap to avoid long catch-up bursts
-            if (max_windows_this_frame > 8)
+        BeginDrawing();
+        ClearBackground(BLACK);
+        for (i32 i = 0; i < app_state->num_sources; i++)
+        {
+            // Only the focused pane shows the cursor
+            const app_source_t *src = &app_state->sources[i];
+            const latency_report_t *latency = (src->latency.frames > 0) ? &src->latency : NULL;
+            u64 t = perf_now();
+            if (i == app_state->focused_source)
             {
-                max_windows_this_frame = 8;
+                render_draw(
+                    &src->view, frames[i], app_state->cursor_lock_enabled, app_state->cursor_locked_index, app_state->cursor_hover_index,
+                    (!app_state->mic_mode && app_state->freeze_enabled), latency
+                );
             }
-
-            Wave live_wave;
-            live_wave.channels = 1;
-            live_wave.sampleRate = (i32)app_state->input_sample_rate;
-            live_wave.frameCount = FFT_WINDOW_SIZE;
-            live_wave.data = NULL; // not used
-
-            // Ensure we have an initial window filled once (prefer real data if available)
-            local_persist i32 mic_initialized = 0;
-            if (!mic_initialized)
+            else
             {
-                ul need = (ul)FFT_WINDOW_SIZE;
-                ul got = mic_ring_pop(app_state, app_state->mic_window, need);
-                if (got < need)
-                {
-                    ul pad = need - got;
-                    memmove(app_state->mic_window + pad, app_state->mic_window, got * sizeof(f32));
-                    memset(app_state->mic_window, 0, pad * sizeof(f32));
-                }
-
-                mic_initialized = 1;
+                render_draw(&src->view, frames[i], 0, -1, -1, 0, latency);
             }
+            perf_record(PERF_STAGE_RENDER_DRAW, t);
 
-            // Process all whole windows we can form this frame
-            for (ul w = 0; w < max_windows_this_frame; w++)
+            if (app_state->num_sources > 1)
             {
-                // Shift left by hop
-                memmove(app_state->mic_window, app_state->mic_window + hop, (FFT_WINDOW_SIZE - hop) * sizeof(f32));
-
-                // Append hop new samples (pad with zeros if short)
-                ul got = mic_ring_pop(app_state, app_state->mic_window + (FFT_WINDOW_SIZE - hop), (ul)hop);
-                if (got < (ul)hop)
-                {
-                    memset(app_state->mic_window + (FFT_WINDOW_SIZE - hop) + got, 0, (size_t)((ul)hop - got) * sizeof(f32));
-                }
-
-                // One-window update: present current mic_window as the "sample buffer"
-                spectrum_set_total_windows(s, 1);
-
-                // Feed exactly one window worth of "time" so the internal while() runs once
-                spectrum_update(s, &live_wave, app_state->mic_window, s->seconds_per_window);
+                draw_pane_frame(app_state, i);
             }
+        }
 
-            // Feed remainder time into smoothing/meters without creating a new window
-            f64 processed_time = (f64)max_windows_this_frame * s->seconds_per_window;
-            f64 remainder = frame_dt - processed_time;
-            if (remainder > 0.0)
-            {
-                spectrum_set_total_windows(s, 1);
-
-                // With remainder < seconds_per_window, no new window will be computed
-                spectrum_update(s, &live_wave, app_state->mic_window, remainder);
-            }
+        if (app_state->profiler_enabled)
+        {
+            render_draw_profiler(&app_focused(app_state)->view, &app_state->perf);
+        }
+        EndDrawing();
 
-            spectrum_render_to_texture(&app_state->spectrum_state);
+        if (app_state->mic_mode)
+        {
+            record_display_latency(app_state, frames);
         }
 
-        BeginDrawing();
-        ClearBackground(BLACK);
-        render_draw(
-            &app_state->spectrum_state, app_state->cursor_lock_enabled, app_state->cursor_locked_index, app_state->cursor_hover_index,
-            (!app_state->mic_mode && app_state->freeze_enabled)
-        );
-        EndDrawing();
+        perf_record(PERF_STAGE_FRAME, frame_start);
+        report_stage_timings(app_state);
     }
 
-    free(interp_from_bar);
-    free(interp_to_bar);
-    free(interp_curr_bar);
-    free(interp_from_peak);
-    free(interp_to_peak);
-    free(interp_curr_peak);
-
+    for (i32 i = 0; i < app_state->num_sources; i++)
+    {
+        app_stop_analysis_thread(&app_state->sources[i]);
+    }
     app_state->running = false;
 }
 
@@ -1046,44 +1787,65 @@ app_cleanup(app_state_t *app_state)
         UnloadFont(app_state->main_font);
     }
 
-    if (app_state->samples)
+    if (app_state->wav.map)
     {
-        UnloadWaveSamples(app_state->samples);
+        wav_reader_close(&app_state->wav);
     }
 
-    if (app_state->wave.data)
+    if (app_state->latency_log)
     {
-        UnloadWave(app_state->wave);
+        fclose(app_state->latency_log);
+        app_state->latency_log = NULL;
     }
 
-    if (app_state->music.stream.buffer)
+    if (app_state->perf_log)
     {
-        StopMusicStream(app_state->music);
-        UnloadMusicStream(app_state->music);
+        fclose(app_state->perf_log);
+        app_state->perf_log = NULL;
     }
 
-    if (app_state->selected_device_stream)
+    if (app_state->music.stream.buffer)
     {
-        Pa_StopStream(app_state->selected_device_stream);
-        Pa_CloseStream(app_state->selected_device_stream);
-        app_state->selected_device_stream = NULL;
+        StopMusicStream(app_state->music);
+        UnloadMusicStream(app_state->music);
     }
 
-    if (app_state->mic_ring_mutex_initialized)
+    for (i32 i = 0; i < app_state->num_sources; i++)
     {
-        pthread_mutex_destroy(&app_state->mic_ring_mutex);
-        app_state->mic_ring_mutex_initialized = 0;
+        app_source_t *src = &app_state->sources[i];
+        if (src->stream)
+        {
+            Pa_StopStream(src->stream);
+            Pa_CloseStream(src->stream);
+            src->stream = NULL;
+        }
     }
 
     Pa_Terminate();
 
-    if (app_state->mic_ring)
+    for (i32 i = 0; i < app_state->num_sources; i++)
     {
-        free(app_state->mic_ring);
-        app_state->mic_ring = NULL;
+        app_source_t *src = &app_state->sources[i];
+        if (src->wake_fd >= 0)
+        {
+            close(src->wake_fd);
+            src->wake_fd = -1;
+        }
+
+        spsc_ring_destroy(&src->mic_ring);
+        free(src->mic_hops);
+        src->mic_hops = NULL;
+
+        for (i32 f = 0; f < 3; f++)
+        {
+            spectrum_frame_free(&src->frames[f]);
+        }
+
+        spectrum_view_destroy(&src->view);
+        spectrum_destroy(&src->spectrum_state);
     }
 
-    spectrum_destroy(&app_state->spectrum_state);
+    fft_plan_cache_destroy();
     CloseAudioDevice();
     CloseWindow();
 
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "average.h"
+
+global const char *MODE_NAMES[NUM_AVERAGE_MODES] = {"off", "lin", "exp", "leq"};
+
+global const char *MODE_LABELS[NUM_AVERAGE_MODES] = {"Off", "Lin", "Exp", "Leq"};
+
+i32
+spectral_average_resize(spectral_average_t *avg, i32 bins)
+{
+    f64 *acc = (f64 *)malloc((size_t)bins * sizeof(f64));
+    spectrum_real_t *result = SPECTRUM_FFTW(alloc_real)((size_t)bins);
+    if (!acc || !result)
+    {
+        free(acc);
+        SPECTRUM_FFTW(free)(result);
+        return 0;
+    }
+
+    spectral_average_free(avg);
+    avg->acc = acc;
+    avg->result = result;
+    avg->bins = bins;
+    if (avg->target < 1)
+    {
+        avg->target = 1;
+    }
+
+    spectral_average_reset(avg);
+    return 1;
+}
+
+void
+spectral_average_free(spectral_average_t *avg)
+{
+    free(avg->acc);
+    SPECTRUM_FFTW(free)(avg->result);
+    avg->acc = NULL;
+    avg->result = NULL;
+    avg->bins = 0;
+}
+
+void
+spectral_average_reset(spectral_average_t *avg)
+{
+    if (avg->acc)
+    {
+        memset(avg->acc, 0, (size_t)avg->bins * sizeof(f64));
+        memset(avg->result, 0, (size_t)avg->bins * sizeof(spectrum_real_t));
+    }
+
+    avg->count = 0;
+    avg->completed = 0;
+    avg->dirty = 0;
+}
+
+void
+spectral_average_set_mode(spectral_average_t *avg, i32 mode)
+{
+    avg->mode = (mode >= 0 && mode < NUM_AVERAGE_MODES) ? mode : AVERAGE_OFF;
+    spectral_average_reset(avg);
+}
+
+void
+spectral_average_set_target(spectral_average_t *avg, i32 target)
+{
+    avg->target = (target < 1) ? 1 : target;
+    spectral_average_reset(avg);
+}
+
+void
+spectral_average_add(spectral_average_t *avg, const spectrum_real_t *power)
+{
+    i32 bins = avg->bins;
+    f64 *acc = avg->acc;
+
+    avg->count++;
+    avg->dirty = 1;
+
+    if (avg->mode == AVERAGE_EXPONENTIAL)
+    {
+        i64 n = (avg->count < avg->target) ? avg->count : avg->target;
+        f64 a = 1.0 / (f64)n;
+        for (i32 k = 0; k < bins; k++)
+        {
+            acc[k] += a * ((f64)power[k] - acc[k]);
+        }
+
+        return;
+    }
+
+    for (i32 k = 0; k < bins; k++)
+    {
+        acc[k] += (f64)power[k];
+    }
+
+    // A completed linear block is latched into result and the next one starts from zero
+    if (avg->mode == AVERAGE_LINEAR && avg->count >= avg->target)
+    {
+        f64 inv = 1.0 / (f64)avg->count;
+        for (i32 k = 0; k < bins; k++)
+        {
+            avg->result[k] = (spectrum_real_t)(acc[k] * inv);
+            acc[k] = 0.0;
+        }
+
+        avg->count = 0;
+        avg->completed++;
+        avg->dirty = 0;
+    }
+}
+
+const spectrum_real_t *
+spectral_average_result(spectral_average_t *avg)
+{
+    if (!avg->dirty)
+    {
+        return avg->result;
+    }
+    avg->dirty = 0;
+
+    i32 bins = avg->bins;
+    if (avg->mode == AVERAGE_EXPONENTIAL)
+    {
+        for (i32 k = 0; k < bins; k++)
+        {
+            avg->result[k] = (spectrum_real_t)avg->acc[k];
+        }
+    }
+    else if (avg->mode == AVERAGE_LEQ || avg->completed == 0)
+    {
+        // Leq, or the first linear block while it is still filling
+        f64 inv = 1.0 / (f64)avg->count;
+        for (i32 k = 0; k < bins; k++)
+        {
+            avg->result[k] = (spectrum_real_t)(avg->acc[k] * inv);
+        }
+    }
+
+    return avg->result;
+}
+
+f64
+spectral_average_enbw(const spectrum_real_t *window, i32 n)
+{
+    f64 sum = 0.0;
+    f64 sum_sq = 0.0;
+    for (i32 i = 0; i < n; i++)
+    {
+        f64 w = (f64)window[i];
+        sum += w;
+        sum_sq += w * w;
+    }
+
+    return (sum > 0.0) ? (f64)n * sum_sq / (sum * sum) : 1.0;
+}
+
+i32
+spectral_average_mode_from_name(const char *name)
+{
+    for (i32 i = 0; i < NUM_AVERAGE_MODES; i++)
+    {
+        if (strcmp(name, MODE_NAMES[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const char *
+spectral_average_mode_label(i32 mode)
+{
+    if (mode < 0 || mode >= NUM_AVERAGE_MODES)
+    {
+        return "?";
+    }
+
+    return MODE_LABELS[mode];
+}
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "channel_views.h"
+#include "simd.h"
+
+global const char *LAYOUT_NAMES[NUM_CHANNEL_LAYOUTS] = {"off", "overlay", "stack"};
+
+global const char *LAYOUT_LABELS[NUM_CHANNEL_LAYOUTS] = {"Off", "Overlay", "Stack"};
+
+internal void
+free_buffers(channel_views_t *v)
+{
+    for (i32 c = 0; c < CHANNEL_VIEW_MAX; c++)
+    {
+        mirror_buffer_free(&v->history_buf[c]);
+        v->history[c] = NULL;
+    }
+    free(v->planar);
+    SPECTRUM_FFTW(free)(v->fft_in);
+    SPECTRUM_FFTW(free)(v->fft_out);
+    SPECTRUM_FFTW(free)(v->bin_power);
+    free(v->bar_target);
+    free(v->bar_smoothed);
+    v->planar = NULL;
+    v->fft_in = NULL;
+    v->fft_out = NULL;
+    v->bin_power = NULL;
+    v->bar_target = v->bar_smoothed = NULL;
+    v->plan = NULL;
+    v->fft_size = v->fft_bins = v->num_bars = 0;
+    v->planar_rows = 0;
+    v->history_size = 0;
+}
+
+void
+channel_views_set_input_channels(channel_views_t *v, i32 channels)
+{
+    if (channels < 1)
+    {
+        channels = 1;
+    }
+    if (channels == v->input_channels)
+    {
+        return;
+    }
+
+    free_buffers(v);
+    v->input_channels = channels;
+    v->inputs = (channels < CHANNEL_VIEW_MAX_INPUTS) ? channels : CHANNEL_VIEW_MAX_INPUTS;
+    v->count = (v->inputs >= 2) ? v->inputs + 2 : 1;
+}
+
+internal i32
+allocate_bars(channel_views_t *v, i32 num_bars)
+{
+    usize values = (usize)v->count * (usize)num_bars;
+    f64 *target = (f64 *)calloc(values, sizeof(f64));
+    f64 *smoothed = (f64 *)calloc(values, sizeof(f64));
+    if (!target || !smoothed)
+    {
+        free(target);
+        free(smoothed);
+        return 0;
+    }
+
+    free(v->bar_target);
+    free(v->bar_smoothed);
+    v->bar_target = target;
+    v->bar_smoothed = smoothed;
+    v->num_bars = num_bars;
+    return 1;
+}
+
+i32
+channel_views_prepare(channel_views_t *v, i32 fft_size, i32 num_bars)
+{
+    if (v->input_channels < 1)
+    {
+        channel_views_set_input_channels(v, 1);
+    }
+
+    if (v->fft_size != fft_size)
+    {
+        free_buffers(v);
+
+        i32 bins = fft_size / 2 + 1;
+        // The live path de-interleaves every source channel, the derived views need their rows too
+        v->planar_rows = (v->input_channels > v->count) ? v->input_channels : v->count;
+        v->planar = (f32 *)malloc((size_t)v->planar_rows * (size_t)fft_size * sizeof(f32));
+        v->fft_in = SPECTRUM_FFTW(alloc_real)((size_t)v->count * (size_t)fft_size);
+        v->fft_out = SPECTRUM_FFTW(alloc_complex)((size_t)v->count * (size_t)bins);
+        v->bin_power = SPECTRUM_FFTW(alloc_real)((size_t)bins);
+        v->plan = fft_plan_get_batch_fast(fft_size, v->count);
+
+        i32 ok = v->planar && v->fft_in && v->fft_out && v->bin_power && v->plan;
+        for (i32 c = 0; ok && c < v->count; c++)
+        {
+            ok = mirror_buffer_init(&v->history_buf[c], (usize)fft_size * sizeof(spectrum_real_t));
+            // All views share one write position, so every ring must come out the same size
+            ok = ok && (c == 0 || v->history_buf[c].bytes == v->history_buf[0].bytes);
+            v->history[c] = (spectrum_real_t *)(void *)v->history_buf[c].data;
+        }
+        if (!ok)
+        {
+            free_buffers(v);
+            return 0;
+        }
+
+        v->history_size = (i32)(v->history_buf[0].bytes / sizeof(spectrum_real_t));
+        v->history_pos = 0;
+        v->hpf_primed = 0;
+        v->fft_size = fft_size;
+        v->fft_bins = bins;
+    }
+
+    if (v->num_bars != num_bars && !allocate_bars(v, num_bars))
+    {
+        free_buffers(v);
+        return 0;
+    }
+
+    return 1;
+}
+
+void
+channel_views_free(channel_views_t *v)
+{
+    free_buffers(v);
+}
+
+void
+channel_views_reset(channel_views_t *v)
+{
+    for (i32 c = 0; c < v->count && v->history[c]; c++)
+    {
+        mirror_buffer_clear(&v->history_buf[c]);
+    }
+    v->history_pos = 0;
+    v->hpf_primed = 0;
+}
+
+void
+channel_views_feed(channel_views_t *v, i32 count, spectrum_real_t hpf_alpha)
+{
+    i32 n = v->fft_size;
+    if (v->inputs >= 2)
+    {
+        const f32 *l = v->planar;
+        const f32 *r = v->planar + n;
+        f32 *mid = v->planar + (usize)v->inputs * (usize)n;
+        f32 *side = mid + n;
+        for (i32 i = 0; i < count; i++)
+        {
+            mid[i] = 0.5f * (l[i] + r[i]);
+            side[i] = 0.5f * (l[i] - r[i]);
+        }
+    }
+
+    // Same one-pole HPF as the mono path, seeded per view on its first sample
+    i32 size = v->history_size;
+    i32 start = v->history_pos;
+    for (i32 c = 0; c < v->count; c++)
+    {
+        const f32 *src = v->planar + (usize)c * (usize)n;
+        if (!v->hpf_primed)
+        {
+            v->hpf_prev_x[c] = (spectrum_real_t)src[0];
+            v->hpf_prev_y[c] = 0;
+        }
+
+        spectrum_real_t prev_x = v->hpf_prev_x[c];
+        spectrum_real_t prev_y = v->hpf_prev_y[c];
+        spectrum_real_t *history = v->history[c];
+        i32 pos = start;
+        for (i32 i = 0; i < count; i++)
+        {
+            spectrum_real_t x = (spectrum_real_t)src[i];
+            spectrum_real_t y = hpf_alpha * (prev_y + x - prev_x);
+            prev_x = x;
+            prev_y = y;
+
+            history[pos] = y;
+            pos++;
+            if (pos == size)
+            {
+                pos = 0;
+            }
+        }
+        mirror_buffer_sync(&v->history_buf[c], (usize)start * sizeof(spectrum_real_t), (usize)count * sizeof(spectrum_real_t));
+        v->hpf_prev_x[c] = prev_x;
+        v->hpf_prev_y[c] = prev_y;
+    }
+
+    v->hpf_primed = 1;
+    v->history_pos = (i32)(((i64)start + count) % size);
+}
+
+void
+channel_views_transform(channel_views_t *v, const spectrum_real_t *window)
+{
+    i32 n = v->fft_size;
+    i32 offset = v->history_pos + v->history_size - n;
+    for (i32 c = 0; c < v->count; c++)
+    {
+        simd_kernels()->multiply(v->fft_in + (usize)c * (usize)n, v->history[c] + offset, window, n);
+    }
+
+    // The background planner may have finished a faster plan since the views were sized
+    const fft_plan_entry_t *best = fft_plan_find_batch(n, v->count);
+    if (best)
+    {
+        v->plan = best;
+    }
+    SPECTRUM_FFTW(execute_dft_r2c)(v->plan->plan, v->fft_in, v->fft_out);
+}
+
+const char *
+channel_views_label(const channel_views_t *v, i32 view, char *buf, usize size)
+{
+    if (v->inputs >= 2 && view == v->inputs)
+    {
+        return "M";
+    }
+    if (v->inputs >= 2 && view == v->inputs + 1)
+    {
+        return "S";
+    }
+    if (v->input_channels == 2)
+    {
+        return (view == 0) ? "L" : "R";
+    }
+
+    snprintf(buf, size, "Ch %d", view + 1);
+    return buf;
+}
+
+i32
+channel_layout_from_name(const char *name)
+{
+    for (i32 i = 0; i < NUM_CHANNEL_LAYOUTS; i++)
+    {
+        if (strcmp(name, LAYOUT_NAMES[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const char *
+channel_layout_label(i32 layout)
+{
+    if (layout < 0 || layout >= NUM_CHANNEL_LAYOUTS)
+    {
+        return "?";
+    }
+
+    return LAYOUT_LABELS[layout];
+}
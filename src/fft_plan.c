@@ -0,0 +1,483 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "fft_plan.h"
+#include "spectrum_log.h"
+
+#define WISDOM_DIR_NAME "c_fft_visualizer"
+#define FFT_PLAN_PI     3.14159265358979323846
+
+global i32 plan_rigor = FFT_PLAN_DEFAULT_RIGOR;
+global i32 plan_force_replan = 0;
+
+// Entries are filled in under planner_mutex and published by the count (release), so lookups
+// can scan the first plan_cache_count entries without the lock
+global fft_plan_entry_t plan_cache[FFT_PLAN_CACHE_CAPACITY];
+global i32 plan_cache_count = 0;
+
+// The FFTW planner (and wisdom) is not thread-safe; executing finished plans is
+global pthread_mutex_t planner_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Background planner: (size, batch) requests to plan at the configured rigor
+typedef struct
+{
+    i32 n;
+    i32 howmany;
+} plan_request_t;
+
+global pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+global pthread_cond_t queue_wake = PTHREAD_COND_INITIALIZER;
+global plan_request_t queue[FFT_PLAN_QUEUE_CAPACITY];
+global i32 queue_count = 0;
+global i32 worker_started = 0;
+global i32 worker_quit = 0;
+global pthread_t worker_thread;
+
+global const char *RIGOR_NAMES[NUM_FFT_PLAN_RIGORS] = {"estimate", "measure", "patient", "exhaustive"};
+
+global const unsigned RIGOR_FLAGS[NUM_FFT_PLAN_RIGORS] = {FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT, FFTW_EXHAUSTIVE};
+
+void
+fft_plan_configure(i32 rigor, i32 force_replan)
+{
+    if (rigor < 0 || rigor >= NUM_FFT_PLAN_RIGORS)
+    {
+        rigor = FFT_PLAN_DEFAULT_RIGOR;
+    }
+
+    plan_rigor = rigor;
+    plan_force_replan = force_replan;
+}
+
+i32
+fft_plan_rigor_from_name(const char *name)
+{
+    for (i32 i = 0; i < NUM_FFT_PLAN_RIGORS; i++)
+    {
+        if (strcmp(name, RIGOR_NAMES[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const char *
+fft_plan_rigor_name(i32 rigor)
+{
+    if (rigor < 0 || rigor >= NUM_FFT_PLAN_RIGORS)
+    {
+        return "unknown";
+    }
+
+    return RIGOR_NAMES[rigor];
+}
+
+// FNV-1a over the CPU model and feature flags, so wisdom measured on one machine
+// is never applied to a different CPU sharing the same home directory.
+internal u64
+cpu_fingerprint(void)
+{
+    u64 hash = 14695981039346656037ULL;
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f)
+    {
+        return hash;
+    }
+
+    char line[4096];
+    i32 seen_model = 0;
+    i32 seen_flags = 0;
+    while ((!seen_model || !seen_flags) && fgets(line, sizeof(line), f))
+    {
+        i32 is_model = (strncmp(line, "model name", 10) == 0);
+        i32 is_flags = (strncmp(line, "flags", 5) == 0);
+        if ((is_model && seen_model) || (is_flags && seen_flags) || (!is_model && !is_flags))
+        {
+            continue;
+        }
+
+        seen_model |= is_model;
+        seen_flags |= is_flags;
+        for (const char *p = line; *p; p++)
+        {
+            hash ^= (u8)*p;
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    fclose(f);
+    return hash;
+}
+
+internal i32
+ensure_dir(const char *path)
+{
+    if (mkdir(path, 0755) == 0 || errno == EEXIST)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+// Builds <cache>/c_fft_visualizer/wisdom-r2c-<n>-<precision>-<cpu>.fftw, creating the
+// directory if needed. Returns 0 if no cache location is available.
+internal i32
+wisdom_path(char *buf, usize buf_size, i32 n)
+{
+    char dir[1024];
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (xdg && xdg[0] == '/')
+    {
+        snprintf(dir, sizeof(dir), "%s", xdg);
+    }
+    else if (home && home[0])
+    {
+        snprintf(dir, sizeof(dir), "%s/.cache", home);
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (!ensure_dir(dir))
+    {
+        return 0;
+    }
+
+    usize len = strlen(dir);
+    snprintf(dir + len, sizeof(dir) - len, "/%s", WISDOM_DIR_NAME);
+    if (!ensure_dir(dir))
+    {
+        return 0;
+    }
+
+    i32 written = snprintf(buf, buf_size, "%s/wisdom-r2c-%d-%s-%016llx.fftw", dir, n, SPECTRUM_PRECISION_LABEL, (ull)cpu_fingerprint());
+    return written > 0 && (usize)written < buf_size;
+}
+
+// howmany > 1 plans a batch of contiguous transforms (input stride n, output stride n/2+1)
+internal spectrum_fft_plan_t
+make_r2c_plan(i32 n, i32 howmany, spectrum_real_t *in, spectrum_complex_t *out, unsigned flags)
+{
+    if (howmany == 1)
+    {
+        return SPECTRUM_FFTW(plan_dft_r2c_1d)(n, in, out, flags);
+    }
+
+    return SPECTRUM_FFTW(plan_many_dft_r2c)(1, &n, howmany, in, NULL, 1, n, out, NULL, 1, n / 2 + 1, flags);
+}
+
+// True once n has been planned at the configured rigor in this run
+internal i32
+size_planned_locked(i32 n)
+{
+    for (i32 i = 0; i < plan_cache_count; i++)
+    {
+        if (plan_cache[i].size == n && plan_cache[i].rigor >= plan_rigor)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Plans at the configured rigor, from saved wisdom when it has this plan. Without may_measure
+// returns NULL instead of measuring.
+internal spectrum_fft_plan_t
+plan_r2c_with_wisdom(i32 n, i32 howmany, spectrum_real_t *in, spectrum_complex_t *out, i32 may_measure)
+{
+    unsigned flags = RIGOR_FLAGS[plan_rigor];
+    if (plan_rigor == FFT_PLAN_RIGOR_ESTIMATE)
+    {
+        return make_r2c_plan(n, howmany, in, out, flags);
+    }
+
+    char path[1200];
+    i32 have_path = wisdom_path(path, sizeof(path), n);
+
+    // FFTW keeps one wisdom store per process and exports all of it: start each size from its
+    // own file so that file only ever holds plans for n. When replanning, the file is read back
+    // once this run has rewritten it (after the first plan of n).
+    SPECTRUM_FFTW(forget_wisdom)();
+    i32 use_file = !plan_force_replan || size_planned_locked(n);
+    if (have_path && use_file && SPECTRUM_FFTW(import_wisdom_from_filename)(path))
+    {
+        // Wisdom only satisfies requests of equal or lower rigor; fall through to measuring otherwise
+        spectrum_fft_plan_t plan = make_r2c_plan(n, howmany, in, out, flags | FFTW_WISDOM_ONLY);
+        if (plan)
+        {
+            return plan;
+        }
+    }
+
+    if (!may_measure)
+    {
+        return NULL;
+    }
+
+    spectrum_log(SPECTRUM_LOG_INFO, "FFTW: planning %d-point r2c x%d (%s, %s)...", n, howmany, SPECTRUM_PRECISION_LABEL, RIGOR_NAMES[plan_rigor]);
+
+    spectrum_fft_plan_t plan = make_r2c_plan(n, howmany, in, out, flags);
+    if (plan && have_path)
+    {
+        if (SPECTRUM_FFTW(export_wisdom_to_filename)(path))
+        {
+            spectrum_log(SPECTRUM_LOG_INFO, "FFTW: wisdom saved to %s", path);
+        }
+        else
+        {
+            spectrum_log(SPECTRUM_LOG_WARNING, "Failed to save FFTW wisdom to %s", path);
+        }
+    }
+
+    return plan;
+}
+
+// Best cached entry for (n, howmany): the highest rigor planned so far
+internal const fft_plan_entry_t *
+find_entry(i32 n, i32 howmany)
+{
+    const fft_plan_entry_t *best = NULL;
+    i32 count = __atomic_load_n(&plan_cache_count, __ATOMIC_ACQUIRE);
+    for (i32 i = 0; i < count; i++)
+    {
+        if (plan_cache[i].size == n && plan_cache[i].batch == howmany && (!best || plan_cache[i].rigor > best->rigor))
+        {
+            best = &plan_cache[i];
+        }
+    }
+
+    return best;
+}
+
+// With quick set, any cached plan will do and a missing one is built from wisdom or with
+// FFTW_ESTIMATE (milliseconds even at 64k); otherwise it is planned at the configured rigor.
+internal const fft_plan_entry_t *
+get_batch_locked(i32 n, i32 howmany, i32 quick)
+{
+    const fft_plan_entry_t *cached = find_entry(n, howmany);
+    if (cached && (quick || cached->rigor >= plan_rigor))
+    {
+        return cached;
+    }
+
+    if (n < 2 || howmany < 1 || plan_cache_count >= FFT_PLAN_CACHE_CAPACITY)
+    {
+        return cached;
+    }
+
+    // Every plan of size n shares the window table of the first single-transform entry
+    const fft_plan_entry_t *base = (howmany == 1) ? cached : get_batch_locked(n, 1, 1);
+    if (howmany > 1 && (!base || plan_cache_count >= FFT_PLAN_CACHE_CAPACITY))
+    {
+        return cached;
+    }
+
+    // Plan on scratch arrays: measuring planners overwrite their input and output
+    usize bins = (usize)(n / 2 + 1);
+    spectrum_real_t *scratch_in = SPECTRUM_FFTW(alloc_real)((size_t)n * (size_t)howmany);
+    spectrum_complex_t *scratch_out = SPECTRUM_FFTW(alloc_complex)(bins * (size_t)howmany);
+    spectrum_real_t *window = base ? base->window : SPECTRUM_FFTW(alloc_real)((size_t)n);
+    spectrum_fft_plan_t plan = NULL;
+    i32 rigor = plan_rigor;
+    if (scratch_in && scratch_out && window)
+    {
+        plan = plan_r2c_with_wisdom(n, howmany, scratch_in, scratch_out, !quick);
+        if (!plan && quick)
+        {
+            plan = make_r2c_plan(n, howmany, scratch_in, scratch_out, FFTW_ESTIMATE);
+            rigor = FFT_PLAN_RIGOR_ESTIMATE;
+        }
+    }
+
+    SPECTRUM_FFTW(free)(scratch_in);
+    SPECTRUM_FFTW(free)(scratch_out);
+    if (!plan)
+    {
+        if (!base)
+        {
+            SPECTRUM_FFTW(free)(window);
+        }
+        return cached;
+    }
+
+    if (!base)
+    {
+        for (i32 i = 0; i < n; i++)
+        {
+            window[i] = (spectrum_real_t)(0.5 * (1.0 - cos((2.0 * FFT_PLAN_PI * i) / (f64)(n - 1))));
+        }
+    }
+
+    fft_plan_entry_t *entry = &plan_cache[plan_cache_count];
+    entry->size = n;
+    entry->batch = howmany;
+    entry->rigor = rigor;
+    entry->owns_window = !base;
+    entry->plan = plan;
+    entry->window = window;
+    __atomic_store_n(&plan_cache_count, plan_cache_count + 1, __ATOMIC_RELEASE);
+    return entry;
+}
+
+internal void *
+worker_main(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&queue_mutex);
+    while (!worker_quit)
+    {
+        if (queue_count == 0)
+        {
+            pthread_cond_wait(&queue_wake, &queue_mutex);
+            continue;
+        }
+
+        plan_request_t req = queue[0];
+        queue_count--;
+        memmove(queue, queue + 1, (size_t)queue_count * sizeof(queue[0]));
+        pthread_mutex_unlock(&queue_mutex);
+
+        pthread_mutex_lock(&planner_mutex);
+        get_batch_locked(req.n, req.howmany, 0);
+        pthread_mutex_unlock(&planner_mutex);
+
+        pthread_mutex_lock(&queue_mutex);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    return NULL;
+}
+
+// Queues (n, howmany) for the background planner unless it already has a plan at full rigor
+internal void
+request_plan(i32 n, i32 howmany)
+{
+    const fft_plan_entry_t *cached = find_entry(n, howmany);
+    if (cached && cached->rigor >= plan_rigor)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&queue_mutex);
+    i32 queued = 0;
+    for (i32 i = 0; i < queue_count; i++)
+    {
+        queued |= (queue[i].n == n && queue[i].howmany == howmany);
+    }
+
+    if (!worker_started && !worker_quit)
+    {
+        worker_started = (pthread_create(&worker_thread, NULL, worker_main, NULL) == 0);
+    }
+
+    if (!queued && worker_started && queue_count < FFT_PLAN_QUEUE_CAPACITY)
+    {
+        queue[queue_count++] = (plan_request_t){n, howmany};
+        pthread_cond_signal(&queue_wake);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+const fft_plan_entry_t *
+fft_plan_get_batch(i32 n, i32 howmany)
+{
+    pthread_mutex_lock(&planner_mutex);
+    const fft_plan_entry_t *entry = get_batch_locked(n, howmany, 0);
+    pthread_mutex_unlock(&planner_mutex);
+    return entry;
+}
+
+const fft_plan_entry_t *
+fft_plan_get_batch_fast(i32 n, i32 howmany)
+{
+    const fft_plan_entry_t *entry = find_entry(n, howmany);
+    if (!entry)
+    {
+        pthread_mutex_lock(&planner_mutex);
+        entry = get_batch_locked(n, howmany, 1);
+        pthread_mutex_unlock(&planner_mutex);
+    }
+
+    if (entry)
+    {
+        request_plan(n, howmany);
+    }
+    return entry;
+}
+
+const fft_plan_entry_t *
+fft_plan_find_batch(i32 n, i32 howmany)
+{
+    return find_entry(n, howmany);
+}
+
+void
+fft_plan_prefetch(i32 n, i32 max_batch)
+{
+    for (i32 batch = 1; batch <= max_batch; batch *= 2)
+    {
+        request_plan(n, batch);
+    }
+}
+
+void
+fft_plan_lock(void)
+{
+    pthread_mutex_lock(&planner_mutex);
+}
+
+void
+fft_plan_unlock(void)
+{
+    pthread_mutex_unlock(&planner_mutex);
+}
+
+const fft_plan_entry_t *
+fft_plan_get(i32 n)
+{
+    return fft_plan_get_batch(n, 1);
+}
+
+void
+fft_plan_cache_destroy(void)
+{
+    // The plan in progress is finished (and its wisdom saved); the rest of the queue is dropped
+    pthread_mutex_lock(&queue_mutex);
+    worker_quit = 1;
+    queue_count = 0;
+    pthread_cond_signal(&queue_wake);
+    pthread_mutex_unlock(&queue_mutex);
+    if (worker_started)
+    {
+        pthread_join(worker_thread, NULL);
+    }
+    worker_started = 0;
+    worker_quit = 0;
+
+    pthread_mutex_lock(&planner_mutex);
+    for (i32 i = 0; i < plan_cache_count; i++)
+    {
+        SPECTRUM_FFTW(destroy_plan)(plan_cache[i].plan);
+        if (plan_cache[i].owns_window)
+        {
+            SPECTRUM_FFTW(free)(plan_cache[i].window);
+        }
+    }
+
+    memset(plan_cache, 0, sizeof(plan_cache));
+    plan_cache_count = 0;
+    pthread_mutex_unlock(&planner_mutex);
+}
@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency.h"
+
+void
+latency_stamps_push(latency_stamps_t *q, u64 frame, f64 adc_time)
+{
+    // Acquire: the consumer is done with the slots it has released
+    u64 write = q->write;
+    if (write - __atomic_load_n(&q->read, __ATOMIC_ACQUIRE) >= LATENCY_STAMP_SLOTS)
+    {
+        return;
+    }
+
+    latency_stamp_t *slot = &q->slots[write & (LATENCY_STAMP_SLOTS - 1)];
+    slot->frame = frame;
+    slot->adc_time = adc_time;
+
+    // Release: the stamp is visible before the consumer can see the new count
+    __atomic_store_n(&q->write, write + 1, __ATOMIC_RELEASE);
+}
+
+i32
+latency_stamps_lookup(latency_stamps_t *q, u64 frame, f64 sample_rate, f64 *adc_time)
+{
+    u64 read = q->read;
+    u64 write = __atomic_load_n(&q->write, __ATOMIC_ACQUIRE);
+    while (read < write)
+    {
+        const latency_stamp_t *slot = &q->slots[read & (LATENCY_STAMP_SLOTS - 1)];
+        if (slot->frame > frame)
+        {
+            break;
+        }
+
+        q->last = *slot;
+        q->have_last = 1;
+        read++;
+    }
+    __atomic_store_n(&q->read, read, __ATOMIC_RELEASE);
+
+    if (!q->have_last || sample_rate <= 0.0)
+    {
+        return 0;
+    }
+
+    *adc_time = q->last.adc_time + (f64)(frame - q->last.frame) / sample_rate;
+    return 1;
+}
+
+void
+latency_stats_add(latency_stats_t *st, f64 seconds)
+{
+    st->samples[st->pos] = seconds;
+    st->pos = (st->pos + 1) % LATENCY_WINDOW;
+    if (st->count < LATENCY_WINDOW)
+    {
+        st->count++;
+    }
+    st->total++;
+}
+
+internal int
+compare_f64(const void *a, const void *b)
+{
+    f64 x = *(const f64 *)a;
+    f64 y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+internal f64
+nearest_rank(const f64 *sorted, i32 count, f64 p)
+{
+    i32 rank = (i32)((f64)count * p + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    if (rank > count)
+    {
+        rank = count;
+    }
+
+    return sorted[rank - 1];
+}
+
+i32
+latency_stats_percentiles(latency_stats_t *st, f64 *p50, f64 *p99)
+{
+    if (st->count == 0)
+    {
+        return 0;
+    }
+
+    memcpy(st->sorted, st->samples, (size_t)st->count * sizeof(f64));
+    qsort(st->sorted, (size_t)st->count, sizeof(f64), compare_f64);
+    *p50 = nearest_rank(st->sorted, st->count, 0.50);
+    *p99 = nearest_rank(st->sorted, st->count, 0.99);
+    return 1;
+}
@@ -1,13 +1,28 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <raylib.h>
 
 #include "app.h"
 #include "spectrum.h"
+#include "simd.h"
+#include "offline.h"
+#include "spectrum_log.h"
+
+// The analysis library prints nothing by itself; the app shows its diagnostics on stderr
+internal void
+log_to_stderr(i32 level, const char *message, void *user)
+{
+    (void)user;
+    const char *prefix = (level == SPECTRUM_LOG_WARNING) ? "WARNING: " : ((level == SPECTRUM_LOG_ERROR) ? "ERROR: " : "");
+    fprintf(stderr, "%s%s\n", prefix, message);
+}
 
 i32
 main(i32 argc, char **argv)
 {
+    spectrum_set_log(log_to_stderr, NULL);
+
     app_state_t *app_state = (app_state_t *)calloc(1, sizeof(app_state_t));
     if (!app_state)
     {
@@ -16,7 +31,32 @@ main(i32 argc, char **argv)
     }
 
     const char *input_file = NULL;
-    app_parse_input_args(argc, argv, (char **)&input_file, &app_state->loop_flag, &app_state->mic_mode);
+    app_parse_input_args(argc, argv, (char **)&input_file, app_state);
+    fft_plan_configure(app_state->fft_plan_rigor, app_state->fft_force_replan);
+
+    simd_init();
+    printf("SIMD: using %s kernels\n", simd_isa_name(simd_kernels()->isa));
+
+    if (app_state->analyze_mode)
+    {
+        offline_options_t opt = {0};
+        const char *ext = strrchr(app_state->analyze_output, '.');
+        opt.input_path = input_file;
+        opt.output_path = app_state->analyze_output;
+        opt.format = (ext && strcmp(ext, ".bin") == 0) ? OFFLINE_FORMAT_BIN : OFFLINE_FORMAT_CSV;
+        opt.fft_size = app_state->fft_size;
+        opt.hop_size = app_state->hop_size;
+        opt.num_bands = app_state->analyze_bands;
+        opt.fractional_octave_index = app_state->fractional_octave_index_selected;
+        opt.average_mode = app_state->average_mode;
+        opt.average_count = app_state->average_count;
+        opt.average_seconds = app_state->average_seconds;
+        opt.threads = app_state->analyze_threads;
+
+        i32 rc = offline_analyze(&opt);
+        free(app_state);
+        return rc;
+    }
 
     if (app_platform_init(app_state) != 0)
     {
@@ -32,22 +72,25 @@ main(i32 argc, char **argv)
             return 1;
         }
 
-        spectrum_init(&app_state->spectrum_state, &app_state->wave, app_state->main_font);
-        app_state->spectrum_state.spl_features_enabled = 0;
+        app_state->num_sources = 1;
+        spectrum_state_t *s = &app_state->sources[0].spectrum_state;
+        if (!spectrum_init(s, app_state->wav.sample_rate, app_state->fft_size, app_state->hop_size, 0))
+        {
+            fprintf(stderr, "ERROR: Failed to initialize the analyser\n");
+            app_cleanup(app_state);
+            return 1;
+        }
+        // The bar count follows the pane width from here on
+        spectrum_view_init(&app_state->sources[0].view, s, app_state->main_font);
+        spectrum_set_input_channels(s, app_state->wav.channels);
+        s->spl_features_enabled = 0;
         {
             i32 index = app_state->fractional_octave_index_selected;
             f64 frac = FRACTIONAL_OCTAVES[index];
-            spectrum_set_fractional_octave(&app_state->spectrum_state, frac, index);
-
-            i32 hop = FFT_HOP_SIZE;
-            ul frames = (ul)app_state->wave.frameCount;
-            ul total = (frames > FFT_WINDOW_SIZE) ? (1 + (frames - FFT_WINDOW_SIZE) / hop) : 1;
-            if (total < 1)
-            {
-                total = 1;
-            }
+            spectrum_set_fractional_octave(s, frac, index);
 
-            spectrum_set_total_windows(&app_state->spectrum_state, (i32)total);
+            i32 total = spectrum_windows_for_frames(s, (ul)app_state->wav.frame_count);
+            spectrum_set_total_windows(s, total);
         }
     }
     else
@@ -59,18 +102,80 @@ main(i32 argc, char **argv)
             return 1;
         }
 
-        Wave live_wave = {0};
-        live_wave.channels = 1;
-        live_wave.sampleRate = (i32)app_state->input_sample_rate;
-        live_wave.frameCount = FFT_WINDOW_SIZE;
-        spectrum_init(&app_state->spectrum_state, &live_wave, app_state->main_font);
-        app_state->spectrum_state.spl_features_enabled = 1;
+        if (app_state->latency_log_path)
+        {
+            app_state->latency_log = fopen(app_state->latency_log_path, "w");
+            if (!app_state->latency_log)
+            {
+                fprintf(stderr, "ERROR: Failed to open latency log: %s\n", app_state->latency_log_path);
+                app_cleanup(app_state);
+                return 1;
+            }
+
+            // One row per device every LATENCY_REPORT_SECONDS; times in ms, counts since start
+            fprintf(app_state->latency_log, "time_s,device,hop_p50_ms,hop_p99_ms,display_p50_ms,display_p99_ms,hops,frames\n");
+        }
+
+        // One analyser per device, each at the rate and channel count its stream opened with
+        for (i32 i = 0; i < app_state->num_sources; i++)
+        {
+            app_source_t *src = &app_state->sources[i];
+            spectrum_state_t *s = &src->spectrum_state;
+            if (!spectrum_init(s, (i32)src->input_sample_rate, app_state->fft_size, app_state->hop_size, 0))
+            {
+                fprintf(stderr, "ERROR: Failed to initialize the analyser for device %d\n", src->device_index);
+                app_cleanup(app_state);
+                return 1;
+            }
+            spectrum_view_init(&src->view, s, app_state->main_font);
+            spectrum_set_input_channels(s, src->input_channels);
+            s->spl_features_enabled = 1;
+
+            // Sync the requested size with the one the analyser actually settled on
+            app_set_fft_size(app_state, src, s->fft_size, s->hop_size);
+
+            i32 index = app_state->fractional_octave_index_selected;
+            f64 frac = FRACTIONAL_OCTAVES[index];
+            spectrum_set_fractional_octave(s, frac, index);
+
+            spectrum_set_total_windows(s, 1);
+        }
+    }
+
+    for (i32 i = 0; i < app_state->num_sources; i++)
+    {
+        app_source_t *src = &app_state->sources[i];
+        spectrum_state_t *s = &src->spectrum_state;
+        spectrum_set_average_mode(s, app_state->average_mode);
+        if (app_state->average_seconds > 0.0)
+        {
+            spectrum_set_average_seconds(s, app_state->average_seconds);
+        }
+        else
+        {
+            spectrum_set_average_count(s, app_state->average_count);
+        }
+
+        spectrum_set_channel_layout(s, app_state->channel_layout);
+
+        if (app_state->waterfall_enabled && !spectrum_view_set_waterfall(&src->view, s, 1))
+        {
+            fprintf(stderr, "WARNING: waterfall unavailable\n");
+        }
+    }
 
-        i32 index = app_state->fractional_octave_index_selected;
-        f64 frac = FRACTIONAL_OCTAVES[index];
-        spectrum_set_fractional_octave(&app_state->spectrum_state, frac, index);
+    if (app_state->perf_log_path)
+    {
+        app_state->perf_log = fopen(app_state->perf_log_path, "w");
+        if (!app_state->perf_log)
+        {
+            fprintf(stderr, "ERROR: Failed to open perf log: %s\n", app_state->perf_log_path);
+            app_cleanup(app_state);
+            return 1;
+        }
 
-        spectrum_set_total_windows(&app_state->spectrum_state, 1);
+        // One row per stage every PERF_REPORT_SECONDS, covering that interval
+        fprintf(app_state->perf_log, "time_s,stage,count,min_us,p50_us,p99_us,max_us\n");
     }
 
     app_run(app_state);
@@ -0,0 +1,111 @@
+#define _GNU_SOURCE // memfd_create
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mirror_buffer.h"
+
+#define MIRROR_BUFFER_ALIGN 64
+
+// Reserves 2 * bytes of address space, then maps the memfd over both halves
+internal u8 *
+map_mirrored(usize bytes)
+{
+    i32 fd = memfd_create("mirror_buffer", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    u8 *base = NULL;
+    if (ftruncate(fd, (off_t)bytes) == 0)
+    {
+        void *reserved = mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved != MAP_FAILED)
+        {
+            base = (u8 *)reserved;
+            void *lo = mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            void *hi = mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            if (lo == MAP_FAILED || hi == MAP_FAILED)
+            {
+                munmap(base, 2 * bytes);
+                base = NULL;
+            }
+        }
+    }
+
+    // The mappings keep the memory alive
+    close(fd);
+    return base;
+}
+
+i32
+mirror_buffer_init(mirror_buffer_t *m, usize min_bytes)
+{
+    memset(m, 0, sizeof(*m));
+
+    long page = sysconf(_SC_PAGESIZE);
+    if (page > 0)
+    {
+        usize bytes = (min_bytes + (usize)page - 1) / (usize)page * (usize)page;
+        m->data = map_mirrored(bytes);
+        if (m->data)
+        {
+            // Fresh memfd pages read as zero
+            m->bytes = bytes;
+            m->mirrored = 1;
+            return 1;
+        }
+    }
+
+    void *block = NULL;
+    usize bytes = (min_bytes + MIRROR_BUFFER_ALIGN - 1) / MIRROR_BUFFER_ALIGN * MIRROR_BUFFER_ALIGN;
+    if (posix_memalign(&block, MIRROR_BUFFER_ALIGN, 2 * bytes) != 0)
+    {
+        return 0;
+    }
+
+    m->data = (u8 *)block;
+    m->bytes = bytes;
+    mirror_buffer_clear(m);
+    return 1;
+}
+
+void
+mirror_buffer_free(mirror_buffer_t *m)
+{
+    if (m->mirrored)
+    {
+        munmap(m->data, 2 * m->bytes);
+    }
+    else
+    {
+        free(m->data);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+void
+mirror_buffer_clear(mirror_buffer_t *m)
+{
+    memset(m->data, 0, m->mirrored ? m->bytes : 2 * m->bytes);
+}
+
+void
+mirror_buffer_sync(mirror_buffer_t *m, usize offset, usize len)
+{
+    if (m->mirrored || len == 0)
+    {
+        return;
+    }
+
+    usize first = m->bytes - offset;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(m->data + m->bytes + offset, m->data + offset, first);
+    memcpy(m->data + m->bytes, m->data, len - first);
+}
@@ -0,0 +1,523 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "offline.h"
+#include "spectrum.h"
+#include "spectrum_log.h"
+
+typedef struct
+{
+    FILE *out;
+    i32 format;
+    i32 num_bands;
+    ul rows;
+    f64 *power_sum; // per band, for the mean trace
+    f64 *max_power; // per band, the max-hold trace
+    f32 *row_db;
+    u8 *bin_buf; // binary output: one encoded header block or row (8 bytes per band + 32)
+    i32 write_failed;
+} offline_sink_t;
+
+// A contiguous run of windows analyzed by one worker with its own analyser. The worker starts
+// `warmup` windows early so the HPF and the smoothing have settled by `first`, and restarts the
+// bin average `average_warmup` windows before `first` so the HPF start-up transient never enters
+// it; only rows for windows [first, last) are kept.
+typedef struct
+{
+    const offline_options_t *opt;
+    const wav_reader_t *wav;
+    i32 first;
+    i32 last;
+    i32 warmup;
+    i32 average_warmup;
+    i32 num_bands;
+    i32 rows;
+    f64 *times;
+    f32 *rows_db;
+    f64 *power_sum;
+    f64 *max_power;
+    i32 ok;
+} offline_segment_t;
+
+internal f64
+power_to_db(f64 power)
+{
+    return 10.0 * log10(power + EPSILON_POWER) + DB_OFFSET;
+}
+
+internal f64
+now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+internal f64
+bars_time(const spectrum_state_t *s)
+{
+    return ((f64)s->bars_window * (f64)s->hop_size + (f64)s->fft_size) / (f64)s->sample_rate;
+}
+
+internal void
+configure_analyser(spectrum_state_t *s, const offline_options_t *opt, ul frames)
+{
+    spectrum_set_fractional_octave(s, FRACTIONAL_OCTAVES[opt->fractional_octave_index], opt->fractional_octave_index);
+    spectrum_set_average_mode(s, opt->average_mode);
+    if (opt->average_seconds > 0.0)
+    {
+        spectrum_set_average_seconds(s, opt->average_seconds);
+    }
+    else
+    {
+        spectrum_set_average_count(s, opt->average_count);
+    }
+    spectrum_set_total_windows(s, spectrum_windows_for_frames(s, frames));
+}
+
+// Binary output is little endian on any host: values are stored a byte at a time
+internal u8 *
+put_le(u8 *p, u64 bits, i32 bytes)
+{
+    for (i32 i = 0; i < bytes; i++)
+    {
+        p[i] = (u8)(bits >> (8 * i));
+    }
+
+    return p + bytes;
+}
+
+internal u8 *
+put_f32(u8 *p, f32 v)
+{
+    u32 bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_le(p, bits, 4);
+}
+
+internal u8 *
+put_f64(u8 *p, f64 v)
+{
+    u64 bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_le(p, bits, 8);
+}
+
+internal void
+write_header(offline_sink_t *sink, const spectrum_state_t *s)
+{
+    if (sink->format == OFFLINE_FORMAT_CSV)
+    {
+        fprintf(sink->out, "time_s");
+        for (i32 b = 0; b < s->num_bars; b++)
+        {
+            fprintf(sink->out, ",%.3f", s->bar_freq_center[b]);
+        }
+        fputc('\n', sink->out);
+        return;
+    }
+
+    u32 header[6] = {1, (u32)s->num_bars, 0, (u32)s->sample_rate, (u32)s->fft_size, (u32)s->hop_size};
+    u8 *p = sink->bin_buf;
+    memcpy(p, "CFFTBAND", 8);
+    p += 8;
+    for (i32 i = 0; i < 6; i++)
+    {
+        p = put_le(p, header[i], 4);
+    }
+    for (i32 b = 0; b < s->num_bars; b++)
+    {
+        p = put_f64(p, s->bar_freq_center[b]);
+    }
+    fwrite(sink->bin_buf, 1, (size_t)(p - sink->bin_buf), sink->out);
+}
+
+// Rows go out as f32 dB in both formats, so serial and parallel runs print identically
+internal void
+write_row(offline_sink_t *sink, const char *label, f64 t, const f32 *db)
+{
+    i32 n = sink->num_bands;
+    if (sink->format == OFFLINE_FORMAT_CSV)
+    {
+        if (label)
+        {
+            fputs(label, sink->out);
+        }
+        else
+        {
+            fprintf(sink->out, "%.6f", t);
+        }
+
+        for (i32 b = 0; b < n; b++)
+        {
+            fprintf(sink->out, ",%.2f", (f64)db[b]);
+        }
+        fputc('\n', sink->out);
+    }
+    else
+    {
+        u8 *p = sink->bin_buf;
+        if (!label)
+        {
+            p = put_f64(p, t);
+        }
+        for (i32 b = 0; b < n; b++)
+        {
+            p = put_f32(p, db[b]);
+        }
+        fwrite(sink->bin_buf, 1, (size_t)(p - sink->bin_buf), sink->out);
+    }
+
+    if (ferror(sink->out))
+    {
+        sink->write_failed = 1;
+    }
+}
+
+internal void
+write_summary(offline_sink_t *sink)
+{
+    i32 n = sink->num_bands;
+    f64 mean_scale = (sink->rows > 0) ? 1.0 / (f64)sink->rows : 0.0;
+
+    for (i32 b = 0; b < n; b++)
+    {
+        sink->row_db[b] = (f32)power_to_db(sink->max_power[b]);
+    }
+    write_row(sink, "max", 0.0, sink->row_db);
+
+    for (i32 b = 0; b < n; b++)
+    {
+        sink->row_db[b] = (f32)power_to_db(sink->power_sum[b] * mean_scale);
+    }
+    write_row(sink, "mean", 0.0, sink->row_db);
+}
+
+internal void
+serial_on_bars(spectrum_state_t *s, void *user)
+{
+    offline_sink_t *sink = (offline_sink_t *)user;
+    for (i32 b = 0; b < s->num_bars; b++)
+    {
+        f64 p = s->bar_smoothed[b];
+        sink->power_sum[b] += p;
+        sink->max_power[b] = (p > sink->max_power[b]) ? p : sink->max_power[b];
+        sink->row_db[b] = (f32)power_to_db(p);
+    }
+
+    write_row(sink, NULL, bars_time(s), sink->row_db);
+    sink->rows++;
+}
+
+internal void
+analyze_serial(spectrum_state_t *s, const wav_reader_t *wav, offline_sink_t *sink)
+{
+    s->on_bars = serial_on_bars;
+    s->on_bars_user = sink;
+    while (!spectrum_done(s) && !sink->write_failed)
+    {
+        spectrum_analyze_windows(s, wav, FFT_MAX_BATCH_HOPS);
+    }
+    s->on_bars = NULL;
+}
+
+internal void
+segment_on_bars(spectrum_state_t *s, void *user)
+{
+    offline_segment_t *seg = (offline_segment_t *)user;
+    if (s->bars_window < seg->first)
+    {
+        return;
+    }
+
+    f32 *row = seg->rows_db + (size_t)seg->rows * (size_t)seg->num_bands;
+    for (i32 b = 0; b < seg->num_bands; b++)
+    {
+        f64 p = s->bar_smoothed[b];
+        seg->power_sum[b] += p;
+        seg->max_power[b] = (p > seg->max_power[b]) ? p : seg->max_power[b];
+        row[b] = (f32)power_to_db(p);
+    }
+
+    seg->times[seg->rows++] = bars_time(s);
+}
+
+internal void *
+run_segment(void *arg)
+{
+    offline_segment_t *seg = (offline_segment_t *)arg;
+    const offline_options_t *opt = seg->opt;
+
+    seg->rows = 0;
+    memset(seg->power_sum, 0, (size_t)seg->num_bands * sizeof(f64));
+    memset(seg->max_power, 0, (size_t)seg->num_bands * sizeof(f64));
+
+    spectrum_state_t *s = (spectrum_state_t *)calloc(1, sizeof(spectrum_state_t));
+    seg->ok = s && spectrum_init(s, seg->wav->sample_rate, opt->fft_size, opt->hop_size, opt->num_bands);
+    if (seg->ok)
+    {
+        configure_analyser(s, opt, (ul)seg->wav->frame_count);
+        s->total_windows = seg->last;
+        s->window_index = seg->first - seg->warmup;
+        s->on_bars = segment_on_bars;
+        s->on_bars_user = seg;
+
+        i32 settle = seg->first - seg->average_warmup;
+        while (s->window_index < settle)
+        {
+            i32 windows = settle - s->window_index;
+            spectrum_analyze_windows(s, seg->wav, (windows < FFT_MAX_BATCH_HOPS) ? windows : FFT_MAX_BATCH_HOPS);
+        }
+        spectral_average_reset(&s->average);
+
+        while (!spectrum_done(s))
+        {
+            spectrum_analyze_windows(s, seg->wav, FFT_MAX_BATCH_HOPS);
+        }
+    }
+
+    if (s)
+    {
+        spectrum_destroy(s);
+        free(s);
+    }
+    return NULL;
+}
+
+internal i32
+round_up(i32 value, i32 multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+// Splits the windows into contiguous segments, one per worker, and runs them in rounds of
+// `threads` segments; each round is stitched into the output in order before the next starts,
+// so memory stays at one segment of rows per worker whatever the file length.
+internal i32
+analyze_parallel(spectrum_state_t *s, const wav_reader_t *wav, const offline_options_t *opt, offline_sink_t *sink, i32 threads)
+{
+    i32 total = s->total_windows;
+    f64 hops_per_second = (f64)s->sample_rate / (f64)s->hop_size;
+
+    // Segment and warm-up boundaries sit on batch multiples so every worker transforms the same
+    // batches as the serial run
+    i32 max_segment = (i32)ceil(OFFLINE_SEGMENT_SECONDS * hops_per_second);
+    i32 segment = (total + threads - 1) / threads;
+    segment = round_up((segment < max_segment) ? segment : max_segment, FFT_MAX_BATCH_HOPS);
+
+    // The exponential average only starts once the HPF has settled: the start-up transient can
+    // be 100 dB above a quiet band and would take many more time constants to forget
+    i32 average_warmup = 0;
+    if (s->average.mode == AVERAGE_EXPONENTIAL)
+    {
+        average_warmup = round_up(OFFLINE_WARMUP_TIME_CONSTANTS * s->average.target, FFT_MAX_BATCH_HOPS);
+    }
+    i32 warmup = round_up((i32)ceil(OFFLINE_WARMUP_SECONDS * hops_per_second), FFT_MAX_BATCH_HOPS) + average_warmup;
+
+    offline_segment_t *segs = (offline_segment_t *)calloc((size_t)threads, sizeof(offline_segment_t));
+    pthread_t *tids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    i32 *started = (i32 *)calloc((size_t)threads, sizeof(i32));
+    i32 ok = segs && tids && started;
+    for (i32 k = 0; ok && k < threads; k++)
+    {
+        offline_segment_t *seg = &segs[k];
+        seg->opt = opt;
+        seg->wav = wav;
+        seg->num_bands = s->num_bars;
+        seg->times = (f64 *)malloc((size_t)segment * sizeof(f64));
+        seg->rows_db = (f32 *)malloc((size_t)segment * (size_t)s->num_bars * sizeof(f32));
+        seg->power_sum = (f64 *)malloc((size_t)s->num_bars * sizeof(f64));
+        seg->max_power = (f64 *)malloc((size_t)s->num_bars * sizeof(f64));
+        ok = seg->times && seg->rows_db && seg->power_sum && seg->max_power;
+    }
+
+    for (i32 start = 0; ok && start < total && !sink->write_failed; start += threads * segment)
+    {
+        i32 count = 0;
+        for (; count < threads && start + count * segment < total; count++)
+        {
+            offline_segment_t *seg = &segs[count];
+            seg->first = start + count * segment;
+            seg->last = (seg->first + segment < total) ? seg->first + segment : total;
+            seg->warmup = (warmup < seg->first) ? warmup : seg->first;
+            // A warm-up clipped at the file start replays what the serial run saw from window 0,
+            // so the average must run through it too instead of restarting partway in
+            seg->average_warmup = (seg->warmup == seg->first) ? seg->warmup : average_warmup;
+
+            // Run in place if no thread can be started
+            started[count] = (pthread_create(&tids[count], NULL, run_segment, seg) == 0);
+            if (!started[count])
+            {
+                run_segment(seg);
+            }
+        }
+
+        for (i32 k = 0; k < count; k++)
+        {
+            offline_segment_t *seg = &segs[k];
+            if (started[k])
+            {
+                pthread_join(tids[k], NULL);
+            }
+
+            ok = ok && seg->ok;
+            for (i32 r = 0; ok && r < seg->rows; r++)
+            {
+                write_row(sink, NULL, seg->times[r], seg->rows_db + (size_t)r * (size_t)seg->num_bands);
+            }
+            for (i32 b = 0; ok && b < seg->num_bands; b++)
+            {
+                sink->power_sum[b] += seg->power_sum[b];
+                sink->max_power[b] = (seg->max_power[b] > sink->max_power[b]) ? seg->max_power[b] : sink->max_power[b];
+            }
+            if (ok)
+            {
+                sink->rows += (ul)seg->rows;
+            }
+        }
+    }
+
+    for (i32 k = 0; segs && k < threads; k++)
+    {
+        free(segs[k].times);
+        free(segs[k].rows_db);
+        free(segs[k].power_sum);
+        free(segs[k].max_power);
+    }
+    free(segs);
+    free(tids);
+    free(started);
+
+    if (!ok)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to set up the analysis workers");
+    }
+    return ok;
+}
+
+internal i32
+analyze_to_file(spectrum_state_t *s, const wav_reader_t *wav, const offline_options_t *opt)
+{
+    configure_analyser(s, opt, (ul)wav->frame_count);
+
+    // Linear blocks and Leq depend on every earlier hop, so they cannot be split
+    i32 threads = opt->threads;
+    if (threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (i32)cpus : 1;
+    }
+    if (threads > OFFLINE_MAX_THREADS)
+    {
+        threads = OFFLINE_MAX_THREADS;
+    }
+    if (threads > 1 && (s->average.mode == AVERAGE_LINEAR || s->average.mode == AVERAGE_LEQ))
+    {
+        spectrum_log(SPECTRUM_LOG_INFO, "Note: %s averaging runs on one thread", spectral_average_mode_label(s->average.mode));
+        threads = 1;
+    }
+
+    offline_sink_t sink = {0};
+    sink.format = opt->format;
+    sink.num_bands = s->num_bars;
+    sink.power_sum = (f64 *)calloc((size_t)s->num_bars, sizeof(f64));
+    sink.max_power = (f64 *)calloc((size_t)s->num_bars, sizeof(f64));
+    sink.row_db = (f32 *)malloc((size_t)s->num_bars * sizeof(f32));
+    sink.bin_buf = (u8 *)malloc((size_t)s->num_bars * 8 + 32);
+    sink.out = fopen(opt->output_path, (opt->format == OFFLINE_FORMAT_BIN) ? "wb" : "w");
+    if (!sink.power_sum || !sink.max_power || !sink.row_db || !sink.bin_buf || !sink.out)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to open output: %s", opt->output_path);
+        if (sink.out)
+        {
+            fclose(sink.out);
+        }
+        free(sink.power_sum);
+        free(sink.max_power);
+        free(sink.row_db);
+        free(sink.bin_buf);
+        return 1;
+    }
+
+    write_header(&sink, s);
+
+    f64 start = now_seconds();
+    i32 ok = 1;
+    if (threads > 1)
+    {
+        ok = analyze_parallel(s, wav, opt, &sink, threads);
+    }
+    else
+    {
+        analyze_serial(s, wav, &sink);
+    }
+    f64 elapsed = now_seconds() - start;
+
+    write_summary(&sink);
+
+    if (sink.format == OFFLINE_FORMAT_BIN)
+    {
+        // Row count sits after magic, version and num_bands
+        u8 rows[4];
+        put_le(rows, (u32)sink.rows, 4);
+        fseek(sink.out, 8 + 2 * 4, SEEK_SET);
+        fwrite(rows, 1, sizeof(rows), sink.out);
+    }
+
+    i32 failed = !ok || sink.write_failed || ferror(sink.out);
+    failed |= (fclose(sink.out) != 0);
+    free(sink.power_sum);
+    free(sink.max_power);
+    free(sink.row_db);
+    free(sink.bin_buf);
+    if (failed)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to write output: %s", opt->output_path);
+        return 1;
+    }
+
+    f64 audio_seconds = (f64)wav->frame_count / (f64)wav->sample_rate;
+    printf(
+        "Analyzed %.1f s of audio (%d hops, %lu rows, %d bands, %d thread%s) in %.2f s (%.0fx real time) -> %s\n", audio_seconds,
+        s->total_windows, (unsigned long)sink.rows, s->num_bars, threads, (threads == 1) ? "" : "s", elapsed,
+        (elapsed > 0.0) ? audio_seconds / elapsed : 0.0, opt->output_path
+    );
+    return 0;
+}
+
+i32
+offline_analyze(const offline_options_t *opt)
+{
+    // The file is mapped, not decoded: memory stays flat whatever its length
+    wav_reader_t wav;
+    if (!wav_reader_open(&wav, opt->input_path))
+    {
+        return 1;
+    }
+
+    i32 rc = 1;
+    spectrum_state_t *s = (spectrum_state_t *)calloc(1, sizeof(spectrum_state_t));
+    if (s && spectrum_init(s, wav.sample_rate, opt->fft_size, opt->hop_size, opt->num_bands))
+    {
+        rc = analyze_to_file(s, &wav, opt);
+    }
+    else
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to set up the analyser");
+    }
+
+    if (s)
+    {
+        spectrum_destroy(s);
+        free(s);
+    }
+    wav_reader_close(&wav);
+    return rc;
+}
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+
+#include "perf.h"
+
+global const char *STAGE_LABELS[NUM_PERF_STAGES] = {"Preprocess", "FFT", "Bar targets", "Smooth/peaks", "Bar texture", "Draw", "Music stream", "Frame"};
+
+typedef struct
+{
+    u64 bins[PERF_BINS]; // cumulative since start
+    u64 max_ns;          // since the last snapshot
+    u64 inv_min_ns;      // UINT64_MAX - min, so both extremes reset to 0 and grow with a max
+} perf_stage_t;
+
+global perf_stage_t stages[NUM_PERF_STAGES];
+global u64 snapshot_bins[NUM_PERF_STAGES][PERF_BINS]; // reader: bins at the previous snapshot
+
+u64
+perf_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+// Bins 0..3 hold 0..3 ns exactly; above that, the octave and the next two bits pick the bin
+internal i32
+bin_of(u64 ns)
+{
+    if (ns < 4)
+    {
+        return (i32)ns;
+    }
+
+    i32 octave = 63 - __builtin_clzll(ns);
+    i32 bin = (octave - 1) * 4 + (i32)((ns >> (octave - 2)) & 3);
+    return (bin < PERF_BINS) ? bin : PERF_BINS - 1;
+}
+
+internal f64
+bin_middle_ns(i32 bin)
+{
+    if (bin < 4)
+    {
+        return (f64)bin;
+    }
+
+    i32 octave = bin / 4 + 1;
+    f64 width = (f64)(1ull << (octave - 2));
+    f64 lower = (f64)(4 + bin % 4) * width;
+    return lower + 0.5 * width;
+}
+
+internal void
+atomic_max(u64 *p, u64 v)
+{
+    u64 cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(p, &cur, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+void
+perf_record(i32 stage, u64 start_ns)
+{
+    u64 ns = perf_now() - start_ns;
+    perf_stage_t *st = &stages[stage];
+    __atomic_fetch_add(&st->bins[bin_of(ns)], 1, __ATOMIC_RELAXED);
+    atomic_max(&st->max_ns, ns);
+    atomic_max(&st->inv_min_ns, ~ns);
+}
+
+internal f64
+percentile_ns(const u64 *counts, u64 total, f64 p)
+{
+    u64 rank = (u64)((f64)total * p + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    u64 seen = 0;
+    for (i32 b = 0; b < PERF_BINS; b++)
+    {
+        seen += counts[b];
+        if (seen >= rank)
+        {
+            return bin_middle_ns(b);
+        }
+    }
+
+    return bin_middle_ns(PERF_BINS - 1);
+}
+
+internal f64
+clamp_us(f64 v, f64 lo, f64 hi)
+{
+    if (lo > hi)
+    {
+        return v;
+    }
+
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+void
+perf_snapshot(perf_report_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    for (i32 i = 0; i < NUM_PERF_STAGES; i++)
+    {
+        perf_stage_t *st = &stages[i];
+        perf_stage_report_t *out = &r->stages[i];
+
+        u64 counts[PERF_BINS];
+        for (i32 b = 0; b < PERF_BINS; b++)
+        {
+            u64 now = __atomic_load_n(&st->bins[b], __ATOMIC_RELAXED);
+            counts[b] = now - snapshot_bins[i][b];
+            snapshot_bins[i][b] = now;
+            out->count += counts[b];
+        }
+
+        u64 max_ns = __atomic_exchange_n(&st->max_ns, 0, __ATOMIC_RELAXED);
+        u64 min_ns = ~__atomic_exchange_n(&st->inv_min_ns, 0, __ATOMIC_RELAXED);
+        if (out->count == 0)
+        {
+            continue;
+        }
+
+        // Bin middles can lie outside the exact extremes when they share a bin
+        out->min_us = (f64)min_ns * 1e-3;
+        out->max_us = (f64)max_ns * 1e-3;
+        out->p50_us = clamp_us(percentile_ns(counts, out->count, 0.50) * 1e-3, out->min_us, out->max_us);
+        out->p99_us = clamp_us(percentile_ns(counts, out->count, 0.99) * 1e-3, out->min_us, out->max_us);
+    }
+}
+
+const char *
+perf_stage_label(i32 stage)
+{
+    if (stage < 0 || stage >= NUM_PERF_STAGES)
+    {
+        return "?";
+    }
+
+    return STAGE_LABELS[stage];
+}
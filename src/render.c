@@ -1,6 +1,12 @@
 #include <math.h>
 #include "render.h"
 
+// One color per channel view, in view order (inputs, then Mid and Side)
+global const Color CHANNEL_COLORS[CHANNEL_VIEW_MAX] = {
+    {255, 90, 90, 255},  {80, 170, 255, 255}, {120, 230, 90, 255},  {255, 200, 60, 255},  {200, 110, 255, 255},
+    {60, 220, 210, 255}, {255, 140, 40, 255}, {255, 110, 200, 255}, {235, 235, 235, 255}, {150, 150, 150, 255},
+};
+
 internal f64
 power_to_db(f64 power)
 {
@@ -20,34 +26,34 @@ ui_px(i32 base)
 }
 
 internal i32
-freq_to_bar_index(const spectrum_state_t *s, f64 f)
+freq_to_bar_index(const spectrum_frame_t *frame, f64 f)
 {
-    if (f < s->f_min)
+    if (f < frame->f_min)
     {
-        f = s->f_min;
+        f = frame->f_min;
     }
-    if (f > s->f_max)
+    if (f > frame->f_max)
     {
-        f = s->f_max;
+        f = frame->f_max;
     }
 
-    f64 r = log(f / s->f_min) / log(s->f_max / s->f_min);
-    f64 pos = r * (f64)(s->num_bars - 1);
+    f64 r = log(f / frame->f_min) / log(frame->f_max / frame->f_min);
+    f64 pos = r * (f64)(frame->num_bars - 1);
     i32 index = (i32)floor(pos + 0.5);
     if (index < 0)
     {
         index = 0;
     }
-    if (index >= s->num_bars)
+    if (index >= frame->num_bars)
     {
-        index = s->num_bars - 1;
+        index = frame->num_bars - 1;
     }
 
     return index;
 }
 
 internal void
-draw_db_grid(const spectrum_state_t *s)
+draw_db_grid(const spectrum_view_t *v)
 {
     const f32 grid_label_size = ui_text(20.0f);
     const i32 label_left_pad = ui_px(16);
@@ -56,24 +62,24 @@ draw_db_grid(const spectrum_state_t *s)
     {
         f64 db = (f64)db_i;
         f64 norm = (db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
-        i32 y = s->plot_top + (i32)(s->plot_height - norm * s->plot_height);
-        DrawLine(s->plot_left, y, s->plot_left + s->plot_width, y, GRID_COLOR);
+        i32 y = v->plot_top + (i32)(v->plot_height - norm * v->plot_height);
+        DrawLine(v->plot_left, y, v->plot_left + v->plot_width, y, GRID_COLOR);
 
         char label[16];
         snprintf(label, sizeof(label), "%.0f", db);
-        Vector2 ts = MeasureTextEx(s->font, label, grid_label_size, 0);
+        Vector2 ts = MeasureTextEx(v->font, label, grid_label_size, 0);
         i32 ly = y - (i32)(ts.y / 2);
-        if (ly < 2)
+        if (ly < v->layout_y + 2)
         {
-            ly = 2;
+            ly = v->layout_y + 2;
         }
 
-        DrawTextEx(s->font, label, (Vector2){(f32)(s->plot_left - (i32)ts.x - label_left_pad), (f32)ly}, grid_label_size, 0, WHITE);
+        DrawTextEx(v->font, label, (Vector2){(f32)(v->plot_left - (i32)ts.x - label_left_pad), (f32)ly}, grid_label_size, 0, WHITE);
     }
 }
 
 internal void
-draw_freq_grid(const spectrum_state_t *s)
+draw_freq_grid(const spectrum_view_t *v, const spectrum_frame_t *frame)
 {
     const f32 grid_label_size = ui_text(20.0f);
     const i32 label_top_pad = ui_px(6);
@@ -83,21 +89,21 @@ draw_freq_grid(const spectrum_state_t *s)
     for (i32 i = 0; i < (i32)(sizeof(ticks) / sizeof(ticks[0])); i++)
     {
         f64 f = ticks[i];
-        if (f < s->f_min || f > s->f_max)
+        if (f < frame->f_min || f > frame->f_max)
         {
             continue;
         }
 
-        i32 index = freq_to_bar_index(s, f);
+        i32 index = freq_to_bar_index(frame, f);
 
-        i32 x = s->plot_left + index * (BAR_PIXEL_WIDTH + BAR_GAP) + BAR_PIXEL_WIDTH / 2;
+        i32 x = v->plot_left + index * (BAR_PIXEL_WIDTH + BAR_GAP) + BAR_PIXEL_WIDTH / 2;
         if (x == last_x)
         {
             continue;
         }
 
         last_x = x;
-        DrawLine(x, s->plot_top, x, s->plot_top + s->plot_height, GRID_COLOR);
+        DrawLine(x, v->plot_top, x, v->plot_top + v->plot_height, GRID_COLOR);
 
         char label[16];
         if (f >= 1000.0)
@@ -109,23 +115,214 @@ draw_freq_grid(const spectrum_state_t *s)
             snprintf(label, sizeof(label), "%.0f", f);
         }
 
-        Vector2 ts = MeasureTextEx(s->font, label, grid_label_size, 0);
+        Vector2 ts = MeasureTextEx(v->font, label, grid_label_size, 0);
         i32 lx = x - (i32)(ts.x / 2);
-        if (lx < s->plot_left)
+        if (lx < v->plot_left)
         {
-            lx = s->plot_left;
+            lx = v->plot_left;
         }
-        if (lx + (i32)ts.x > s->plot_left + s->plot_width)
+        if (lx + (i32)ts.x > v->plot_left + v->plot_width)
         {
-            lx = s->plot_left + s->plot_width - (i32)ts.x;
+            lx = v->plot_left + v->plot_width - (i32)ts.x;
         }
 
-        DrawTextEx(s->font, label, (Vector2){(f32)lx, (f32)(s->plot_top + s->plot_height + label_top_pad)}, grid_label_size, 0, WHITE);
+        DrawTextEx(v->font, label, (Vector2){(f32)lx, (f32)(v->plot_top + v->plot_height + label_top_pad)}, grid_label_size, 0, WHITE);
     }
 }
 
 internal void
-draw_overlay(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index)
+format_hz(char *buf, usize size, f64 f)
+{
+    if (fabs(f) >= 1000.0)
+    {
+        snprintf(buf, size, "%.4fk", f / 1000.0);
+    }
+    else
+    {
+        snprintf(buf, size, "%.2f", f);
+    }
+}
+
+internal f64
+bar_norm(f64 power)
+{
+    f64 t = (power_to_db(power) - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+    return (t < 0.0) ? 0.0 : ((t > 1.0) ? 1.0 : t);
+}
+
+// Color-keyed view names along the top right of the plot
+internal void
+draw_channel_legend(const spectrum_view_t *v, const spectrum_frame_t *frame)
+{
+    const f32 text_size = ui_text(18.0f);
+    const i32 gap = ui_px(14);
+
+    f32 width = 0.0f;
+    for (i32 c = 0; c < frame->channel_views; c++)
+    {
+        width += MeasureTextEx(v->font, frame->channel_labels[c], text_size, 0).x + (f32)gap;
+    }
+
+    f32 x = (f32)(v->plot_left + v->plot_width) - width;
+    f32 y = (f32)(v->plot_top + ui_px(6));
+    for (i32 c = 0; c < frame->channel_views; c++)
+    {
+        DrawTextEx(v->font, frame->channel_labels[c], (Vector2){x, y}, text_size, 0, CHANNEL_COLORS[c]);
+        x += MeasureTextEx(v->font, frame->channel_labels[c], text_size, 0).x + (f32)gap;
+    }
+}
+
+// Overlay layout: each view as a line through its bar tops over the mono bars
+internal void
+draw_channel_traces(const spectrum_view_t *v, const spectrum_frame_t *frame)
+{
+    i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
+    f32 bottom = (f32)(v->plot_top + v->plot_height);
+    BeginScissorMode(v->plot_left, v->plot_top, v->plot_width, v->plot_height);
+    for (i32 c = 0; c < frame->channel_views; c++)
+    {
+        const f64 *bars = frame->channel_bars + (usize)c * (usize)frame->num_bars;
+        Vector2 prev = {0};
+        for (i32 b = 0; b < frame->num_bars; b++)
+        {
+            Vector2 point = {(f32)(v->plot_left + b * stride + BAR_PIXEL_WIDTH / 2), bottom - (f32)(bar_norm(bars[b]) * (f64)v->plot_height)};
+            if (b > 0)
+            {
+                DrawLineV(prev, point, CHANNEL_COLORS[c]);
+            }
+            prev = point;
+        }
+    }
+    EndScissorMode();
+
+    draw_channel_legend(v, frame);
+}
+
+// Stack layout: the plot split into one strip of bars per view, replacing the mono bars
+internal void
+draw_channel_stack(const spectrum_view_t *v, const spectrum_frame_t *frame)
+{
+    const f32 label_size = ui_text(18.0f);
+    i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
+    i32 strip_h = v->plot_height / frame->channel_views;
+    for (i32 c = 0; c < frame->channel_views; c++)
+    {
+        const f64 *bars = frame->channel_bars + (usize)c * (usize)frame->num_bars;
+        i32 strip_top = v->plot_top + c * strip_h;
+        i32 strip_bottom = strip_top + strip_h;
+        i32 bar_area = strip_h - ui_px(2);
+        for (i32 b = 0; b < frame->num_bars; b++)
+        {
+            i32 bar_h = (i32)(bar_norm(bars[b]) * (f64)bar_area);
+            if (bar_h > 0)
+            {
+                DrawRectangle(v->plot_left + b * stride, strip_bottom - bar_h, BAR_PIXEL_WIDTH, bar_h, CHANNEL_COLORS[c]);
+            }
+        }
+
+        DrawLine(v->plot_left, strip_bottom, v->plot_left + v->plot_width, strip_bottom, GRID_COLOR);
+
+        DrawTextEx(v->font, frame->channel_labels[c], (Vector2){(f32)(v->plot_left + ui_px(6)), (f32)(strip_top + ui_px(4))}, label_size, 0, CHANNEL_COLORS[c]);
+    }
+}
+
+// Zoom-FFT inset, bottom-left corner at (left, bottom): the middle half of the decimated band
+// as a dB trace with the locked center marked and the strongest bin read out
+internal void
+draw_zoom_panel(const spectrum_view_t *v, const spectrum_frame_t *frame, i32 left, i32 bottom)
+{
+    const f32 text_size = ui_text(17.0f);
+
+    i32 panel_w = ui_px(380);
+    i32 panel_h = ui_px(150);
+    i32 panel_x = left;
+    i32 panel_y = bottom - panel_h;
+    if (panel_x + panel_w > v->plot_left + v->plot_width)
+    {
+        panel_x = v->plot_left + v->plot_width - panel_w;
+    }
+
+    DrawRectangle(panel_x, panel_y, panel_w, panel_h, (Color){0, 0, 0, 242});
+    DrawRectangleLines(panel_x, panel_y, panel_w, panel_h, (Color){80, 80, 80, 200});
+
+    char center_buf[32];
+    format_hz(center_buf, sizeof(center_buf), frame->zoom_center_hz);
+
+    char title[128];
+    snprintf(title, sizeof(title), "ZOOM %s Hz  +/-%.1f Hz  |  %.2f Hz/bin", center_buf, frame->zoom_span_hz * 0.5, frame->zoom_bin_hz);
+    DrawTextEx(v->font, title, (Vector2){(f32)(panel_x + ui_px(10)), (f32)(panel_y + ui_px(6))}, text_size, 0, WHITE);
+
+    i32 trace_x = panel_x + ui_px(10);
+    i32 trace_y = panel_y + ui_px(30);
+    i32 trace_w = panel_w - ui_px(20);
+    i32 trace_h = panel_h - ui_px(58);
+    DrawRectangleLines(trace_x, trace_y, trace_w, trace_h, (Color){60, 60, 60, 200});
+    DrawLine(trace_x + trace_w / 2, trace_y, trace_x + trace_w / 2, trace_y + trace_h, (Color){255, 220, 80, 120});
+
+    char status[128];
+    if (frame->zoom_spectra == 0 || !frame->zoom_power)
+    {
+        f64 fill = (f64)frame->zoom_filled / (f64)ZOOM_FFT_SIZE;
+        snprintf(status, sizeof(status), "Collecting %.0f%%  (%.1f s window)", fill * 100.0, 1.0 / frame->zoom_bin_hz);
+    }
+    else
+    {
+        // Middle half of the transform: bins [N/4, 3N/4)
+        i32 first = ZOOM_FFT_SIZE / 4;
+        i32 count = ZOOM_FFT_SIZE / 2;
+        i32 peak = first;
+        Vector2 points[ZOOM_FFT_SIZE / 2];
+        for (i32 i = 0; i < count; i++)
+        {
+            f64 p = frame->zoom_power[first + i];
+            if (p > frame->zoom_power[peak])
+            {
+                peak = first + i;
+            }
+
+            f64 t = (power_to_db(p) - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+            t = (t < 0.0) ? 0.0 : ((t > 1.0) ? 1.0 : t);
+            points[i].x = (f32)trace_x + (f32)trace_w * (f32)i / (f32)(count - 1);
+            points[i].y = (f32)(trace_y + trace_h) - (f32)(t * (f64)trace_h);
+        }
+
+        BeginScissorMode(trace_x, trace_y, trace_w, trace_h);
+        DrawLineStrip(points, count, (Color){0, 255, 200, 230});
+        EndScissorMode();
+
+        char peak_buf[32];
+        format_hz(peak_buf, sizeof(peak_buf), frame->zoom_center_hz + (f64)(peak - ZOOM_FFT_SIZE / 2) * frame->zoom_bin_hz);
+        snprintf(status, sizeof(status), "Peak %s Hz  %5.1f dB", peak_buf, power_to_db(frame->zoom_power[peak]));
+    }
+    DrawTextEx(v->font, status, (Vector2){(f32)(panel_x + ui_px(10)), (f32)(trace_y + trace_h + ui_px(5))}, text_size, 0, (Color){210, 210, 210, 255});
+}
+
+// End-to-end (capture to screen) percentiles, with the analysis share in grey below
+internal void
+draw_latency_panel(const spectrum_view_t *v, const latency_report_t *latency, i32 right, i32 top)
+{
+    const f32 text_size = ui_text(18.0f);
+    char total[96];
+    char analysis[96];
+    snprintf(total, sizeof(total), "Latency p50 %5.1f ms  p99 %5.1f ms", latency->display_p50_ms, latency->display_p99_ms);
+    snprintf(analysis, sizeof(analysis), "Analysis p50 %5.1f ms  p99 %5.1f ms", latency->hop_p50_ms, latency->hop_p99_ms);
+
+    Vector2 total_size = MeasureTextEx(v->font, total, text_size, 0);
+    Vector2 analysis_size = MeasureTextEx(v->font, analysis, text_size, 0);
+    i32 panel_w = (i32)fmax(total_size.x, analysis_size.x) + ui_px(24);
+    i32 panel_h = (i32)(total_size.y + analysis_size.y) + ui_px(18);
+    i32 panel_x = right - panel_w;
+    DrawRectangle(panel_x, top, panel_w, panel_h, (Color){0, 0, 0, 155});
+    DrawRectangleLines(panel_x, top, panel_w, panel_h, (Color){80, 80, 80, 200});
+    DrawTextEx(v->font, total, (Vector2){(f32)(panel_x + ui_px(12)), (f32)(top + ui_px(7))}, text_size, 0, WHITE);
+    DrawTextEx(v->font, analysis, (Vector2){(f32)(panel_x + ui_px(12)), (f32)top + (f32)ui_px(11) + total_size.y}, text_size, 0, (Color){170, 170, 170, 255});
+}
+
+internal void
+draw_overlay(
+    const spectrum_view_t *v, const spectrum_frame_t *frame, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index,
+    const latency_report_t *latency
+)
 {
     const f32 info_text_size = ui_text(20.0f);
     const f32 mode_text_size = ui_text(18.0f);
@@ -133,76 +330,90 @@ draw_overlay(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_lock
     const f32 cursor_text_size = ui_text(19.0f);
 
     char info[192];
-    i32 sr = s->sample_rate;
-    i32 denom = (i32)(1.0 / s->fractional_octave);
+    i32 sr = frame->sample_rate;
+    i32 denom = (i32)(1.0 / frame->fractional_octave);
     if (denom <= 0)
     {
         denom = 1;
     }
 
-    snprintf(info, sizeof(info), "Sample Rate: %d Hz | Fractional Oct. 1/%d", sr, denom);
+    snprintf(info, sizeof(info), "Sample Rate: %d Hz | FFT %d / Hop %d | Fractional Oct. 1/%d", sr, frame->fft_size, frame->hop_size, denom);
 
     char modes[128];
     char hold_buf[16];
-    if (s->peak_hold_seconds <= 0.0)
+    if (frame->peak_hold_seconds <= 0.0)
     {
         snprintf(hold_buf, sizeof(hold_buf), "Off");
     }
     else
     {
-        snprintf(hold_buf, sizeof(hold_buf), "%.1fs", s->peak_hold_seconds);
+        snprintf(hold_buf, sizeof(hold_buf), "%.1fs", frame->peak_hold_seconds);
     }
 
-    // Show averaging mode with attack/release in ms
-    const char *avg_label = s->db_smoothing_enabled ? "dB" : "Lin";
-    f64 attack_ms = s->db_smoothing_enabled ? s->db_smooth_attack_ms : s->smooth_attack_ms;
-    f64 release_ms = s->db_smoothing_enabled ? s->db_smooth_release_ms : s->smooth_release_ms;
+    // Show averaging mode with attack/release in ms, or the bin averager's progress
+    char avg_buf[48];
+    if (frame->average_mode == AVERAGE_LINEAR)
+    {
+        snprintf(avg_buf, sizeof(avg_buf), "Lin %lld/%d", (long long)frame->average_count, frame->average_target);
+    }
+    else if (frame->average_mode == AVERAGE_EXPONENTIAL)
+    {
+        snprintf(avg_buf, sizeof(avg_buf), "Exp %d (%.1f s)", frame->average_target, (f64)frame->average_target * frame->seconds_per_window);
+    }
+    else if (frame->average_mode == AVERAGE_LEQ)
+    {
+        snprintf(avg_buf, sizeof(avg_buf), "Leq %lld (%.0f s)", (long long)frame->average_count, (f64)frame->average_count * frame->seconds_per_window);
+    }
+    else
+    {
+        snprintf(avg_buf, sizeof(avg_buf), "%s (%.0f/%.0f ms)", frame->db_smoothing_enabled ? "dB" : "Lin", frame->smooth_attack_ms, frame->smooth_release_ms);
+    }
 
     const char *freq_w = "Z";
-    if (s->frequency_weighting_mode == FREQ_WEIGHTING_A)
+    if (frame->frequency_weighting_mode == FREQ_WEIGHTING_A)
     {
         freq_w = "A";
     }
-    else if (s->frequency_weighting_mode == FREQ_WEIGHTING_C)
+    else if (frame->frequency_weighting_mode == FREQ_WEIGHTING_C)
     {
         freq_w = "C";
     }
 
     const char *time_w = "Fast";
-    if (s->time_weighting_mode == TIME_WEIGHTING_SLOW)
+    if (frame->time_weighting_mode == TIME_WEIGHTING_SLOW)
     {
         time_w = "Slow";
     }
-    else if (s->time_weighting_mode == TIME_WEIGHTING_IMPULSE)
+    else if (frame->time_weighting_mode == TIME_WEIGHTING_IMPULSE)
     {
         time_w = "Impulse";
     }
 
     const char *cal_txt;
-    if (!s->spl_features_enabled)
+    if (!frame->spl_features_enabled)
     {
         cal_txt = "N/A";
     }
     else
     {
-        cal_txt = s->spl_calibrated ? "On" : "Off";
+        cal_txt = frame->spl_calibrated ? "On" : "Off";
     }
 
     snprintf(
-        modes, sizeof(modes), "Avg: %s (%.0f/%.0f ms) | Pink: %s | Hold: %s | W: %s | T: %s | Cal: %s", avg_label, attack_ms, release_ms,
-        s->pinking_enabled ? "On" : "Off", hold_buf, freq_w, time_w, cal_txt
+        modes, sizeof(modes), "Avg: %s | Pink: %s | Hold: %s | W: %s | T: %s | Cal: %s", avg_buf, frame->pinking_enabled ? "On" : "Off", hold_buf,
+        freq_w, time_w, cal_txt
     );
 
-    Vector2 info_size = MeasureTextEx(s->font, info, info_text_size, 0);
-    Vector2 mode_size = MeasureTextEx(s->font, modes, mode_text_size, 0);
-    i32 panel_left = ui_px(72);
-    i32 panel_top = ui_px(12);
+    Vector2 info_size = MeasureTextEx(v->font, info, info_text_size, 0);
+    Vector2 mode_size = MeasureTextEx(v->font, modes, mode_text_size, 0);
+    i32 panel_left = v->layout_x + ui_px(72);
+    i32 panel_top = v->layout_y + ui_px(12);
     i32 panel_w = (i32)fmax(info_size.x, mode_size.x) + ui_px(24);
     i32 panel_h = ui_px(58);
     DrawRectangle(panel_left, panel_top, panel_w, panel_h, (Color){0, 0, 0, 155});
     DrawRectangleLines(panel_left, panel_top, panel_w, panel_h, (Color){80, 80, 80, 200});
-    DrawTextEx(s->font, info, (Vector2){(f32)(panel_left + ui_px(12)), (f32)(panel_top + ui_px(8))}, info_text_size, 0, WHITE);
-    DrawTextEx(s->font, modes, (Vector2){(f32)(panel_left + ui_px(12)), (f32)(panel_top + ui_px(30))}, mode_text_size, 0, (Color){210, 210, 210, 255});
+    DrawTextEx(v->font, info, (Vector2){(f32)(panel_left + ui_px(12)), (f32)(panel_top + ui_px(8))}, info_text_size, 0, WHITE);
+    DrawTextEx(v->font, modes, (Vector2){(f32)(panel_left + ui_px(12)), (f32)(panel_top + ui_px(30))}, mode_text_size, 0, (Color){210, 210, 210, 255});
 
     char meters[192];
     const char *peak_txt;
@@ -211,97 +422,103 @@ draw_overlay(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_lock
     const char *rms_spl_txt;
     char pkbuf[32], rmsbuf[32], pksplbuf[32], rmssplbuf[32];
 
-    if (isnan(s->meter_peak_dbfs_display))
+    if (isnan(frame->meter_peak_dbfs_display))
     {
         peak_txt = "--.-";
     }
-    else if (isinf(s->meter_peak_dbfs_display))
+    else if (isinf(frame->meter_peak_dbfs_display))
     {
         snprintf(pkbuf, sizeof(pkbuf), "-inf");
         peak_txt = pkbuf;
     }
     else
     {
-        snprintf(pkbuf, sizeof(pkbuf), "%.1f", s->meter_peak_dbfs_display);
+        snprintf(pkbuf, sizeof(pkbuf), "%.1f", frame->meter_peak_dbfs_display);
         peak_txt = pkbuf;
     }
 
-    if (isnan(s->meter_rms_dbfs_display))
+    if (isnan(frame->meter_rms_dbfs_display))
     {
         rms_txt = "--.-";
     }
-    else if (isinf(s->meter_rms_dbfs_display))
+    else if (isinf(frame->meter_rms_dbfs_display))
     {
         snprintf(rmsbuf, sizeof(rmsbuf), "-inf");
         rms_txt = rmsbuf;
     }
     else
     {
-        snprintf(rmsbuf, sizeof(rmsbuf), "%.1f", s->meter_rms_dbfs_display);
+        snprintf(rmsbuf, sizeof(rmsbuf), "%.1f", frame->meter_rms_dbfs_display);
         rms_txt = rmsbuf;
     }
 
-    if (!s->spl_features_enabled || !s->spl_calibrated || isnan(s->meter_peak_dbspl_display))
+    if (!frame->spl_features_enabled || !frame->spl_calibrated || isnan(frame->meter_peak_dbspl_display))
     {
         peak_spl_txt = "--.-";
     }
-    else if (isinf(s->meter_peak_dbspl_display))
+    else if (isinf(frame->meter_peak_dbspl_display))
     {
         snprintf(pksplbuf, sizeof(pksplbuf), "-inf");
         peak_spl_txt = pksplbuf;
     }
     else
     {
-        snprintf(pksplbuf, sizeof(pksplbuf), "%.1f", s->meter_peak_dbspl_display);
+        snprintf(pksplbuf, sizeof(pksplbuf), "%.1f", frame->meter_peak_dbspl_display);
         peak_spl_txt = pksplbuf;
     }
 
-    if (!s->spl_features_enabled || !s->spl_calibrated || isnan(s->meter_rms_dbspl_display))
+    if (!frame->spl_features_enabled || !frame->spl_calibrated || isnan(frame->meter_rms_dbspl_display))
     {
         rms_spl_txt = "--.-";
     }
-    else if (isinf(s->meter_rms_dbspl_display))
+    else if (isinf(frame->meter_rms_dbspl_display))
     {
         snprintf(rmssplbuf, sizeof(rmssplbuf), "-inf");
         rms_spl_txt = rmssplbuf;
     }
     else
     {
-        snprintf(rmssplbuf, sizeof(rmssplbuf), "%.1f", s->meter_rms_dbspl_display);
+        snprintf(rmssplbuf, sizeof(rmssplbuf), "%.1f", frame->meter_rms_dbspl_display);
         rms_spl_txt = rmssplbuf;
     }
 
     snprintf(meters, sizeof(meters), "Peak: %6s dBFS  %6s dBSPL\nRMS:  %6s dBFS  %6s dBSPL", peak_txt, peak_spl_txt, rms_txt, rms_spl_txt);
 
-    Vector2 meter_size = MeasureTextEx(s->font, meters, meter_text_size, 0);
+    Vector2 meter_size = MeasureTextEx(v->font, meters, meter_text_size, 0);
     i32 meter_panel_w = (i32)meter_size.x + ui_px(24);
     i32 meter_panel_h = (i32)meter_size.y + ui_px(14);
-    i32 meter_panel_x = s->plot_left + s->plot_width - meter_panel_w - ui_px(12);
-    i32 meter_panel_y = ui_px(12);
+    i32 meter_panel_x = v->plot_left + v->plot_width - meter_panel_w - ui_px(12);
+    i32 meter_panel_y = v->layout_y + ui_px(12);
     DrawRectangle(meter_panel_x, meter_panel_y, meter_panel_w, meter_panel_h, (Color){0, 0, 0, 155});
     DrawRectangleLines(meter_panel_x, meter_panel_y, meter_panel_w, meter_panel_h, (Color){80, 80, 80, 200});
-    Color meter_color = s->spl_features_enabled ? WHITE : (Color){170, 170, 170, 255};
-    DrawTextEx(s->font, meters, (Vector2){(f32)(meter_panel_x + ui_px(12)), (f32)(meter_panel_y + ui_px(8))}, meter_text_size, 0, meter_color);
+    Color meter_color = frame->spl_features_enabled ? WHITE : (Color){170, 170, 170, 255};
+    DrawTextEx(v->font, meters, (Vector2){(f32)(meter_panel_x + ui_px(12)), (f32)(meter_panel_y + ui_px(8))}, meter_text_size, 0, meter_color);
+
+    if (latency)
+    {
+        draw_latency_panel(v, latency, meter_panel_x + meter_panel_w, meter_panel_y + meter_panel_h + ui_px(6));
+    }
 
     i32 active_index = -1;
-    if (cursor_lock_enabled && cursor_locked_index >= 0 && cursor_locked_index < s->num_bars)
+    if (cursor_lock_enabled && cursor_locked_index >= 0 && cursor_locked_index < v->num_bars)
     {
         active_index = cursor_locked_index;
     }
-    else if (cursor_hover_index >= 0 && cursor_hover_index < s->num_bars)
+    else if (cursor_hover_index >= 0 && cursor_hover_index < v->num_bars)
     {
         active_index = cursor_hover_index;
     }
 
-    if (active_index >= 0)
+    // A frame captured before a resize still has the old bars
+    if (active_index >= 0 && active_index < frame->num_bars)
     {
         local_persist i32 cursor_display_index = -1;
         local_persist f64 cursor_live_db_display = DB_BOTTOM;
         local_persist f64 cursor_max_db_display = DB_BOTTOM;
 
-        f64 f = s->bar_freq_center[active_index];
-        f64 live_db_target = power_to_db(s->bar_smoothed[active_index]);
-        f64 max_db_target = power_to_db(s->max_hold_power[active_index]);
+        f64 f = frame->bar_freq_center[active_index];
+        f64 live_db_target = power_to_db(frame->bar_smoothed[active_index]);
+        f64 max_db_target = power_to_db(frame->max_hold_power[active_index]);
         if (live_db_target < DB_BOTTOM)
         {
             live_db_target = DB_BOTTOM;
@@ -349,36 +566,80 @@ draw_overlay(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_lock
 
         char cursor_info[192];
         const char *mode = cursor_lock_enabled ? "LOCK" : "HOVER";
-        snprintf(cursor_info, sizeof(cursor_info), "%s  %s Hz  |  Live %5.1f dB  |  Max %5.1f dB", mode, fbuf, live_db, max_db);
+        if (frame->average_mode != AVERAGE_OFF)
+        {
+            f64 density_db = power_to_db(spectrum_frame_bar_density(frame, active_index, frame->bar_smoothed[active_index]));
+            snprintf(cursor_info, sizeof(cursor_info), "%s  %s Hz  |  Avg %5.1f dB  |  %5.1f dB/Hz  |  Max %5.1f dB", mode, fbuf, live_db, density_db, max_db);
+        }
+        else
+        {
+            snprintf(cursor_info, sizeof(cursor_info), "%s  %s Hz  |  Live %5.1f dB  |  Max %5.1f dB", mode, fbuf, live_db, max_db);
+        }
 
-        Vector2 cursor_size = MeasureTextEx(s->font, cursor_info, cursor_text_size, 0);
-        i32 cursor_panel_x = ui_px(72);
-        i32 cursor_panel_y = s->plot_top + s->plot_height - ui_px(42);
+        Vector2 cursor_size = MeasureTextEx(v->font, cursor_info, cursor_text_size, 0);
+        i32 cursor_panel_x = v->layout_x + ui_px(72);
+        i32 cursor_panel_y = v->plot_top + v->plot_height - ui_px(42);
         i32 cursor_panel_w = (i32)cursor_size.x + ui_px(22);
         i32 cursor_panel_h = ui_px(32);
         DrawRectangle(cursor_panel_x, cursor_panel_y, cursor_panel_w, cursor_panel_h, (Color){0, 0, 0, 242});
         DrawRectangleLines(cursor_panel_x, cursor_panel_y, cursor_panel_w, cursor_panel_h, (Color){80, 80, 80, 200});
-        DrawTextEx(s->font, cursor_info, (Vector2){(f32)(cursor_panel_x + ui_px(11)), (f32)(cursor_panel_y + ui_px(7))}, cursor_text_size, 0, WHITE);
+        DrawTextEx(v->font, cursor_info, (Vector2){(f32)(cursor_panel_x + ui_px(11)), (f32)(cursor_panel_y + ui_px(7))}, cursor_text_size, 0, WHITE);
+
+        if (frame->zoom_enabled)
+        {
+            draw_zoom_panel(v, frame, cursor_panel_x + cursor_panel_w + ui_px(10), cursor_panel_y + cursor_panel_h);
+        }
 
         i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
-        i32 cx = s->plot_left + active_index * stride + BAR_PIXEL_WIDTH / 2;
+        i32 cx = v->plot_left + active_index * stride + BAR_PIXEL_WIDTH / 2;
         Color cursor_line = cursor_lock_enabled ? (Color){255, 220, 80, 220} : (Color){255, 255, 255, 110};
-        DrawLine(cx, s->plot_top, cx, s->plot_top + s->plot_height, cursor_line);
+        DrawLine(cx, v->plot_top, cx, v->plot_top + v->plot_height, cursor_line);
     }
 }
 
 void
-render_draw(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index, i32 show_paused_overlay)
+render_draw(
+    const spectrum_view_t *v, const spectrum_frame_t *frame, i32 cursor_lock_enabled, i32 cursor_locked_index, i32 cursor_hover_index,
+    i32 show_paused_overlay, const latency_report_t *latency
+)
 {
-    draw_db_grid(s);
-    draw_freq_grid(s);
+    // Views from another bar layout wait for the analysis to catch up; the mono bars show meanwhile
+    i32 views = (frame->num_bars == v->num_bars) ? frame->channel_views : 0;
+    i32 stacked = views > 0 && frame->channel_layout == CHANNEL_LAYOUT_STACK;
 
-    DrawTexturePro(
-        s->fft_rt.texture, (Rectangle){0, 0, (f32)s->fft_rt.texture.width, (f32)-s->fft_rt.texture.height},
-        (Rectangle){(f32)s->plot_left, (f32)s->plot_top, (f32)s->plot_width, (f32)s->plot_height}, (Vector2){0, 0}, 0, WHITE
-    );
+    // The strips have no common dB scale
+    if (!stacked)
+    {
+        draw_db_grid(v);
+    }
+    draw_freq_grid(v, frame);
+
+    if (stacked)
+    {
+        draw_channel_stack(v, frame);
+    }
+    else
+    {
+        DrawTexturePro(
+            v->fft_rt.texture, (Rectangle){0, 0, (f32)v->fft_rt.texture.width, (f32)-v->fft_rt.texture.height},
+            (Rectangle){(f32)v->plot_left, (f32)v->plot_top, (f32)v->plot_width, (f32)v->plot_height}, (Vector2){0, 0}, 0, WHITE
+        );
+    }
+
+    if (views > 0 && frame->channel_layout == CHANNEL_LAYOUT_OVERLAY)
+    {
+        draw_channel_traces(v, frame);
+    }
+
+    if (v->waterfall.enabled)
+    {
+        // Columns line up with the bars above: one texel per bar, stretched over the bar stride
+        i32 waterfall_w = v->num_bars * (BAR_PIXEL_WIDTH + BAR_GAP);
+        waterfall_draw(&v->waterfall, (Rectangle){(f32)v->plot_left, (f32)v->waterfall_top, (f32)waterfall_w, (f32)v->waterfall_height});
+        DrawRectangleLines(v->plot_left, v->waterfall_top, waterfall_w, v->waterfall_height, (Color){80, 80, 80, 200});
+    }
 
-    draw_overlay(s, cursor_lock_enabled, cursor_locked_index, cursor_hover_index);
+    draw_overlay(v, frame, cursor_lock_enabled, cursor_locked_index, cursor_hover_index, latency);
 
     if (show_paused_overlay)
     {
@@ -388,8 +649,40 @@ render_draw(const spectrum_state_t *s, i32 cursor_lock_enabled, i32 cursor_locke
 
         const char *paused_text = "Playback paused";
         f32 paused_text_size = ui_text(40.0f);
-        Vector2 paused_text_dims = MeasureTextEx(s->font, paused_text, paused_text_size, 0);
+        Vector2 paused_text_dims = MeasureTextEx(v->font, paused_text, paused_text_size, 0);
         Vector2 paused_text_pos = {(f32)sw / 2.0f - paused_text_dims.x / 2.0f, (f32)sh / 2.0f - paused_text_dims.y / 2.0f};
-        DrawTextEx(s->font, paused_text, paused_text_pos, paused_text_size, 0, WHITE);
+        DrawTextEx(v->font, paused_text, paused_text_pos, paused_text_size, 0, WHITE);
+    }
+}
+
+void
+render_draw_profiler(const spectrum_view_t *v, const perf_report_t *r)
+{
+    const f32 text_size = ui_text(17.0f);
+    char lines[NUM_PERF_STAGES + 1][96];
+    snprintf(lines[0], sizeof(lines[0]), "%-12s %6s %8s %8s %8s %8s", "Stage (us)", "n", "min", "p50", "p99", "max");
+    for (i32 i = 0; i < NUM_PERF_STAGES; i++)
+    {
+        const perf_stage_report_t *st = &r->stages[i];
+        snprintf(
+            lines[i + 1], sizeof(lines[i + 1]), "%-12s %6llu %8.1f %8.1f %8.1f %8.1f", perf_stage_label(i), (unsigned long long)st->count, st->min_us,
+            st->p50_us, st->p99_us, st->max_us
+        );
+    }
+
+    Vector2 line_size = MeasureTextEx(v->font, lines[0], text_size, 0);
+    f32 line_h = line_size.y + (f32)ui_px(3);
+    i32 panel_left = v->layout_x + ui_px(72);
+    i32 panel_top = v->layout_y + ui_px(78);
+    i32 panel_w = (i32)line_size.x + ui_px(24);
+    i32 panel_h = (i32)(line_h * (f32)(NUM_PERF_STAGES + 1)) + ui_px(14);
+    DrawRectangle(panel_left, panel_top, panel_w, panel_h, (Color){0, 0, 0, 215});
+    DrawRectangleLines(panel_left, panel_top, panel_w, panel_h, (Color){80, 80, 80, 200});
+    for (i32 i = 0; i <= NUM_PERF_STAGES; i++)
+    {
+        // Stages idle this interval are dimmed
+        Color color = (i == 0 || r->stages[i - 1].count == 0) ? (Color){170, 170, 170, 255} : WHITE;
+        Vector2 pos = {(f32)(panel_left + ui_px(12)), (f32)(panel_top + ui_px(7)) + line_h * (f32)i};
+        DrawTextEx(v->font, lines[i], pos, text_size, 0, color);
     }
 }
@@ -0,0 +1,749 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+#include "macros.h"
+#include "simd.h"
+#include "spectrum_log.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_X86 0
+#endif
+
+global const char *SIMD_ISA_NAMES[NUM_SIMD_ISAS] = {"scalar", "sse2", "avx2", "avx512"};
+
+// Selected once (pthread_once), then read lock-free: kernels_ready is published with release
+// after active_kernels is stored, so analysers created on any thread see complete kernels
+global simd_kernels_t active_kernels;
+global i32 kernels_ready = 0;
+global pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+// Scalar reference kernels; the vector kernels use them for their tails
+
+internal void
+downmix_stereo_scalar(const f32 *src, f32 *mono, i32 frames)
+{
+    for (i32 i = 0; i < frames; i++)
+    {
+        mono[i] = 0.5f * (src[2 * i] + src[2 * i + 1]);
+    }
+}
+
+internal void
+deinterleave_scalar(const f32 *src, i32 channels, f32 *dst, i32 stride, i32 frames)
+{
+    for (i32 c = 0; c < channels; c++)
+    {
+        f32 *out = dst + (usize)c * (usize)stride;
+        for (i32 i = 0; i < frames; i++)
+        {
+            out[i] = src[(usize)i * (usize)channels + (usize)c];
+        }
+    }
+}
+
+internal void
+multiply_scalar(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    for (i32 i = 0; i < count; i++)
+    {
+        dst[i] = src[i] * window[i];
+    }
+}
+
+internal void
+power_scalar(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    for (i32 i = 0; i < bins; i++)
+    {
+        spectrum_real_t re = src[2 * i];
+        spectrum_real_t im = src[2 * i + 1];
+        dst[i] = (re * re + im * im) * scale;
+    }
+}
+
+#if SIMD_X86
+
+// SSE2 (4 x f32 / 2 x f64)
+
+SIMD_TARGET("sse2") internal void
+downmix_stereo_sse2(const f32 *src, f32 *mono, i32 frames)
+{
+    __m128 half = _mm_set1_ps(0.5f);
+    i32 i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(src + 2 * i);
+        __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(mono + i, _mm_mul_ps(half, _mm_add_ps(l, r)));
+    }
+
+    downmix_stereo_scalar(src + 2 * i, mono + i, frames - i);
+}
+
+// Stereo splits pairs like the downmix; 4 and 8 channels go through 4x4 transposes of four
+// frames by four channels
+SIMD_TARGET("sse2") internal void
+deinterleave_sse2(const f32 *src, i32 channels, f32 *dst, i32 stride, i32 frames)
+{
+    i32 i = 0;
+    if (channels == 2)
+    {
+        f32 *l = dst;
+        f32 *r = dst + stride;
+        for (; i + 4 <= frames; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(src + 2 * i);
+            __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+            _mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    else if (channels == 4 || channels == 8)
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            const f32 *in = src + (usize)i * (usize)channels;
+            for (i32 g = 0; g < channels; g += 4)
+            {
+                __m128 r0 = _mm_loadu_ps(in + g);
+                __m128 r1 = _mm_loadu_ps(in + channels + g);
+                __m128 r2 = _mm_loadu_ps(in + 2 * channels + g);
+                __m128 r3 = _mm_loadu_ps(in + 3 * channels + g);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(dst + (usize)g * (usize)stride + i, r0);
+                _mm_storeu_ps(dst + (usize)(g + 1) * (usize)stride + i, r1);
+                _mm_storeu_ps(dst + (usize)(g + 2) * (usize)stride + i, r2);
+                _mm_storeu_ps(dst + (usize)(g + 3) * (usize)stride + i, r3);
+            }
+        }
+    }
+
+    deinterleave_scalar(src + (usize)i * (usize)channels, channels, dst + i, stride, frames - i);
+}
+
+#ifdef SPECTRUM_SINGLE_PRECISION
+
+SIMD_TARGET("sse2") internal void
+multiply_sse2(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("sse2") internal void
+power_sse2(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f32 *in = src;
+    __m128 vscale = _mm_set1_ps(scale);
+    i32 i = 0;
+    for (; i + 4 <= bins; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(in + 2 * i);
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(re, im), vscale));
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#else
+
+SIMD_TARGET("sse2") internal void
+multiply_sse2(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(src + i), _mm_loadu_pd(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("sse2") internal void
+power_sse2(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f64 *in = src;
+    __m128d vscale = _mm_set1_pd(scale);
+    i32 i = 0;
+    for (; i + 2 <= bins; i += 2)
+    {
+        __m128d a = _mm_loadu_pd(in + 2 * i);
+        __m128d b = _mm_loadu_pd(in + 2 * i + 2);
+        a = _mm_mul_pd(a, a);
+        b = _mm_mul_pd(b, b);
+        __m128d re = _mm_unpacklo_pd(a, b);
+        __m128d im = _mm_unpackhi_pd(a, b);
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_add_pd(re, im), vscale));
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#endif // SPECTRUM_SINGLE_PRECISION
+
+// AVX2 (8 x f32 / 4 x f64). In-lane shuffles leave 64-bit pairs in 0,2,1,3 order; the
+// cross-lane permute puts them back.
+
+SIMD_TARGET("avx2") internal void
+downmix_stereo_avx2(const f32 *src, f32 *mono, i32 frames)
+{
+    __m256 half = _mm256_set1_ps(0.5f);
+    i32 i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m256 a = _mm256_loadu_ps(src + 2 * i);
+        __m256 b = _mm256_loadu_ps(src + 2 * i + 8);
+        __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 m = _mm256_mul_ps(half, _mm256_add_ps(l, r));
+        m = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(m), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(mono + i, m);
+    }
+
+    downmix_stereo_scalar(src + 2 * i, mono + i, frames - i);
+}
+
+// Stereo as in the downmix; 8 channels as an 8x8 transpose of eight frames (unpack, shuffle,
+// then swap 128-bit halves). 4 channels stay on the SSE2 transpose.
+SIMD_TARGET("avx2") internal void
+deinterleave_avx2(const f32 *src, i32 channels, f32 *dst, i32 stride, i32 frames)
+{
+    i32 i = 0;
+    if (channels == 2)
+    {
+        f32 *l = dst;
+        f32 *r = dst + stride;
+        for (; i + 8 <= frames; i += 8)
+        {
+            __m256 a = _mm256_loadu_ps(src + 2 * i);
+            __m256 b = _mm256_loadu_ps(src + 2 * i + 8);
+            __m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm256_storeu_ps(l + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), _MM_SHUFFLE(3, 1, 2, 0))));
+            _mm256_storeu_ps(r + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(odd), _MM_SHUFFLE(3, 1, 2, 0))));
+        }
+    }
+    else if (channels == 8)
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            const f32 *in = src + (usize)i * 8;
+            __m256 r[8];
+            __m256 t[8];
+            for (i32 k = 0; k < 8; k++)
+            {
+                r[k] = _mm256_loadu_ps(in + 8 * k);
+            }
+            for (i32 k = 0; k < 8; k += 2)
+            {
+                t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+                t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+            }
+            for (i32 k = 0; k < 8; k += 4)
+            {
+                r[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            for (i32 c = 0; c < 4; c++)
+            {
+                _mm256_storeu_ps(dst + (usize)c * (usize)stride + i, _mm256_permute2f128_ps(r[c], r[c + 4], 0x20));
+                _mm256_storeu_ps(dst + (usize)(c + 4) * (usize)stride + i, _mm256_permute2f128_ps(r[c], r[c + 4], 0x31));
+            }
+        }
+    }
+    else
+    {
+        deinterleave_sse2(src, channels, dst, stride, frames);
+        return;
+    }
+
+    deinterleave_scalar(src + (usize)i * (usize)channels, channels, dst + i, stride, frames - i);
+}
+
+#ifdef SPECTRUM_SINGLE_PRECISION
+
+SIMD_TARGET("avx2") internal void
+multiply_avx2(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), _mm256_loadu_ps(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("avx2") internal void
+power_avx2(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f32 *in = src;
+    __m256 vscale = _mm256_set1_ps(scale);
+    i32 i = 0;
+    for (; i + 8 <= bins; i += 8)
+    {
+        __m256 a = _mm256_loadu_ps(in + 2 * i);
+        __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+        a = _mm256_mul_ps(a, a);
+        b = _mm256_mul_ps(b, b);
+        __m256 re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 p = _mm256_mul_ps(_mm256_add_ps(re, im), vscale);
+        p = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(p), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(dst + i, p);
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#else
+
+SIMD_TARGET("avx2") internal void
+multiply_avx2(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(src + i), _mm256_loadu_pd(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("avx2") internal void
+power_avx2(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f64 *in = src;
+    __m256d vscale = _mm256_set1_pd(scale);
+    i32 i = 0;
+    for (; i + 4 <= bins; i += 4)
+    {
+        __m256d a = _mm256_loadu_pd(in + 2 * i);
+        __m256d b = _mm256_loadu_pd(in + 2 * i + 4);
+        a = _mm256_mul_pd(a, a);
+        b = _mm256_mul_pd(b, b);
+
+        // hadd pairs re^2 + im^2 per complex value: bins 0, 2, 1, 3
+        __m256d p = _mm256_mul_pd(_mm256_hadd_pd(a, b), vscale);
+        _mm256_storeu_pd(dst + i, _mm256_permute4x64_pd(p, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#endif // SPECTRUM_SINGLE_PRECISION
+
+// AVX-512F (16 x f32 / 8 x f64). Two-source permutes split interleaved pairs into even/odd.
+
+SIMD_TARGET("avx512f") internal void
+downmix_stereo_avx512(const f32 *src, f32 *mono, i32 frames)
+{
+    __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+    __m512i odd = _mm512_add_epi32(even, _mm512_set1_epi32(1));
+    __m512 half = _mm512_set1_ps(0.5f);
+    i32 i = 0;
+    for (; i + 16 <= frames; i += 16)
+    {
+        __m512 a = _mm512_loadu_ps(src + 2 * i);
+        __m512 b = _mm512_loadu_ps(src + 2 * i + 16);
+        __m512 l = _mm512_permutex2var_ps(a, even, b);
+        __m512 r = _mm512_permutex2var_ps(a, odd, b);
+        _mm512_storeu_ps(mono + i, _mm512_mul_ps(half, _mm512_add_ps(l, r)));
+    }
+
+    downmix_stereo_scalar(src + 2 * i, mono + i, frames - i);
+}
+
+#ifdef SPECTRUM_SINGLE_PRECISION
+
+SIMD_TARGET("avx512f") internal void
+multiply_avx512(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_loadu_ps(src + i), _mm512_loadu_ps(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("avx512f") internal void
+power_avx512(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f32 *in = src;
+    __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+    __m512i odd = _mm512_add_epi32(even, _mm512_set1_epi32(1));
+    __m512 vscale = _mm512_set1_ps(scale);
+    i32 i = 0;
+    for (; i + 16 <= bins; i += 16)
+    {
+        __m512 a = _mm512_loadu_ps(in + 2 * i);
+        __m512 b = _mm512_loadu_ps(in + 2 * i + 16);
+        a = _mm512_mul_ps(a, a);
+        b = _mm512_mul_ps(b, b);
+        __m512 re = _mm512_permutex2var_ps(a, even, b);
+        __m512 im = _mm512_permutex2var_ps(a, odd, b);
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_add_ps(re, im), vscale));
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#else
+
+SIMD_TARGET("avx512f") internal void
+multiply_avx512(spectrum_real_t *dst, const spectrum_real_t *src, const spectrum_real_t *window, i32 count)
+{
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm512_storeu_pd(dst + i, _mm512_mul_pd(_mm512_loadu_pd(src + i), _mm512_loadu_pd(window + i)));
+    }
+
+    multiply_scalar(dst + i, src + i, window + i, count - i);
+}
+
+SIMD_TARGET("avx512f") internal void
+power_avx512(spectrum_real_t *dst, const spectrum_real_t *src, i32 bins, spectrum_real_t scale)
+{
+    const f64 *in = src;
+    __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    __m512i odd = _mm512_add_epi64(even, _mm512_set1_epi64(1));
+    __m512d vscale = _mm512_set1_pd(scale);
+    i32 i = 0;
+    for (; i + 8 <= bins; i += 8)
+    {
+        __m512d a = _mm512_loadu_pd(in + 2 * i);
+        __m512d b = _mm512_loadu_pd(in + 2 * i + 8);
+        a = _mm512_mul_pd(a, a);
+        b = _mm512_mul_pd(b, b);
+        __m512d re = _mm512_permutex2var_pd(a, even, b);
+        __m512d im = _mm512_permutex2var_pd(a, odd, b);
+        _mm512_storeu_pd(dst + i, _mm512_mul_pd(_mm512_add_pd(re, im), vscale));
+    }
+
+    power_scalar(dst + i, src + 2 * i, bins - i, scale);
+}
+
+#endif // SPECTRUM_SINGLE_PRECISION
+
+#endif // SIMD_X86
+
+internal i32
+isa_supported(i32 isa)
+{
+    if (isa == SIMD_ISA_SCALAR)
+    {
+        return 1;
+    }
+
+#if SIMD_X86
+    __builtin_cpu_init();
+    if (isa == SIMD_ISA_SSE2)
+    {
+        return __builtin_cpu_supports("sse2");
+    }
+    if (isa == SIMD_ISA_AVX2)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (isa == SIMD_ISA_AVX512)
+    {
+        return __builtin_cpu_supports("avx512f");
+    }
+#endif
+
+    return 0;
+}
+
+internal simd_kernels_t
+kernels_for_isa(i32 isa)
+{
+    simd_kernels_t k = {SIMD_ISA_SCALAR, downmix_stereo_scalar, deinterleave_scalar, multiply_scalar, power_scalar};
+
+#if SIMD_X86
+    if (isa == SIMD_ISA_SSE2)
+    {
+        k = (simd_kernels_t){isa, downmix_stereo_sse2, deinterleave_sse2, multiply_sse2, power_sse2};
+    }
+    else if (isa == SIMD_ISA_AVX2)
+    {
+        k = (simd_kernels_t){isa, downmix_stereo_avx2, deinterleave_avx2, multiply_avx2, power_avx2};
+    }
+    else if (isa == SIMD_ISA_AVX512)
+    {
+        // The de-interleave is bound by its strided stores, so AVX-512 keeps the AVX2 one
+        k = (simd_kernels_t){isa, downmix_stereo_avx512, deinterleave_avx2, multiply_avx512, power_avx512};
+    }
+#else
+    (void)isa;
+#endif
+
+    return k;
+}
+
+internal void
+select_kernels(void)
+{
+    i32 best = SIMD_ISA_SCALAR;
+    for (i32 isa = SIMD_ISA_SCALAR + 1; isa < NUM_SIMD_ISAS; isa++)
+    {
+        if (isa_supported(isa))
+        {
+            best = isa;
+        }
+    }
+
+    // SPECTRUM_SIMD=scalar|sse2|avx2|avx512 caps the selection (comparisons, debugging)
+    const char *forced = getenv("SPECTRUM_SIMD");
+    if (forced && *forced)
+    {
+        i32 found = 0;
+        for (i32 isa = 0; isa < NUM_SIMD_ISAS; isa++)
+        {
+            if (strcmp(forced, SIMD_ISA_NAMES[isa]) == 0)
+            {
+                found = 1;
+                if (isa < best)
+                {
+                    best = isa;
+                }
+            }
+        }
+
+        if (!found)
+        {
+            spectrum_log(SPECTRUM_LOG_WARNING, "Unknown SPECTRUM_SIMD value '%s', using %s", forced, SIMD_ISA_NAMES[best]);
+        }
+    }
+
+    active_kernels = kernels_for_isa(best);
+    __atomic_store_n(&kernels_ready, 1, __ATOMIC_RELEASE);
+}
+
+void
+simd_init(void)
+{
+    pthread_once(&kernels_once, select_kernels);
+}
+
+const simd_kernels_t *
+simd_kernels(void)
+{
+    if (!__atomic_load_n(&kernels_ready, __ATOMIC_ACQUIRE))
+    {
+        simd_init();
+    }
+
+    return &active_kernels;
+}
+
+const char *
+simd_isa_name(i32 isa)
+{
+    if (isa < 0 || isa >= NUM_SIMD_ISAS)
+    {
+        return "unknown";
+    }
+
+    return SIMD_ISA_NAMES[isa];
+}
+
+// Self-test: deterministic noise, odd lengths for the scalar tails, +1 offsets for unaligned access
+
+internal u32
+selftest_rand(u32 *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state;
+}
+
+internal f64
+selftest_noise(u32 *state)
+{
+    return ((f64)(selftest_rand(state) >> 8) / (f64)(1u << 24)) * 2.0 - 1.0;
+}
+
+internal f64
+max_rel_err_f32(const f32 *a, const f32 *b, i32 count)
+{
+    f64 worst = 0.0;
+    for (i32 i = 0; i < count; i++)
+    {
+        f64 ref = fabs((f64)a[i]);
+        f64 err = fabs((f64)a[i] - (f64)b[i]) / ((ref > 1e-30) ? ref : 1e-30);
+        worst = (err > worst) ? err : worst;
+    }
+
+    return worst;
+}
+
+internal f64
+max_rel_err_real(const spectrum_real_t *a, const spectrum_real_t *b, i32 count)
+{
+    f64 worst = 0.0;
+    for (i32 i = 0; i < count; i++)
+    {
+        f64 ref = fabs((f64)a[i]);
+        f64 err = fabs((f64)a[i] - (f64)b[i]) / ((ref > 1e-30) ? ref : 1e-30);
+        worst = (err > worst) ? err : worst;
+    }
+
+    return worst;
+}
+
+i32
+simd_self_test(void)
+{
+    local_persist const i32 lengths[] = {0, 1, 3, 7, 8, 15, 16, 17, 31, 33, 64, 257, 1000, 4097};
+    local_persist const i32 channel_counts[] = {1, 2, 3, 4, 6, 8};
+    const i32 max_len = 4097 + 1;
+    const i32 max_channels = 8;
+
+#ifdef SPECTRUM_SINGLE_PRECISION
+    const f64 real_eps = (f64)FLT_EPSILON;
+#else
+    const f64 real_eps = DBL_EPSILON;
+#endif
+
+    f32 *interleaved = (f32 *)malloc((size_t)(max_channels * max_len) * sizeof(f32));
+    f32 *mono_ref = (f32 *)malloc((size_t)(max_channels * max_len) * sizeof(f32));
+    f32 *mono_out = (f32 *)malloc((size_t)(max_channels * max_len) * sizeof(f32));
+    spectrum_real_t *src = (spectrum_real_t *)malloc((size_t)(2 * max_len) * sizeof(spectrum_real_t));
+    spectrum_real_t *window = (spectrum_real_t *)malloc((size_t)max_len * sizeof(spectrum_real_t));
+    spectrum_real_t *real_ref = (spectrum_real_t *)malloc((size_t)max_len * sizeof(spectrum_real_t));
+    spectrum_real_t *real_out = (spectrum_real_t *)malloc((size_t)max_len * sizeof(spectrum_real_t));
+    if (!interleaved || !mono_ref || !mono_out || !src || !window || !real_ref || !real_out)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to allocate self-test buffers");
+        free(interleaved);
+        free(mono_ref);
+        free(mono_out);
+        free(src);
+        free(window);
+        free(real_ref);
+        free(real_out);
+        return 0;
+    }
+
+    u32 seed = 0x2545f491u;
+    for (i32 i = 0; i < max_channels * max_len; i++)
+    {
+        interleaved[i] = (f32)selftest_noise(&seed);
+    }
+    for (i32 i = 0; i < 2 * max_len; i++)
+    {
+        src[i] = (spectrum_real_t)(selftest_noise(&seed) * 100.0);
+    }
+    for (i32 i = 0; i < max_len; i++)
+    {
+        window[i] = (spectrum_real_t)(0.5 + 0.5 * selftest_noise(&seed));
+    }
+
+    simd_init();
+    printf("SIMD self-test (%s precision, active: %s)\n", SPECTRUM_PRECISION_LABEL, simd_isa_name(active_kernels.isa));
+
+    simd_kernels_t ref = kernels_for_isa(SIMD_ISA_SCALAR);
+    i32 all_ok = 1;
+    for (i32 isa = SIMD_ISA_SCALAR + 1; isa < NUM_SIMD_ISAS; isa++)
+    {
+        if (!isa_supported(isa))
+        {
+            printf("  %-7s skipped (not supported by this CPU)\n", simd_isa_name(isa));
+            continue;
+        }
+
+        simd_kernels_t k = kernels_for_isa(isa);
+        f64 err_downmix = 0.0;
+        f64 err_deinterleave = 0.0;
+        f64 err_multiply = 0.0;
+        f64 err_power = 0.0;
+
+        for (usize li = 0; li < ARRAY_COUNT(lengths); li++)
+        {
+            for (i32 offset = 0; offset <= 1; offset++)
+            {
+                i32 n = lengths[li];
+                f64 e;
+
+                ref.downmix_stereo(interleaved + offset, mono_ref, n);
+                k.downmix_stereo(interleaved + offset, mono_out, n);
+                e = max_rel_err_f32(mono_ref, mono_out, n);
+                err_downmix = (e > err_downmix) ? e : err_downmix;
+
+                // Planes max_len apart, so every channel's tail is checked
+                for (usize ci = 0; ci < ARRAY_COUNT(channel_counts); ci++)
+                {
+                    i32 channels = channel_counts[ci];
+                    ref.deinterleave(interleaved + offset, channels, mono_ref, max_len, n);
+                    k.deinterleave(interleaved + offset, channels, mono_out, max_len, n);
+                    for (i32 c = 0; c < channels; c++)
+                    {
+                        e = max_rel_err_f32(mono_ref + (usize)c * (usize)max_len, mono_out + (usize)c * (usize)max_len, n);
+                        err_deinterleave = (e > err_deinterleave) ? e : err_deinterleave;
+                    }
+                }
+
+                ref.multiply(real_ref, src + offset, window + offset, n);
+                k.multiply(real_out, src + offset, window + offset, n);
+                e = max_rel_err_real(real_ref, real_out, n);
+                err_multiply = (e > err_multiply) ? e : err_multiply;
+
+                // In-place use, as in the analysis path
+                memcpy(real_out, src + offset, (size_t)n * sizeof(spectrum_real_t));
+                k.multiply(real_out, real_out, window + offset, n);
+                e = max_rel_err_real(real_ref, real_out, n);
+                err_multiply = (e > err_multiply) ? e : err_multiply;
+
+                ref.power(real_ref, src + offset, n / 2, (spectrum_real_t)1e-3);
+                k.power(real_out, src + offset, n / 2, (spectrum_real_t)1e-3);
+                e = max_rel_err_real(real_ref, real_out, n / 2);
+                err_power = (e > err_power) ? e : err_power;
+            }
+        }
+
+        // The de-interleave only moves values, so it has to be exact
+        const char *names[4] = {"downmix", "deinterleave", "multiply", "power"};
+        f64 errs[4] = {err_downmix, err_deinterleave, err_multiply, err_power};
+        f64 limits[4] = {4.0 * (f64)FLT_EPSILON, 0.0, 4.0 * real_eps, 4.0 * real_eps};
+        for (i32 i = 0; i < 4; i++)
+        {
+            i32 ok = errs[i] <= limits[i];
+            all_ok = all_ok && ok;
+            printf("  %-7s %-12s %s (max rel err %.3g)\n", simd_isa_name(isa), names[i], ok ? "ok" : "FAILED", errs[i]);
+        }
+    }
+
+    printf("SIMD self-test %s\n", all_ok ? "passed" : "FAILED");
+
+    free(interleaved);
+    free(mono_ref);
+    free(mono_out);
+    free(src);
+    free(window);
+    free(real_ref);
+    free(real_out);
+    return all_ok;
+}
@@ -1,17 +1,23 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "spectrum.h"
+#include "simd.h"
+#include "perf.h"
+#include "spectrum_log.h"
 
-internal void
-compute_bar_targets(spectrum_state_t *s);
+#define SPECTRUM_PI 3.14159265358979323846
 
 internal void
-update_meter_time_weighting_coeffs(spectrum_state_t *s);
+compute_bar_targets(spectrum_state_t *s, const spectrum_real_t *bin_power, f64 *bar_target);
 
 internal void
 update_max_hold_trace(spectrum_state_t *s);
 
+internal void
+free_band_map(spectrum_state_t *s);
+
 internal f64
 frequency_weighting_db(i32 mode, f64 freq_hz)
 {
@@ -69,39 +75,107 @@ frequency_weighting_power_factor(i32 mode, f64 freq_hz)
     return pow(10.0, db / 10.0);
 }
 
-internal void
-update_meter_time_weighting_coeffs(spectrum_state_t *s)
+void
+meter_set_mode(meter_state_t *m, i32 mode)
 {
-    f64 fs = (f64)s->sample_rate;
-    if (fs <= 0.0)
+    f64 fs = (m->sample_rate > 0.0) ? m->sample_rate : (f64)INPUT_SAMPLE_RATE;
+    f64 sample_dt = 1.0 / fs;
+    m->mode = mode;
+
+    if (mode == TIME_WEIGHTING_IMPULSE)
     {
-        fs = (f64)INPUT_SAMPLE_RATE;
+        f64 tau_attack = 0.035;
+        f64 tau_release = 1.5;
+        m->alpha_attack = 1.0 - exp(-sample_dt / tau_attack);
+        m->alpha_release = 1.0 - exp(-sample_dt / tau_release);
+        return;
     }
 
-    f64 sample_dt = 1.0 / fs;
+    f64 tau = (mode == TIME_WEIGHTING_SLOW) ? 1.0 : 0.125;
+    f64 d = exp(-sample_dt / tau);
+    m->alpha_attack = m->alpha_release = 1.0 - d;
 
-    if (s->time_weighting_mode == TIME_WEIGHTING_FAST)
+    m->decay_pow[0] = 1.0;
+    for (i32 i = 1; i <= METER_BLOCK_SIZE; i++)
     {
-        f64 tau = 0.125;
-        s->meter_tw_alpha_fastslow = 1.0 - exp(-sample_dt / tau);
-        s->meter_tw_alpha_attack = s->meter_tw_alpha_fastslow;
-        s->meter_tw_alpha_release = s->meter_tw_alpha_fastslow;
+        m->decay_pow[i] = m->decay_pow[i - 1] * d;
     }
-    else if (s->time_weighting_mode == TIME_WEIGHTING_SLOW)
+    for (i32 i = 0; i < METER_BLOCK_SIZE; i++)
     {
-        f64 tau = 1.0;
-        s->meter_tw_alpha_fastslow = 1.0 - exp(-sample_dt / tau);
-        s->meter_tw_alpha_attack = s->meter_tw_alpha_fastslow;
-        s->meter_tw_alpha_release = s->meter_tw_alpha_fastslow;
+        m->block_weight[i] = (1.0 - d) * m->decay_pow[METER_BLOCK_SIZE - 1 - i];
     }
-    else
+}
+
+void
+meter_init(meter_state_t *m, f64 sample_rate, i32 mode)
+{
+    memset(m, 0, sizeof(*m));
+    m->sample_rate = sample_rate;
+    meter_set_mode(m, mode);
+}
+
+internal void
+meter_process_block(meter_state_t *m, const f32 *x, i32 count)
+{
+    // Last `count` weights: the newest sample always gets (1 - d)
+    const f64 *w = m->block_weight + (METER_BLOCK_SIZE - count);
+
+    // Four independent partial sums keep the dot products free of a serial dependency
+    f64 sq[4] = {0.0, 0.0, 0.0, 0.0};
+    f64 ab[4] = {0.0, 0.0, 0.0, 0.0};
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
     {
-        f64 tau_attack = 0.035;
-        f64 tau_release = 1.5;
-        s->meter_tw_alpha_fastslow = 0.0;
-        s->meter_tw_alpha_attack = 1.0 - exp(-sample_dt / tau_attack);
-        s->meter_tw_alpha_release = 1.0 - exp(-sample_dt / tau_release);
+        for (i32 k = 0; k < 4; k++)
+        {
+            f64 v = (f64)x[i + k];
+            sq[k] += w[i + k] * (v * v);
+            ab[k] += w[i + k] * fabs(v);
+        }
+    }
+    for (; i < count; i++)
+    {
+        f64 v = (f64)x[i];
+        sq[0] += w[i] * (v * v);
+        ab[0] += w[i] * fabs(v);
     }
+
+    m->rms_sq = m->decay_pow[count] * m->rms_sq + ((sq[0] + sq[1]) + (sq[2] + sq[3]));
+    m->peak_lin = m->decay_pow[count] * m->peak_lin + ((ab[0] + ab[1]) + (ab[2] + ab[3]));
+}
+
+void
+meter_process(meter_state_t *m, const f32 *samples, i32 count)
+{
+    m->pending += count;
+
+    if (m->mode != TIME_WEIGHTING_IMPULSE)
+    {
+        for (i32 i = 0; i < count; i += METER_BLOCK_SIZE)
+        {
+            i32 block = (count - i < METER_BLOCK_SIZE) ? count - i : METER_BLOCK_SIZE;
+            meter_process_block(m, samples + i, block);
+        }
+        return;
+    }
+
+    // Impulse: attack while rising, release while falling; the select is arithmetic, not a branch
+    f64 attack = m->alpha_attack;
+    f64 release = m->alpha_release;
+    f64 rms_sq = m->rms_sq;
+    f64 peak_lin = m->peak_lin;
+    for (i32 i = 0; i < count; i++)
+    {
+        f64 v = (f64)samples[i];
+        f64 x2 = v * v;
+        f64 absx = fabs(v);
+        f64 a_rms = release + (attack - release) * (f64)(x2 > rms_sq);
+        f64 a_peak = release + (attack - release) * (f64)(absx > peak_lin);
+        rms_sq += a_rms * (x2 - rms_sq);
+        peak_lin += a_peak * (absx - peak_lin);
+    }
+    m->rms_sq = rms_sq;
+    m->peak_lin = peak_lin;
 }
 
 internal f64
@@ -142,6 +216,12 @@ const f64 FRACTIONAL_OCTAVES[NUM_FRACTIONAL_OCTAVES] = {
     1.0, 1.0 / 3.0, 1.0 / 6.0, 1.0 / 12.0, 1.0 / 24.0, 1.0 / 48.0,
 };
 
+const i32 FFT_SIZE_PRESETS[NUM_FFT_SIZE_PRESETS] = {2048, 4096, 8192, 16384, 32768};
+
+const i32 HOP_DIVISOR_PRESETS[NUM_HOP_DIVISOR_PRESETS] = {2, 4, 8, 16};
+
+const i32 AVERAGE_COUNT_PRESETS[NUM_AVERAGE_COUNT_PRESETS] = {4, 8, 16, 32, 64, 128};
+
 void
 spectrum_set_fractional_octave(spectrum_state_t *s, f64 frac, i32 index)
 {
@@ -156,46 +236,6 @@ spectrum_set_fractional_octave(spectrum_state_t *s, f64 frac, i32 index)
     s->fractional_octave_index = index;
 }
 
-Texture2D
-create_gradient_texture(i32 height, bar_gradient_t grad)
-{
-    Image img = GenImageGradientLinear(1, height, 0, grad.top, grad.bottom);
-    Texture2D tex = LoadTextureFromImage(img);
-    UnloadImage(img);
-    return tex;
-}
-
-internal i32
-calc_num_bars_for_width(i32 w)
-{
-    if (w <= 0)
-    {
-        return 0;
-    }
-
-    return w / (BAR_PIXEL_WIDTH + BAR_GAP);
-}
-
-internal void
-update_plot_rect(spectrum_state_t *s)
-{
-    i32 sw = GetScreenWidth();
-    i32 sh = GetScreenHeight();
-    s->plot_left = MARGIN_LEFT;
-    s->plot_top = MARGIN_TOP;
-    s->plot_width = sw - (MARGIN_LEFT + MARGIN_RIGHT);
-    s->plot_height = sh - (MARGIN_TOP + MARGIN_BOTTOM);
-
-    if (s->plot_width < 10)
-    {
-        s->plot_width = 10;
-    }
-    if (s->plot_height < 10)
-    {
-        s->plot_height = 10;
-    }
-}
-
 internal int
 allocate_bars(spectrum_state_t *s, i32 num)
 {
@@ -240,10 +280,10 @@ free_bars(spectrum_state_t *s)
     s->num_bars = 0;
 }
 
-internal int
-reallocate_bars_if_needed(spectrum_state_t *s)
+i32
+spectrum_set_num_bars(spectrum_state_t *s, i32 num_bars)
 {
-    i32 new_num = calc_num_bars_for_width(s->plot_width);
+    i32 new_num = num_bars;
     if (new_num < 2)
     {
         new_num = 2;
@@ -311,56 +351,35 @@ reallocate_bars_if_needed(spectrum_state_t *s)
     return 1;
 }
 
-void
-spectrum_init(spectrum_state_t *s, Wave *wave, Font font)
+i32
+spectrum_init(spectrum_state_t *s, i32 sample_rate, i32 fft_size, i32 hop_size, i32 num_bars)
 {
     memset(s, 0, sizeof(*s));
 
-    s->bar_gradients[0] = (bar_gradient_t){(Color){255, 128, 0, 255}, (Color){255, 255, 0, 255}};
-    s->bar_gradients[1] = (bar_gradient_t){(Color){0, 32, 255, 255}, (Color){0, 255, 255, 255}};
-    s->bar_gradients[2] = (bar_gradient_t){(Color){0, 255, 0, 255}, (Color){0, 255, 255, 255}};
-    s->bar_gradients[3] = (bar_gradient_t){(Color){255, 0, 128, 255}, (Color){255, 64, 255, 255}};
-    s->bar_gradients[4] = (bar_gradient_t){(Color){140, 0, 255, 255}, (Color){255, 0, 220, 255}};
-    s->bar_gradients[5] = (bar_gradient_t){(Color){0, 180, 255, 255}, (Color){140, 255, 0, 255}};
-    s->bar_gradients[6] = (bar_gradient_t){(Color){255, 40, 40, 255}, (Color){255, 180, 0, 255}};
-    s->bar_gradient_index = 2;
-
-    s->fft_bins = FFT_WINDOW_SIZE / 2 + 1;
     s->f_min = 20.0;
-    s->f_max = fmin(20000.0, (f64)wave->sampleRate * 0.5);
+    s->f_max = fmin(20000.0, (f64)sample_rate * 0.5);
     s->log_f_ratio = log(s->f_max / s->f_min);
 
     s->fractional_octave_index = 4;
     s->fractional_octave = FRACTIONAL_OCTAVES[s->fractional_octave_index];
     s->fractional_k = pow(2.0, s->fractional_octave / 2.0);
-    s->hop_size = FFT_HOP_SIZE;
-    s->seconds_per_window = (f64)s->hop_size / (f64)wave->sampleRate;
-    s->font = font;
-    s->sample_rate = (i32)wave->sampleRate;
-
-    for (i32 i = 0; i < FFT_WINDOW_SIZE; i++)
-    {
-        s->window[i] = 0.5 * (1.0 - cos((2.0 * PI * i) / (f64)(FFT_WINDOW_SIZE - 1)));
-    }
-
-    f64 rc = 1.0 / (2.0 * PI * HPF_CUTOFF_HZ);
-    f64 dt = 1.0 / (f64)wave->sampleRate;
-    s->hpf_alpha = rc / (rc + dt);
-    s->hpf_prev_x = 0.0;
-    s->hpf_prev_y = 0.0;
-
-    update_plot_rect(s);
-    s->gradient_tex = create_gradient_texture(s->plot_height, s->bar_gradients[s->bar_gradient_index]);
-    s->fft_rt = LoadRenderTexture(s->plot_width, s->plot_height);
-    allocate_bars(s, calc_num_bars_for_width(s->plot_width));
-    s->fft_plan = fftw_plan_dft_r2c_1d(FFT_WINDOW_SIZE, s->fft_in, s->fft_out, FFTW_ESTIMATE);
-    s->last_width = GetScreenWidth();
-    s->last_height = GetScreenHeight();
-
-    s->meter_interval_elapsed = 0.0;
-    s->meter_sum_sq = 0.0;
-    s->meter_peak_lin = 0.0;
-    s->meter_sample_count = 0;
+    s->sample_rate = sample_rate;
+
+    if (!spectrum_set_fft_size(s, fft_size, hop_size))
+    {
+        spectrum_log(SPECTRUM_LOG_WARNING, "FFT size %d / hop %d unavailable, using %d / %d", fft_size, hop_size, FFT_WINDOW_SIZE, FFT_HOP_SIZE);
+        spectrum_set_fft_size(s, FFT_WINDOW_SIZE, FFT_HOP_SIZE);
+    }
+
+    f64 rc = 1.0 / (2.0 * SPECTRUM_PI * HPF_CUTOFF_HZ);
+    f64 dt = 1.0 / (f64)sample_rate;
+    s->hpf_alpha = (spectrum_real_t)(rc / (rc + dt));
+    s->hpf_prev_x = 0;
+    s->hpf_prev_y = 0;
+    s->hpf_primed = 0;
+    s->stream_pos = -1;
+    spectrum_set_input_channels(s, 1);
+
     s->meter_rms_dbfs = NAN;
     s->meter_peak_dbfs = NAN;
     s->meter_rms_dbspl = NAN;
@@ -386,31 +405,149 @@ spectrum_init(spectrum_state_t *s, Wave *wave, Font font)
     s->calibrator_target_db_spl = DEFAULT_CALIBRATOR_TARGET_DB_SPL;
     s->spl_calibrated = 0;
 
-    s->meter_rms_sq_tw = 0.0;
-    s->meter_peak_lin_tw = 0.0;
-    s->meter_tw_alpha_fastslow = 0.0;
-    s->meter_tw_alpha_attack = 0.0;
-    s->meter_tw_alpha_release = 0.0;
-    update_meter_time_weighting_coeffs(s);
+    spectral_average_set_target(&s->average, AVERAGE_DEFAULT_COUNT);
+
+    meter_init(&s->meter, (f64)s->sample_rate, s->time_weighting_mode);
+    return s->fft_plan && allocate_bars(s, (num_bars < 2) ? 2 : num_bars);
 }
 
 void
 spectrum_destroy(spectrum_state_t *s)
 {
-    if (s->gradient_tex.id)
+    free_bars(s);
+    free_band_map(s);
+    zoom_destroy(&s->zoom);
+    spectral_average_free(&s->average);
+    channel_views_free(&s->channels);
+    free(s->push_buf);
+    s->push_buf = NULL;
+    s->push_capacity = 0;
+    s->push_fill = 0;
+
+    // Plans and window tables belong to the fft_plan cache
+    SPECTRUM_FFTW(free)(s->fft_in);
+    SPECTRUM_FFTW(free)(s->fft_out);
+    SPECTRUM_FFTW(free)(s->bin_power);
+    SPECTRUM_FFTW(free)(s->mono_buf);
+    mirror_buffer_free(&s->history_buf);
+    s->fft_in = NULL;
+    s->fft_out = NULL;
+    s->bin_power = NULL;
+    s->mono_buf = NULL;
+    s->history = NULL;
+    s->fft_plan = NULL;
+    s->window = NULL;
+}
+
+i32
+spectrum_is_valid_fft_size(i32 fft_size)
+{
+    return fft_size >= FFT_MIN_WINDOW_SIZE && fft_size <= FFT_MAX_WINDOW_SIZE && (fft_size & (fft_size - 1)) == 0;
+}
+
+i32
+spectrum_set_fft_size(spectrum_state_t *s, i32 fft_size, i32 hop_size)
+{
+    if (!spectrum_is_valid_fft_size(fft_size) || hop_size < 1 || hop_size > fft_size)
     {
-        UnloadTexture(s->gradient_tex);
+        return 0;
     }
-    if (s->fft_rt.id)
+
+    if (fft_size != s->fft_size)
     {
-        UnloadRenderTexture(s->fft_rt);
+        // Never measure here (this runs on the key press): start from a quick plan and let the
+        // background planner upgrade it
+        const fft_plan_entry_t *plan = fft_plan_get_batch_fast(fft_size, 1);
+        i32 bins = fft_size / 2 + 1;
+
+        // Input/output hold a whole batch of back-to-back windows for the batched plans
+        spectrum_real_t *new_in = SPECTRUM_FFTW(alloc_real)((size_t)fft_size * FFT_MAX_BATCH_HOPS);
+        spectrum_complex_t *new_out = SPECTRUM_FFTW(alloc_complex)((size_t)bins * FFT_MAX_BATCH_HOPS);
+        spectrum_real_t *new_power = SPECTRUM_FFTW(alloc_real)((size_t)bins);
+        f32 *new_mono = (f32 *)SPECTRUM_FFTW(malloc)((size_t)fft_size * sizeof(f32));
+        mirror_buffer_t new_history = {0};
+        i32 history_ok = mirror_buffer_init(&new_history, (size_t)fft_size * sizeof(spectrum_real_t));
+        if (!plan || !new_in || !new_out || !new_power || !new_mono || !history_ok)
+        {
+            SPECTRUM_FFTW(free)(new_in);
+            SPECTRUM_FFTW(free)(new_out);
+            SPECTRUM_FFTW(free)(new_power);
+            SPECTRUM_FFTW(free)(new_mono);
+            mirror_buffer_free(&new_history);
+            return 0;
+        }
+
+        if (!spectral_average_resize(&s->average, bins))
+        {
+            SPECTRUM_FFTW(free)(new_in);
+            SPECTRUM_FFTW(free)(new_out);
+            SPECTRUM_FFTW(free)(new_power);
+            SPECTRUM_FFTW(free)(new_mono);
+            mirror_buffer_free(&new_history);
+            return 0;
+        }
+        s->average.enbw_bins = spectral_average_enbw(plan->window, fft_size);
+
+        // Carry the newest filtered samples over so live input continues without a gap: they
+        // end just before position 0 of the new ring
+        i32 new_history_size = (i32)(new_history.bytes / sizeof(spectrum_real_t));
+        if (s->history)
+        {
+            i32 keep = (fft_size < s->fft_size) ? fft_size : s->fft_size;
+            const spectrum_real_t *newest = s->history + s->history_pos + (s->history_size - keep);
+            usize offset = (usize)(new_history_size - keep) * sizeof(spectrum_real_t);
+            memcpy(new_history.data + offset, newest, (size_t)keep * sizeof(spectrum_real_t));
+            mirror_buffer_sync(&new_history, offset, (usize)keep * sizeof(spectrum_real_t));
+        }
+
+        memset(new_power, 0, (size_t)bins * sizeof(spectrum_real_t));
+
+        // Batch plans are built in the background too; until then bursts use smaller batches
+        fft_plan_prefetch(fft_size, FFT_MAX_BATCH_HOPS);
+
+        SPECTRUM_FFTW(free)(s->fft_in);
+        SPECTRUM_FFTW(free)(s->fft_out);
+        SPECTRUM_FFTW(free)(s->bin_power);
+        SPECTRUM_FFTW(free)(s->mono_buf);
+        mirror_buffer_free(&s->history_buf);
+        s->fft_in = new_in;
+        s->fft_out = new_out;
+        s->bin_power = new_power;
+        s->mono_buf = new_mono;
+        s->history_buf = new_history;
+        s->history = (spectrum_real_t *)(void *)new_history.data;
+        s->history_size = new_history_size;
+        s->history_pos = 0;
+        s->stream_pos = -1;
+        s->fft_plan = plan;
+        s->window = plan->window;
+        s->fft_size = fft_size;
+        s->fft_bins = bins;
     }
-    free_bars(s);
 
-    if (s->fft_plan)
+    // Keep the file playback position: window_index counts hops
+    if (s->hop_size > 0 && hop_size != s->hop_size)
     {
-        fftw_destroy_plan(s->fft_plan);
+        i64 sample_pos = (i64)s->window_index * (i64)s->hop_size;
+        s->window_index = (i32)(sample_pos / hop_size);
     }
+
+    s->hop_size = hop_size;
+    s->seconds_per_window = (f64)hop_size / (f64)s->sample_rate;
+    if (s->average_seconds > 0.0)
+    {
+        spectrum_set_average_seconds(s, s->average_seconds);
+    }
+
+    return 1;
+}
+
+i32
+spectrum_windows_for_frames(const spectrum_state_t *s, ul frames)
+{
+    ul size = (ul)s->fft_size;
+    ul total = (frames > size) ? (1 + (frames - size) / (ul)s->hop_size) : 1;
+    return (i32)total;
 }
 
 void
@@ -427,235 +564,416 @@ spectrum_done(const spectrum_state_t *s)
     return s->window_index >= s->total_windows;
 }
 
-void
-spectrum_handle_resize(spectrum_state_t *s)
+// Mono downmix of the first two planar rows (the mean, as wav_reader_read_mono computes it)
+internal void
+downmix_planar(const channel_views_t *v, i32 count, f32 *dst)
 {
-    i32 sw = GetScreenWidth();
-    i32 sh = GetScreenHeight();
-    if (sw == s->last_width && sh == s->last_height)
+    const f32 *l = v->planar;
+    if (v->inputs == 1)
     {
+        memcpy(dst, l, (size_t)count * sizeof(f32));
         return;
     }
 
-    s->last_width = sw;
-    s->last_height = sh;
-    update_plot_rect(s);
-    if (s->fft_rt.id)
+    const f32 *r = v->planar + v->fft_size;
+    for (i32 i = 0; i < count; i++)
+    {
+        dst[i] = 0.5f * (l[i] + r[i]);
+    }
+}
+
+internal void
+downmix_interleaved(const f32 *src, i32 channels, i32 count, f32 *dst)
+{
+    if (channels == 1)
     {
-        UnloadRenderTexture(s->fft_rt);
-        s->fft_rt = LoadRenderTexture(s->plot_width, s->plot_height);
+        memcpy(dst, src, (size_t)count * sizeof(f32));
+        return;
     }
-    if (s->gradient_tex.id)
+    if (channels == 2)
     {
-        UnloadTexture(s->gradient_tex);
-        s->gradient_tex = create_gradient_texture(s->plot_height, s->bar_gradients[s->bar_gradient_index]);
+        simd_kernels()->downmix_stereo(src, dst, count);
+        return;
     }
 
-    reallocate_bars_if_needed(s);
+    for (i32 i = 0; i < count; i++)
+    {
+        const f32 *frame = src + (size_t)i * (size_t)channels;
+        dst[i] = 0.5f * (frame[0] + frame[1]);
+    }
 }
 
+// Feeds input frames [stream_pos, end) through downmix, meters and the HPF into the history
+// ring, from the file (converted on demand; frames past its end count as silence) or else from
+// the interleaved live frames. While the per-channel views are on, the frames are split into
+// channels first and the mono signal is taken from that. A seek, loop or size change
+// (stream_pos out of reach) restarts the filters on the fft_size frames before `end`.
 internal void
-compute_fft_window(spectrum_state_t *s, f32 *samples, Wave *wave)
+stream_feed(spectrum_state_t *s, const wav_reader_t *file, const f32 *live, i64 end)
 {
-    usize total_samples = (size_t)wave->frameCount * (size_t)wave->channels;
-    usize start_index = (size_t)s->window_index * (size_t)s->hop_size * (size_t)wave->channels;
-
-    f64 mean = 0.0;
-    local_persist f32 mono_buf[FFT_WINDOW_SIZE];
+    i32 n = s->fft_size;
+    channel_views_t *views = NULL;
+    if (s->channels.layout != CHANNEL_LAYOUT_OFF && s->channels.fft_size == n && (!file || s->channels.input_channels == file->channels))
+    {
+        views = &s->channels;
+    }
 
-    for (i32 i = 0; i < FFT_WINDOW_SIZE; i++)
+    if (s->stream_pos < 0 || end < s->stream_pos || end - s->stream_pos > n)
     {
-        usize si = start_index + (size_t)i * (size_t)wave->channels;
-        f32 mono = 0.0f;
-        if (si < total_samples)
+        mirror_buffer_clear(&s->history_buf);
+        s->history_pos = 0;
+        s->hpf_primed = 0;
+        channel_views_reset(&s->channels);
+        s->stream_pos = (end > n) ? end - n : 0;
+        if (s->zoom.enabled)
         {
-            if (wave->channels == 1)
-            {
-                mono = samples[si];
-            }
-            else
-            {
-                f32 a = samples[si];
-                f32 b = (si + 1 < total_samples) ? samples[si + 1] : 0.0f;
-                mono = 0.5f * (a + b);
-            }
+            zoom_reset(&s->zoom);
         }
-        mono_buf[i] = mono;
-        mean += mono;
+    }
 
-        // Meter time-weighting (raw mono sample before mean removal / HPF / window)
-        f64 absx = fabs((f64)mono);
-        f64 x2 = (f64)mono * (f64)mono;
+    i32 count = (i32)(end - s->stream_pos);
+    if (count <= 0)
+    {
+        return;
+    }
 
-        if (s->time_weighting_mode == TIME_WEIGHTING_IMPULSE)
+    f32 *mono_buf = s->mono_buf;
+    if (file)
+    {
+        i32 frames = 0;
+        if (s->stream_pos < file->frame_count)
         {
-            f64 a_rms = (x2 > s->meter_rms_sq_tw) ? s->meter_tw_alpha_attack : s->meter_tw_alpha_release;
-            f64 a_peak = (absx > s->meter_peak_lin_tw) ? s->meter_tw_alpha_attack : s->meter_tw_alpha_release;
-            s->meter_rms_sq_tw += a_rms * (x2 - s->meter_rms_sq_tw);
-            s->meter_peak_lin_tw += a_peak * (absx - s->meter_peak_lin_tw);
+            frames = (file->frame_count - s->stream_pos < count) ? (i32)(file->frame_count - s->stream_pos) : count;
+        }
+
+        if (views)
+        {
+            wav_reader_read_planar(file, s->stream_pos, frames, views->inputs, views->planar, n);
+            for (i32 c = 0; c < views->inputs && frames < count; c++)
+            {
+                memset(views->planar + (size_t)c * (size_t)n + frames, 0, (size_t)(count - frames) * sizeof(f32));
+            }
+            downmix_planar(views, count, mono_buf);
         }
         else
         {
-            f64 a = s->meter_tw_alpha_fastslow;
-            s->meter_rms_sq_tw += a * (x2 - s->meter_rms_sq_tw);
-            s->meter_peak_lin_tw += a * (absx - s->meter_peak_lin_tw);
+            wav_reader_read_mono(file, s->stream_pos, frames, mono_buf);
+            if (frames < count)
+            {
+                memset(mono_buf + frames, 0, (size_t)(count - frames) * sizeof(f32));
+            }
         }
-
-        if (s->meter_rms_sq_tw < 0.0)
+    }
+    else
+    {
+        const f32 *src = live + (size_t)s->stream_pos * (size_t)s->input_channels;
+        if (views)
         {
-            s->meter_rms_sq_tw = 0.0;
+            simd_kernels()->deinterleave(src, s->input_channels, views->planar, n, count);
+            downmix_planar(views, count, mono_buf);
         }
-        if (s->meter_peak_lin_tw < 0.0)
+        else
         {
-            s->meter_peak_lin_tw = 0.0;
+            downmix_interleaved(src, s->input_channels, count, mono_buf);
         }
-
-        s->meter_sample_count++;
     }
-    mean /= (f64)FFT_WINDOW_SIZE;
 
-    // Second pass: HPF + window
-    for (i32 i = 0; i < FFT_WINDOW_SIZE; i++)
+    meter_process(&s->meter, mono_buf, count);
+
+    // Seeding with the first sample starts the filter settled on its DC level
+    if (!s->hpf_primed)
     {
-        f64 x = (f64)mono_buf[i] - mean;
-        f64 y = s->hpf_alpha * (s->hpf_prev_y + x - s->hpf_prev_x);
-        s->hpf_prev_x = x;
-        s->hpf_prev_y = y;
-        s->fft_in[i] = y * s->window[i];
+        s->hpf_prev_x = (spectrum_real_t)mono_buf[0];
+        s->hpf_prev_y = 0;
+        s->hpf_primed = 1;
     }
 
-    fftw_execute(s->fft_plan);
-
-    // Correct single-sided spectrum scaling with Hann coherent gain
-    // Hann coherent gain = 0.5 -> scale = 2/(N*0.5) = 4/N
-    f64 scale = 4.0 / (f64)FFT_WINDOW_SIZE;
-    for (i32 i = 0; i < s->fft_bins; i++)
+    spectrum_real_t alpha = s->hpf_alpha;
+    spectrum_real_t prev_x = s->hpf_prev_x;
+    spectrum_real_t prev_y = s->hpf_prev_y;
+    // Written once: the mirror supplies the wrapped copy
+    spectrum_real_t *history = s->history;
+    i32 size = s->history_size;
+    i32 start = s->history_pos;
+    i32 pos = start;
+    for (i32 i = 0; i < count; i++)
     {
-        f64 re = s->fft_out[i][0];
-        f64 im = s->fft_out[i][1];
-        f64 a = sqrt(re * re + im * im) * scale;
-        if (i == 0 || i == s->fft_bins - 1)
+        spectrum_real_t x = (spectrum_real_t)mono_buf[i];
+        spectrum_real_t y = alpha * (prev_y + x - prev_x);
+        prev_x = x;
+        prev_y = y;
+
+        history[pos] = y;
+        pos++;
+        if (pos == size)
         {
-            a *= 0.5;
+            pos = 0;
         }
+    }
+    mirror_buffer_sync(&s->history_buf, (usize)start * sizeof(spectrum_real_t), (usize)count * sizeof(spectrum_real_t));
+    s->hpf_prev_x = prev_x;
+    s->hpf_prev_y = prev_y;
+    s->history_pos = pos;
+    s->stream_pos = end;
 
-        s->bin_mag[i] = a;
+    if (views)
+    {
+        channel_views_feed(views, count, alpha);
+    }
+
+    // The newest `count` filtered samples end at history + history_pos + history_size
+    if (s->zoom.enabled)
+    {
+        zoom_process(&s->zoom, history + pos + size - count, count);
     }
 }
 
+// Brings the front-end up to the frame where the window at window_index ends (`lead` frames
+// past its hop position) and writes the windowed view into dst (fft_size values).
+internal void
+prepare_fft_window(spectrum_state_t *s, const wav_reader_t *file, const f32 *live, i32 lead, spectrum_real_t *dst)
+{
+    i64 end = (i64)s->window_index * (i64)s->hop_size + lead;
+    stream_feed(s, file, live, end);
+    simd_kernels()->multiply(dst, s->history + s->history_pos + s->history_size - s->fft_size, s->window, s->fft_size);
+}
+
+internal void
+compute_bin_power(const spectrum_state_t *s, spectrum_complex_t *spectrum, spectrum_real_t *dst)
+{
+    i32 n = s->fft_size;
+
+    // Correct single-sided spectrum scaling with Hann coherent gain
+    // Hann coherent gain = 0.5 -> scale = 2/(N*0.5) = 4/N, squared for the power domain
+    spectrum_real_t scale = (spectrum_real_t)(4.0 / (f64)n);
+    spectrum_real_t scale_sq = scale * scale;
+    simd_kernels()->power(dst, (const spectrum_real_t *)spectrum, s->fft_bins, scale_sq);
+
+    // DC and Nyquist are not doubled in the single-sided spectrum
+    dst[0] *= (spectrum_real_t)0.25;
+    dst[s->fft_bins - 1] *= (spectrum_real_t)0.25;
+}
+
 internal void
-compute_bar_targets(spectrum_state_t *s)
+free_band_map(spectrum_state_t *s)
+{
+    free(s->band_row_start);
+    free(s->band_bin_index);
+    free(s->band_bin_weight);
+    s->band_row_start = NULL;
+    s->band_bin_index = NULL;
+    s->band_bin_weight = NULL;
+    s->band_nnz_capacity = 0;
+    s->band_map_valid = 0;
+}
+
+internal i32
+band_map_is_current(const spectrum_state_t *s)
+{
+    return s->band_map_valid && s->band_map_num_bars == s->num_bars && s->band_map_sample_rate == s->sample_rate && s->band_map_fft_bins == s->fft_bins &&
+           s->band_map_weighting_mode == s->frequency_weighting_mode && s->band_map_pinking == s->pinking_enabled &&
+           s->band_map_fractional_octave == s->fractional_octave;
+}
+
+// Computes the fractional FFT bin range [k_lo, k_hi] covered by bar b.
+// Returns 0 if the band does not cover any bins.
+internal i32
+band_bin_range(const spectrum_state_t *s, i32 b, f64 *k_lo_out, f64 *k_hi_out)
 {
     // Use Nyquist for Hz->bin mapping (independent of displayed f_max)
     f64 max_bin = (f64)(s->fft_bins - 1);
     f64 nyquist = (f64)s->sample_rate * 0.5;
     f64 hz_to_bin = max_bin / nyquist;
+    f64 f_center = s->bar_freq_center[b];
 
-    for (i32 b = 0; b < s->num_bars; b++)
+    // Compute band edges using constant-Q factor
+    f64 f_low = f_center / s->fractional_k;
+    f64 f_high = f_center * s->fractional_k;
+
+    if (f_low < s->f_min)
+    {
+        f_low = s->f_min;
+    }
+    if (f_high > s->f_max)
     {
-        // Calculate logarithmically-spaced frequencies
-        f64 t = (f64)b / (f64)(s->num_bars - 1);
-        f64 f_center = s->f_min * pow(s->f_max / s->f_min, t);
+        f_high = s->f_max;
+    }
 
-        // Compute band edges using constant-Q factor
-        f64 f_low = f_center / s->fractional_k;
-        f64 f_high = f_center * s->fractional_k;
+    // Convert to FFT bin indices
+    f64 k_lo = f_low * hz_to_bin;
+    f64 k_hi = f_high * hz_to_bin;
+
+    // Ensure we don't miss the first bin (which can contain significant energy)
+    if (b == 0)
+    {
+        k_lo = 0.0; // Include DC for first band
+    }
+    if (k_hi > max_bin)
+    {
+        k_hi = max_bin;
+    }
 
-        if (f_low < s->f_min)
+    *k_lo_out = k_lo;
+    *k_hi_out = k_hi;
+    return k_hi > k_lo;
+}
+
+// Rebuilds the CSR band matrix. Only runs when num_bars, fractional octave, weighting,
+// pinking or sample rate changed; the per-hop path is then a plain multiply-accumulate.
+internal i32
+rebuild_band_map(spectrum_state_t *s)
+{
+    i32 num = s->num_bars;
+
+    i32 *row_start = (i32 *)realloc(s->band_row_start, (size_t)(num + 1) * sizeof(i32));
+    if (!row_start)
+    {
+        free_band_map(s);
+        return 0;
+    }
+    s->band_row_start = row_start;
+
+    // First pass: upper bound on non-zeros so the index/weight arrays are allocated once
+    i32 nnz = 0;
+    for (i32 b = 0; b < num; b++)
+    {
+        f64 k_lo, k_hi;
+        if (band_bin_range(s, b, &k_lo, &k_hi))
         {
-            f_low = s->f_min;
+            nnz += (i32)floor(k_hi) - (i32)floor(k_lo) + 1;
         }
-        if (f_high > s->f_max)
+    }
+
+    if (nnz > s->band_nnz_capacity)
+    {
+        i32 *new_index = (i32 *)realloc(s->band_bin_index, (size_t)nnz * sizeof(i32));
+        if (new_index)
         {
-            f_high = s->f_max;
+            s->band_bin_index = new_index;
         }
-
-        // Convert to FFT bin indices
-        f64 k_lo = f_low * hz_to_bin;
-        f64 k_hi = f_high * hz_to_bin;
-
-        // Ensure we don't miss the first bin (which can contain significant energy)
-        if (b == 0)
+        spectrum_real_t *new_weight = (spectrum_real_t *)realloc(s->band_bin_weight, (size_t)nnz * sizeof(spectrum_real_t));
+        if (new_weight)
         {
-            k_lo = 0.0; // Include DC for first band
+            s->band_bin_weight = new_weight;
         }
-        if (k_hi > max_bin)
+        if (!new_index || !new_weight)
         {
-            k_hi = max_bin;
+            free_band_map(s);
+            return 0;
         }
+        s->band_nnz_capacity = nnz;
+    }
 
-        i32 k0 = (i32)floor(k_lo);
-        i32 k1 = (i32)floor(k_hi);
+    // Second pass: per-bin overlap fractions, normalised by the band width and scaled by
+    // the weighting and pinking factors evaluated at the band centre.
+    i32 n = 0;
+    for (i32 b = 0; b < num; b++)
+    {
+        s->band_row_start[b] = n;
 
-        // Handle special case: no bins in range
-        if (k_hi <= k_lo || k1 < k0)
+        f64 k_lo, k_hi;
+        if (!band_bin_range(s, b, &k_lo, &k_hi))
         {
-            s->bar_target[b] = 0.0;
             continue;
         }
 
-        f64 sum = 0.0;
+        i32 k0 = (i32)floor(k_lo);
+        i32 k1 = (i32)floor(k_hi);
+        i32 row = n;
         f64 width = 0.0;
 
-        // Handle single-bin case
-        if (k0 == k1)
+        for (i32 k = k0; k <= k1 && k < s->fft_bins; k++)
         {
-            f64 w = k_hi - k_lo;
-            if (w > 0.0)
+            f64 w;
+            if (k0 == k1)
             {
-                f64 p = s->bin_mag[k0];
-                sum += p * p * w;
-                width += w;
+                w = k_hi - k_lo;
             }
-        }
-        else // Multiple bins
-        {
-            // First bin (partial)
-            f64 frac0 = 1.0 - (k_lo - floor(k_lo));
-            if (frac0 > 0.0 && k0 >= 0 && k0 < s->fft_bins)
+            else if (k == k0)
             {
-                f64 p = s->bin_mag[k0];
-                sum += p * p * frac0;
-                width += frac0;
+                w = 1.0 - (k_lo - floor(k_lo));
             }
-
-            // Middle bins (full)
-            for (i32 k = k0 + 1; k < k1; k++)
+            else if (k == k1)
             {
-                if (k >= 0 && k < s->fft_bins)
-                {
-                    f64 p = s->bin_mag[k];
-                    sum += p * p;
-                    width += 1.0;
-                }
+                w = k_hi - floor(k_hi);
+            }
+            else
+            {
+                w = 1.0;
             }
 
-            // Last bin (partial)
-            f64 frac1 = k_hi - floor(k_hi);
-            if (frac1 > 0.0 && k1 >= 0 && k1 < s->fft_bins)
+            if (w <= 0.0 || k < 0)
             {
-                f64 p = s->bin_mag[k1];
-                sum += p * p * frac1;
-                width += frac1;
+                continue;
             }
+
+            s->band_bin_index[n] = k;
+            s->band_bin_weight[n] = (spectrum_real_t)w;
+            width += w;
+            n++;
         }
 
-        f64 avg_power = (width > 0.0) ? (sum / width) : 0.0;
-        f64 weighted_power = avg_power * frequency_weighting_power_factor(s->frequency_weighting_mode, f_center);
+        if (width <= 0.0)
+        {
+            n = row;
+            continue;
+        }
 
+        f64 f_center = s->bar_freq_center[b];
+        f64 gain = frequency_weighting_power_factor(s->frequency_weighting_mode, f_center) / width;
         if (s->pinking_enabled)
         {
-            s->bar_target[b] = weighted_power * (f_center / 1000.0);
+            gain *= f_center / 1000.0;
         }
-        else
+
+        for (i32 i = row; i < n; i++)
         {
-            s->bar_target[b] = weighted_power;
+            s->band_bin_weight[i] = (spectrum_real_t)(s->band_bin_weight[i] * gain);
         }
     }
+    s->band_row_start[num] = n;
+
+    s->band_map_num_bars = num;
+    s->band_map_sample_rate = s->sample_rate;
+    s->band_map_fft_bins = s->fft_bins;
+    s->band_map_weighting_mode = s->frequency_weighting_mode;
+    s->band_map_pinking = s->pinking_enabled;
+    s->band_map_fractional_octave = s->fractional_octave;
+    s->band_map_valid = 1;
+    return 1;
 }
 
 internal void
-smooth_bars_linear(spectrum_state_t *s, f64 dt)
+compute_bar_targets(spectrum_state_t *s, const spectrum_real_t *bin_power, f64 *bar_target)
+{
+    if (!band_map_is_current(s) && !rebuild_band_map(s))
+    {
+        for (i32 b = 0; b < s->num_bars; b++)
+        {
+            bar_target[b] = 0.0;
+        }
+
+        return;
+    }
+
+    const i32 *row_start = s->band_row_start;
+    const i32 *bin_index = s->band_bin_index;
+    const spectrum_real_t *bin_weight = s->band_bin_weight;
+
+    for (i32 b = 0; b < s->num_bars; b++)
+    {
+        spectrum_real_t sum = 0;
+        for (i32 i = row_start[b]; i < row_start[b + 1]; i++)
+        {
+            sum += bin_weight[i] * bin_power[bin_index[i]];
+        }
+
+        bar_target[b] = (f64)sum;
+    }
+}
+
+internal void
+smooth_bars_linear(const spectrum_state_t *s, const f64 *bar_target, f64 *bar_smoothed, f64 dt)
 {
     f64 tau_a = s->smooth_attack_ms * 0.001;
     f64 tau_r = s->smooth_release_ms * 0.001;
@@ -664,15 +982,15 @@ smooth_bars_linear(spectrum_state_t *s, f64 dt)
 
     for (i32 b = 0; b < s->num_bars; b++)
     {
-        f64 y = s->bar_smoothed[b];
-        f64 x = s->bar_target[b];
+        f64 y = bar_smoothed[b];
+        f64 x = bar_target[b];
         f64 a = (x > y) ? a_up : a_dn;
-        s->bar_smoothed[b] = y + a * (x - y);
+        bar_smoothed[b] = y + a * (x - y);
     }
 }
 
 internal void
-smooth_bars_db(spectrum_state_t *s, f64 dt)
+smooth_bars_db(const spectrum_state_t *s, const f64 *bar_target, f64 *bar_smoothed, f64 dt)
 {
     f64 tau_a = s->db_smooth_attack_ms * 0.001;
     f64 tau_r = s->db_smooth_release_ms * 0.001;
@@ -681,11 +999,11 @@ smooth_bars_db(spectrum_state_t *s, f64 dt)
 
     for (i32 b = 0; b < s->num_bars; b++)
     {
-        f64 x_db = volume_to_db(s->bar_target[b], EPSILON_POWER, DB_OFFSET);
-        f64 y_db = volume_to_db(s->bar_smoothed[b], EPSILON_POWER, DB_OFFSET);
+        f64 x_db = volume_to_db(bar_target[b], EPSILON_POWER, DB_OFFSET);
+        f64 y_db = volume_to_db(bar_smoothed[b], EPSILON_POWER, DB_OFFSET);
         f64 a = (x_db > y_db) ? a_up : a_dn;
         f64 z_db = y_db + a * (x_db - y_db);
-        s->bar_smoothed[b] = db_to_volume(z_db, EPSILON_POWER, DB_OFFSET);
+        bar_smoothed[b] = db_to_volume(z_db, EPSILON_POWER, DB_OFFSET);
     }
 }
 
@@ -734,33 +1052,103 @@ update_max_hold_trace(spectrum_state_t *s)
     }
 }
 
-void
-spectrum_update(spectrum_state_t *s, Wave *wave, f32 *samples, f64 dt)
+internal void
+update_bar_traces(spectrum_state_t *s, f64 dt)
 {
-    if (spectrum_done(s))
+    u64 t = perf_now();
+    if (s->average.mode != AVERAGE_OFF)
     {
-        return;
+        memcpy(s->bar_smoothed, s->bar_target, (size_t)s->num_bars * sizeof(f64));
+    }
+    else if (s->db_smoothing_enabled)
+    {
+        smooth_bars_db(s, s->bar_target, s->bar_smoothed, dt);
+    }
+    else
+    {
+        smooth_bars_linear(s, s->bar_target, s->bar_smoothed, dt);
     }
 
-    s->accumulator += dt;
-    while (s->accumulator >= s->seconds_per_window && !spectrum_done(s))
+    update_peaks(s, dt);
+    update_max_hold_trace(s);
+    perf_record(PERF_STAGE_SMOOTH, t);
+}
+
+// The views always smooth per hop, averaging or not; peaks and max-hold stay on the mono bars
+internal void
+smooth_channel_views(const spectrum_state_t *s, channel_views_t *v, f64 dt)
+{
+    for (i32 c = 0; c < v->count; c++)
     {
-        s->accumulator -= s->seconds_per_window;
-        compute_fft_window(s, samples, wave);
-        compute_bar_targets(s);
-        s->window_index++;
+        usize offset = (usize)c * (usize)v->num_bars;
+        if (s->db_smoothing_enabled)
+        {
+            smooth_bars_db(s, v->bar_target + offset, v->bar_smoothed + offset, dt);
+        }
+        else
+        {
+            smooth_bars_linear(s, v->bar_target + offset, v->bar_smoothed + offset, dt);
+        }
+    }
+}
+
+// Transforms the newest window of every view (already fed up to the current hop) and maps it
+// onto the bars
+internal void
+analyze_channel_views(spectrum_state_t *s, channel_views_t *v, f64 dt)
+{
+    channel_views_transform(v, s->window);
+    for (i32 c = 0; c < v->count; c++)
+    {
+        compute_bin_power(s, v->fft_out + (usize)c * (usize)v->fft_bins, v->bin_power);
+        compute_bar_targets(s, v->bin_power, v->bar_target + (usize)c * (usize)v->num_bars);
+    }
+    smooth_channel_views(s, v, dt);
+}
+
+// Buffers for the current sizes, or NULL while the views are off (or cannot be allocated,
+// which turns them off)
+internal channel_views_t *
+channel_views_ready(spectrum_state_t *s)
+{
+    if (s->channels.layout == CHANNEL_LAYOUT_OFF)
+    {
+        return NULL;
+    }
+
+    if (!channel_views_prepare(&s->channels, s->fft_size, s->num_bars))
+    {
+        spectrum_log(SPECTRUM_LOG_WARNING, "per-channel views unavailable, turning them off");
+        s->channels.layout = CHANNEL_LAYOUT_OFF;
+        return NULL;
     }
 
-    if (s->meter_sample_count > 0)
+    return &s->channels;
+}
+
+// Called wherever the bars take a new value from the analysis
+internal void
+emit_bar_row(spectrum_state_t *s)
+{
+    if (s->on_bars)
+    {
+        s->on_bars(s, s->on_bars_user);
+    }
+}
+
+internal void
+update_meter_readouts(spectrum_state_t *s, f64 dt)
+{
+    if (s->meter.pending > 0)
     {
-        f64 rms_lin = sqrt(s->meter_rms_sq_tw);
-        if (s->meter_peak_lin_tw < 1e-12)
+        f64 rms_lin = sqrt(s->meter.rms_sq);
+        if (s->meter.peak_lin < 1e-12)
         {
             s->meter_peak_dbfs = -INFINITY;
         }
         else
         {
-            s->meter_peak_dbfs = 20.0 * log10(s->meter_peak_lin_tw);
+            s->meter_peak_dbfs = 20.0 * log10(s->meter.peak_lin);
         }
 
         if (rms_lin < 1e-12)
@@ -786,108 +1174,393 @@ spectrum_update(spectrum_state_t *s, Wave *wave, f32 *samples, f64 dt)
     s->meter_peak_dbspl_display = smooth_readout_db(s->meter_peak_dbspl_display, s->meter_peak_dbspl, dt, s->meter_readout_smooth_ms);
     s->meter_rms_dbspl_display = smooth_readout_db(s->meter_rms_dbspl_display, s->meter_rms_dbspl, dt, s->meter_readout_smooth_ms);
 
-    s->meter_sample_count = 0;
+    s->meter.pending = 0;
+}
 
-    if (s->db_smoothing_enabled)
+// Analyzes `windows` hops starting at window_index (each window ends `lead` frames past its hop
+// position). Pending hops are gathered back to back into fft_in and transformed by one batched
+// plan; smoothing then steps through them in order so short transients inside a catch-up burst
+// still reach the bars and peaks. With bin averaging on, each hop is only accumulated and the
+// bars are mapped once from the average at the end.
+internal void
+spectrum_advance(spectrum_state_t *s, const wav_reader_t *file, const f32 *live, i32 windows, i32 lead, f64 dt)
+{
+    i32 n = s->fft_size;
+    f64 hop_dt = (windows > 0) ? dt / (f64)windows : dt;
+    i32 averaging = s->average.mode != AVERAGE_OFF;
+    channel_views_t *views = channel_views_ready(s);
+
+    // Pick up the background planner's upgrade of the single-window plan
+    const fft_plan_entry_t *best = fft_plan_find_batch(n, 1);
+    if (best)
     {
-        smooth_bars_db(s, dt);
+        s->fft_plan = best;
     }
-    else
+
+    i32 remaining = windows;
+    while (remaining > 0)
     {
-        smooth_bars_linear(s, dt);
+        i32 batch = FFT_MAX_BATCH_HOPS;
+        while (batch > remaining)
+        {
+            batch /= 2;
+        }
+
+        const fft_plan_entry_t *plan = fft_plan_find_batch(n, batch);
+        while (!plan && batch > 1)
+        {
+            batch /= 2;
+            plan = fft_plan_find_batch(n, batch);
+        }
+
+        i32 first = s->window_index;
+        for (i32 w = 0; w < batch; w++)
+        {
+            u64 t = perf_now();
+            prepare_fft_window(s, file, live, lead, s->fft_in + (size_t)w * (size_t)n);
+            perf_record(PERF_STAGE_PREPROCESS, t);
+            if (views)
+            {
+                analyze_channel_views(s, views, hop_dt);
+            }
+            s->window_index++;
+        }
+
+        u64 t = perf_now();
+        SPECTRUM_FFTW(execute_dft_r2c)(plan->plan, s->fft_in, s->fft_out);
+        perf_record(PERF_STAGE_FFT, t);
+
+        for (i32 w = 0; w < batch; w++)
+        {
+            compute_bin_power(s, s->fft_out + (size_t)w * (size_t)s->fft_bins, s->bin_power);
+            if (averaging)
+            {
+                spectral_average_add(&s->average, s->bin_power);
+                continue;
+            }
+
+            t = perf_now();
+            compute_bar_targets(s, s->bin_power, s->bar_target);
+            perf_record(PERF_STAGE_BAR_TARGETS, t);
+            update_bar_traces(s, hop_dt);
+            s->bars_window = first + w;
+            emit_bar_row(s);
+        }
+
+        remaining -= batch;
     }
 
-    update_peaks(s, dt);
-    update_max_hold_trace(s);
+    if (averaging)
+    {
+        if (windows > 0)
+        {
+            u64 t = perf_now();
+            compute_bar_targets(s, spectral_average_result(&s->average), s->bar_target);
+            perf_record(PERF_STAGE_BAR_TARGETS, t);
+        }
+        update_bar_traces(s, dt);
+        if (windows > 0)
+        {
+            s->bars_window = s->window_index - 1;
+            emit_bar_row(s);
+        }
+    }
+    else if (windows == 0)
+    {
+        update_bar_traces(s, dt);
+    }
+
+    if (views && windows == 0)
+    {
+        smooth_channel_views(s, views, dt);
+    }
+
+    update_meter_readouts(s, dt);
 }
 
 void
-spectrum_render_to_texture(spectrum_state_t *s)
+spectrum_update(spectrum_state_t *s, const wav_reader_t *file, f64 dt)
 {
-    BeginTextureMode(s->fft_rt);
-    ClearBackground(BLACK);
-    i32 h = s->plot_height;
+    if (spectrum_done(s))
+    {
+        return;
+    }
 
-    const i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
+    i32 pending = 0;
+    s->accumulator += dt;
+    while (s->accumulator >= s->seconds_per_window && s->window_index + pending < s->total_windows)
+    {
+        s->accumulator -= s->seconds_per_window;
+        pending++;
+    }
 
-    for (i32 b = 0; b < s->num_bars; b++)
+    // File windows are absolute: window w covers frames [w * hop, w * hop + fft_size)
+    spectrum_advance(s, file, NULL, pending, s->fft_size, dt);
+}
+
+void
+spectrum_update_at(spectrum_state_t *s, const wav_reader_t *file, f64 playback_seconds, i32 max_windows, f64 dt)
+{
+    // Newest window that has fully played: w * hop + fft_size <= playhead frame
+    i64 frame = (i64)(playback_seconds * (f64)s->sample_rate);
+    i64 target = (frame >= s->fft_size) ? 1 + (frame - s->fft_size) / s->hop_size : 0;
+    if (target > s->total_windows)
     {
-        f64 mag_db = volume_to_db(s->bar_smoothed[b], EPSILON_POWER, DB_OFFSET);
+        target = s->total_windows;
+    }
+
+    // Behind (or looped back): skip straight to the newest windows. A skip shorter than the
+    // window still streams the skipped frames through the HPF; only their FFTs are saved.
+    if (target - s->window_index > max_windows || target < s->window_index)
+    {
+        s->window_index = (target > max_windows) ? (i32)(target - max_windows) : 0;
+    }
+    s->accumulator = 0.0;
+
+    spectrum_advance(s, file, NULL, (i32)(target - s->window_index), s->fft_size, dt);
+}
 
-        if (mag_db < DB_BOTTOM)
+void
+spectrum_analyze_windows(spectrum_state_t *s, const wav_reader_t *file, i32 windows)
+{
+    if (windows > s->total_windows - s->window_index)
+    {
+        windows = s->total_windows - s->window_index;
+    }
+    if (windows <= 0)
+    {
+        return;
+    }
+
+    spectrum_advance(s, file, NULL, windows, s->fft_size, (f64)windows * s->seconds_per_window);
+}
+
+void
+spectrum_update_windows(spectrum_state_t *s, const f32 *samples, i32 windows, f64 dt)
+{
+    // Rebase on the new frames: window w ends after frame (w + 1) * hop
+    spectrum_set_total_windows(s, windows);
+    s->stream_pos = 0;
+    spectrum_advance(s, NULL, samples, windows, s->hop_size, dt);
+}
+
+i32
+spectrum_push_frames(spectrum_state_t *s, const f32 *frames, i32 count)
+{
+    i32 channels = s->input_channels;
+    while (count > 0)
+    {
+        i32 hop = s->hop_size;
+
+        // Whole hops go straight from the caller's frames while nothing is held back
+        if (s->push_fill == 0 && count >= hop)
         {
-            mag_db = DB_BOTTOM;
+            i32 windows = count / hop;
+            spectrum_update_windows(s, frames, windows, (f64)windows * s->seconds_per_window);
+            frames += (size_t)windows * (size_t)hop * (size_t)channels;
+            count -= windows * hop;
+            continue;
         }
-        if (mag_db > DB_TOP)
+
+        i32 needed = hop * channels;
+        if (needed > s->push_capacity)
         {
-            mag_db = DB_TOP;
+            f32 *grown = (f32 *)realloc(s->push_buf, (size_t)needed * sizeof(f32));
+            if (!grown)
+            {
+                return 0;
+            }
+            s->push_buf = grown;
+            s->push_capacity = needed;
         }
 
-        f64 norm = (mag_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
-        i32 bar_h = (i32)(norm * h);
-        if (bar_h <= 0)
+        // A hop that shrank below the held frames takes none and analyzes what it holds
+        i32 take = hop - s->push_fill;
+        take = (take < 0) ? 0 : ((take > count) ? count : take);
+        memcpy(s->push_buf + (size_t)s->push_fill * (size_t)channels, frames, (size_t)take * (size_t)channels * sizeof(f32));
+        s->push_fill += take;
+        frames += (size_t)take * (size_t)channels;
+        count -= take;
+
+        if (s->push_fill >= hop)
         {
-            continue;
+            spectrum_update_windows(s, s->push_buf, 1, s->seconds_per_window);
+            s->push_fill -= hop;
+            memmove(s->push_buf, s->push_buf + (size_t)hop * (size_t)channels, (size_t)s->push_fill * (size_t)channels * sizeof(f32));
         }
+    }
 
-        i32 x = b * stride;
+    return 1;
+}
 
-        Rectangle src = {0, (f32)(s->gradient_tex.height - bar_h), 1, (f32)bar_h};
-        Rectangle dst = {(f32)x, (f32)(h - bar_h), (f32)BAR_PIXEL_WIDTH, (f32)bar_h};
-        DrawTexturePro(s->gradient_tex, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+i32
+spectrum_read_bands(const spectrum_state_t *s, f64 *freq_hz, f64 *level_db, i32 capacity)
+{
+    i32 n = (s->num_bars < capacity) ? s->num_bars : capacity;
+    for (i32 b = 0; b < n; b++)
+    {
+        if (freq_hz)
+        {
+            freq_hz[b] = s->bar_freq_center[b];
+        }
+        if (level_db)
+        {
+            level_db[b] = volume_to_db(s->bar_smoothed[b], EPSILON_POWER, DB_OFFSET);
+        }
     }
 
-    Color grad_top = s->bar_gradients[s->bar_gradient_index].top;
-    Color peak_color = (Color){grad_top.r, grad_top.g, grad_top.b, 200};
+    return s->num_bars;
+}
 
-    Color max_hold_color = (Color){255, 255, 255, 100};
+i32
+spectrum_read_bins(const spectrum_state_t *s, f64 *power, i32 capacity)
+{
+    i32 n = (s->fft_bins < capacity) ? s->fft_bins : capacity;
+    for (i32 k = 0; k < n; k++)
+    {
+        power[k] = (f64)s->bin_power[k];
+    }
 
-    for (i32 b = 0; b < s->num_bars; b++)
+    return s->fft_bins;
+}
+
+void
+spectrum_read_meters(const spectrum_state_t *s, spectrum_meters_t *m)
+{
+    m->rms_dbfs = s->meter_rms_dbfs;
+    m->peak_dbfs = s->meter_peak_dbfs;
+    m->rms_dbspl = s->meter_rms_dbspl;
+    m->peak_dbspl = s->meter_peak_dbspl;
+}
+
+i32
+spectrum_frame_capture(spectrum_frame_t *f, const spectrum_state_t *s)
+{
+    i32 n = s->num_bars;
+    if (n > f->capacity)
     {
-        f64 peak_power = s->peak_power[b];
-        if (peak_power <= 0)
+        f64 *bars = (f64 *)malloc((size_t)n * sizeof(f64));
+        f64 *peaks = (f64 *)malloc((size_t)n * sizeof(f64));
+        f64 *max_hold = (f64 *)malloc((size_t)n * sizeof(f64));
+        f64 *freq_center = (f64 *)malloc((size_t)n * sizeof(f64));
+        if (!bars || !peaks || !max_hold || !freq_center)
         {
-            continue;
+            free(bars);
+            free(peaks);
+            free(max_hold);
+            free(freq_center);
+            return 0;
         }
 
-        f64 peak_db = volume_to_db(peak_power, EPSILON_POWER, DB_OFFSET);
-        if (peak_db < DB_BOTTOM)
-        {
-            continue;
-        }
-        if (peak_db > DB_TOP)
+        free(f->bar_smoothed);
+        free(f->peak_power);
+        free(f->max_hold_power);
+        free(f->bar_freq_center);
+        f->bar_smoothed = bars;
+        f->peak_power = peaks;
+        f->max_hold_power = max_hold;
+        f->bar_freq_center = freq_center;
+        f->capacity = n;
+    }
+
+    if (s->zoom.enabled && !f->zoom_power)
+    {
+        f->zoom_power = (f64 *)malloc(ZOOM_FFT_SIZE * sizeof(f64));
+        if (!f->zoom_power)
         {
-            peak_db = DB_TOP;
+            return 0;
         }
+    }
 
-        f64 norm = (f64)(peak_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
-        i32 y = h - (i32)(norm * h);
-        i32 x = b * stride;
-        DrawRectangle(x, y, BAR_PIXEL_WIDTH, 1, peak_color);
+    f->num_bars = n;
+    memcpy(f->bar_smoothed, s->bar_smoothed, (size_t)n * sizeof(f64));
+    memcpy(f->peak_power, s->peak_power, (size_t)n * sizeof(f64));
+    memcpy(f->max_hold_power, s->max_hold_power, (size_t)n * sizeof(f64));
+    memcpy(f->bar_freq_center, s->bar_freq_center, (size_t)n * sizeof(f64));
+
+    f->sample_rate = s->sample_rate;
+    f->fft_size = s->fft_size;
+    f->hop_size = s->hop_size;
+    f->fractional_octave = s->fractional_octave;
+    f->f_min = s->f_min;
+    f->f_max = s->f_max;
+    f->peak_hold_seconds = s->peak_hold_seconds;
+    f->seconds_per_window = s->seconds_per_window;
+    f->db_smoothing_enabled = s->db_smoothing_enabled;
+    f->smooth_attack_ms = s->db_smoothing_enabled ? s->db_smooth_attack_ms : s->smooth_attack_ms;
+    f->smooth_release_ms = s->db_smoothing_enabled ? s->db_smooth_release_ms : s->smooth_release_ms;
+    f->pinking_enabled = s->pinking_enabled;
+    f->frequency_weighting_mode = s->frequency_weighting_mode;
+    f->time_weighting_mode = s->time_weighting_mode;
+    f->spl_features_enabled = s->spl_features_enabled;
+    f->spl_calibrated = s->spl_calibrated;
+
+    f->meter_rms_dbfs_display = s->meter_rms_dbfs_display;
+    f->meter_peak_dbfs_display = s->meter_peak_dbfs_display;
+    f->meter_rms_dbspl_display = s->meter_rms_dbspl_display;
+    f->meter_peak_dbspl_display = s->meter_peak_dbspl_display;
+    f->average_mode = s->average.mode;
+    f->average_target = s->average.target;
+    f->average_count = s->average.count;
+    f->average_enbw_hz = s->average.enbw_bins * (f64)s->sample_rate / (f64)s->fft_size;
+
+    f->zoom_enabled = s->zoom.enabled;
+    f->zoom_center_hz = s->zoom.center_hz;
+    f->zoom_bin_hz = s->zoom.bin_hz;
+    f->zoom_span_hz = zoom_display_span_hz(&s->zoom);
+    f->zoom_spectra = 0;
+    f->zoom_filled = 0;
+    if (s->zoom.enabled)
+    {
+        memcpy(f->zoom_power, s->zoom.power, ZOOM_FFT_SIZE * sizeof(f64));
+        f->zoom_spectra = s->zoom.spectra;
+        f->zoom_filled = s->zoom.base_filled;
     }
 
-    for (i32 b = 0; b < s->num_bars; b++)
+    // The views catch up with a new bar count on the next analysis step; until then there are none
+    const channel_views_t *v = &s->channels;
+    f->channel_layout = v->layout;
+    f->channel_views = 0;
+    if (v->layout != CHANNEL_LAYOUT_OFF && v->bar_smoothed && v->num_bars == n)
     {
-        i32 x = b * stride;
-        f64 max_hold_power = s->max_hold_power[b];
-        if (max_hold_power > 0.0)
+        i32 values = v->count * n;
+        if (values > f->channel_capacity)
         {
-            f64 max_hold_db = volume_to_db(max_hold_power, EPSILON_POWER, DB_OFFSET);
-            if (max_hold_db >= DB_BOTTOM)
+            f64 *bars = (f64 *)malloc((size_t)values * sizeof(f64));
+            if (!bars)
             {
-                if (max_hold_db > DB_TOP)
-                {
-                    max_hold_db = DB_TOP;
-                }
+                return 0;
+            }
+            free(f->channel_bars);
+            f->channel_bars = bars;
+            f->channel_capacity = values;
+        }
 
-                f64 max_norm = (f64)(max_hold_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
-                i32 max_y = h - (i32)(max_norm * h);
-                DrawRectangle(x, max_y, BAR_PIXEL_WIDTH, 1, max_hold_color);
+        memcpy(f->channel_bars, v->bar_smoothed, (size_t)values * sizeof(f64));
+        for (i32 c = 0; c < v->count; c++)
+        {
+            const char *label = channel_views_label(v, c, f->channel_labels[c], sizeof(f->channel_labels[c]));
+            if (label != f->channel_labels[c])
+            {
+                snprintf(f->channel_labels[c], sizeof(f->channel_labels[c]), "%s", label);
             }
         }
+        f->channel_views = v->count;
     }
 
-    EndTextureMode();
+    return 1;
+}
+
+void
+spectrum_frame_free(spectrum_frame_t *f)
+{
+    free(f->bar_smoothed);
+    free(f->peak_power);
+    free(f->max_hold_power);
+    free(f->bar_freq_center);
+    free(f->zoom_power);
+    free(f->channel_bars);
+    memset(f, 0, sizeof(*f));
 }
 
 void
@@ -948,6 +1621,8 @@ spectrum_reset_peaks(spectrum_state_t *s)
         s->max_hold_power[b] = 0.0;
         s->peak_hold_timer[b] = 0.0;
     }
+
+    spectral_average_reset(&s->average);
 }
 
 void
@@ -960,7 +1635,7 @@ void
 spectrum_cycle_time_weighting(spectrum_state_t *s)
 {
     s->time_weighting_mode = (s->time_weighting_mode + 1) % NUM_TIME_WEIGHTING_MODES;
-    update_meter_time_weighting_coeffs(s);
+    meter_set_mode(&s->meter, s->time_weighting_mode);
 }
 
 void
@@ -982,3 +1657,84 @@ spectrum_calibrate_spl(spectrum_state_t *s, f64 target_db_spl)
     s->meter_peak_dbspl = s->meter_peak_dbfs + s->spl_offset_db;
     s->meter_rms_dbspl = s->meter_rms_dbfs + s->spl_offset_db;
 }
+
+void
+spectrum_set_input_channels(spectrum_state_t *s, i32 channels)
+{
+    s->input_channels = (channels < 1) ? 1 : channels;
+    channel_views_set_input_channels(&s->channels, s->input_channels);
+    s->stream_pos = -1;
+    s->push_fill = 0;
+}
+
+void
+spectrum_set_channel_layout(spectrum_state_t *s, i32 layout)
+{
+    if (layout != CHANNEL_LAYOUT_OFF && s->channels.layout == CHANNEL_LAYOUT_OFF)
+    {
+        // Their histories stopped when they were turned off
+        channel_views_reset(&s->channels);
+    }
+    s->channels.layout = layout;
+}
+
+i32
+spectrum_set_zoom(spectrum_state_t *s, i32 enabled, f64 center_hz)
+{
+    if (!enabled)
+    {
+        s->zoom.enabled = 0;
+        return 1;
+    }
+
+    if (!s->zoom.taps && !zoom_init(&s->zoom, (f64)s->sample_rate))
+    {
+        return 0;
+    }
+
+    if (!s->zoom.enabled || center_hz != s->zoom.center_hz)
+    {
+        zoom_set_center(&s->zoom, center_hz);
+    }
+
+    s->zoom.enabled = 1;
+    return 1;
+}
+
+void
+spectrum_set_average_mode(spectrum_state_t *s, i32 mode)
+{
+    spectral_average_set_mode(&s->average, mode);
+}
+
+void
+spectrum_set_average_count(spectrum_state_t *s, i32 count)
+{
+    s->average_seconds = 0.0;
+    spectral_average_set_target(&s->average, count);
+}
+
+void
+spectrum_set_average_seconds(spectrum_state_t *s, f64 seconds)
+{
+    s->average_seconds = seconds;
+
+    i32 target = (i32)lround(seconds / s->seconds_per_window);
+    target = (target < 1) ? 1 : target;
+    if (target != s->average.target)
+    {
+        spectral_average_set_target(&s->average, target);
+    }
+}
+
+f64
+spectrum_frame_bar_density(const spectrum_frame_t *f, i32 b, f64 bar_power)
+{
+    f64 power = bar_power;
+    if (f->pinking_enabled)
+    {
+        power /= f->bar_freq_center[b] / 1000.0;
+    }
+
+    return power / f->average_enbw_hz;
+}
@@ -0,0 +1,32 @@
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "spectrum_log.h"
+
+#define SPECTRUM_LOG_MAX_LENGTH 512
+
+global spectrum_log_fn log_fn = NULL;
+global void *log_user = NULL;
+
+void
+spectrum_set_log(spectrum_log_fn fn, void *user)
+{
+    log_fn = fn;
+    log_user = user;
+}
+
+void
+spectrum_log(i32 level, const char *fmt, ...)
+{
+    if (!log_fn)
+    {
+        return;
+    }
+
+    char message[SPECTRUM_LOG_MAX_LENGTH];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    log_fn(level, message, log_user);
+}
@@ -0,0 +1,304 @@
+#include <math.h>
+#include <string.h>
+#include "spectrum_view.h"
+
+internal f64
+power_to_db(f64 power)
+{
+    return 10.0 * log10(power + EPSILON_POWER) + DB_OFFSET;
+}
+
+Texture2D
+create_gradient_texture(i32 height, bar_gradient_t grad)
+{
+    Image img = GenImageGradientLinear(1, height, 0, grad.top, grad.bottom);
+    Texture2D tex = LoadTextureFromImage(img);
+    UnloadImage(img);
+    return tex;
+}
+
+internal i32
+calc_num_bars_for_width(i32 w)
+{
+    if (w <= 0)
+    {
+        return 0;
+    }
+
+    return w / (BAR_PIXEL_WIDTH + BAR_GAP);
+}
+
+internal void
+update_plot_rect(spectrum_view_t *v)
+{
+    v->plot_left = v->layout_x + MARGIN_LEFT;
+    v->plot_top = v->layout_y + MARGIN_TOP;
+    v->plot_width = v->layout_width - (MARGIN_LEFT + MARGIN_RIGHT);
+    v->plot_height = v->layout_height - (MARGIN_TOP + MARGIN_BOTTOM);
+    v->waterfall_height = 0;
+    if (v->waterfall.enabled)
+    {
+        v->waterfall_height = (i32)(v->plot_height * WATERFALL_HEIGHT_FRACTION);
+        v->plot_height -= v->waterfall_height + WATERFALL_GAP;
+    }
+
+    if (v->plot_width < 10)
+    {
+        v->plot_width = 10;
+    }
+    if (v->plot_height < 10)
+    {
+        v->plot_height = 10;
+    }
+    v->waterfall_top = v->plot_top + v->plot_height + WATERFALL_GAP;
+}
+
+internal Rectangle
+viewport_area(const spectrum_view_t *v)
+{
+    if (v->viewport.width > 0 && v->viewport.height > 0)
+    {
+        return v->viewport;
+    }
+
+    return (Rectangle){0, 0, (f32)GetScreenWidth(), (f32)GetScreenHeight()};
+}
+
+// Bars follow the plot width; the waterfall follows the bars
+internal void
+fit_bars(spectrum_view_t *v, spectrum_state_t *s)
+{
+    spectrum_set_num_bars(s, calc_num_bars_for_width(v->plot_width));
+    v->num_bars = s->num_bars;
+    if (v->waterfall.enabled && !waterfall_resize(&v->waterfall, s->num_bars))
+    {
+        v->waterfall.enabled = 0;
+        update_plot_rect(v);
+    }
+}
+
+// Recomputes the plot rect and recreates everything sized from it
+internal void
+relayout(spectrum_view_t *v, spectrum_state_t *s)
+{
+    update_plot_rect(v);
+    if (v->fft_rt.id)
+    {
+        UnloadRenderTexture(v->fft_rt);
+        v->fft_rt = LoadRenderTexture(v->plot_width, v->plot_height);
+    }
+    if (v->gradient_tex.id)
+    {
+        UnloadTexture(v->gradient_tex);
+        v->gradient_tex = create_gradient_texture(v->plot_height, v->bar_gradients[v->bar_gradient_index]);
+    }
+
+    fit_bars(v, s);
+}
+
+// The analyser's bar hook (analysis thread): queues the new bars for the waterfall
+internal void
+push_waterfall_row(spectrum_state_t *s, void *user)
+{
+    spectrum_view_t *v = (spectrum_view_t *)user;
+    if (v->waterfall.enabled)
+    {
+        waterfall_push(&v->waterfall, s->bar_smoothed, s->num_bars);
+    }
+}
+
+void
+spectrum_view_init(spectrum_view_t *v, spectrum_state_t *s, Font font)
+{
+    memset(v, 0, sizeof(*v));
+    v->bar_gradients[0] = (bar_gradient_t){(Color){255, 128, 0, 255}, (Color){255, 255, 0, 255}};
+    v->bar_gradients[1] = (bar_gradient_t){(Color){0, 32, 255, 255}, (Color){0, 255, 255, 255}};
+    v->bar_gradients[2] = (bar_gradient_t){(Color){0, 255, 0, 255}, (Color){0, 255, 255, 255}};
+    v->bar_gradients[3] = (bar_gradient_t){(Color){255, 0, 128, 255}, (Color){255, 64, 255, 255}};
+    v->bar_gradients[4] = (bar_gradient_t){(Color){140, 0, 255, 255}, (Color){255, 0, 220, 255}};
+    v->bar_gradients[5] = (bar_gradient_t){(Color){0, 180, 255, 255}, (Color){140, 255, 0, 255}};
+    v->bar_gradients[6] = (bar_gradient_t){(Color){255, 40, 40, 255}, (Color){255, 180, 0, 255}};
+    v->bar_gradient_index = 2;
+    waterfall_init(&v->waterfall);
+    v->font = font;
+
+    Rectangle area = viewport_area(v);
+    v->layout_x = (i32)area.x;
+    v->layout_y = (i32)area.y;
+    v->layout_width = (i32)area.width;
+    v->layout_height = (i32)area.height;
+    update_plot_rect(v);
+    v->gradient_tex = create_gradient_texture(v->plot_height, v->bar_gradients[v->bar_gradient_index]);
+    v->fft_rt = LoadRenderTexture(v->plot_width, v->plot_height);
+    fit_bars(v, s);
+
+    s->on_bars = push_waterfall_row;
+    s->on_bars_user = v;
+}
+
+void
+spectrum_view_destroy(spectrum_view_t *v)
+{
+    if (v->gradient_tex.id)
+    {
+        UnloadTexture(v->gradient_tex);
+    }
+    if (v->fft_rt.id)
+    {
+        UnloadRenderTexture(v->fft_rt);
+    }
+    waterfall_destroy(&v->waterfall);
+    v->gradient_tex = (Texture2D){0};
+    v->fft_rt = (RenderTexture2D){0};
+}
+
+i32
+spectrum_view_resize_pending(const spectrum_view_t *v)
+{
+    Rectangle area = viewport_area(v);
+    return (i32)area.x != v->layout_x || (i32)area.y != v->layout_y || (i32)area.width != v->layout_width || (i32)area.height != v->layout_height;
+}
+
+void
+spectrum_view_set_viewport(spectrum_view_t *v, Rectangle r)
+{
+    v->viewport = r;
+}
+
+void
+spectrum_view_handle_resize(spectrum_view_t *v, spectrum_state_t *s)
+{
+    if (!spectrum_view_resize_pending(v))
+    {
+        return;
+    }
+
+    Rectangle area = viewport_area(v);
+    v->layout_x = (i32)area.x;
+    v->layout_y = (i32)area.y;
+    v->layout_width = (i32)area.width;
+    v->layout_height = (i32)area.height;
+    relayout(v, s);
+}
+
+void
+spectrum_view_cycle_gradient(spectrum_view_t *v)
+{
+    v->bar_gradient_index = (v->bar_gradient_index + 1) % NUM_BAR_GRADIENTS;
+    if (v->gradient_tex.id)
+    {
+        UnloadTexture(v->gradient_tex);
+    }
+    v->gradient_tex = create_gradient_texture(v->plot_height, v->bar_gradients[v->bar_gradient_index]);
+}
+
+void
+spectrum_view_render_to_texture(spectrum_view_t *v, const spectrum_frame_t *f)
+{
+    if (v->waterfall.enabled)
+    {
+        waterfall_upload(&v->waterfall);
+    }
+    if (f->num_bars != v->num_bars)
+    {
+        return;
+    }
+
+    BeginTextureMode(v->fft_rt);
+    ClearBackground(BLACK);
+    i32 h = v->plot_height;
+
+    const i32 stride = BAR_PIXEL_WIDTH + BAR_GAP;
+
+    for (i32 b = 0; b < v->num_bars; b++)
+    {
+        f64 mag_db = power_to_db(f->bar_smoothed[b]);
+
+        if (mag_db < DB_BOTTOM)
+        {
+            mag_db = DB_BOTTOM;
+        }
+        if (mag_db > DB_TOP)
+        {
+            mag_db = DB_TOP;
+        }
+
+        f64 norm = (mag_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+        i32 bar_h = (i32)(norm * h);
+        if (bar_h <= 0)
+        {
+            continue;
+        }
+
+        i32 x = b * stride;
+
+        Rectangle src = {0, (f32)(v->gradient_tex.height - bar_h), 1, (f32)bar_h};
+        Rectangle dst = {(f32)x, (f32)(h - bar_h), (f32)BAR_PIXEL_WIDTH, (f32)bar_h};
+        DrawTexturePro(v->gradient_tex, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+    }
+
+    Color grad_top = v->bar_gradients[v->bar_gradient_index].top;
+    Color peak_color = (Color){grad_top.r, grad_top.g, grad_top.b, 200};
+
+    Color max_hold_color = (Color){255, 255, 255, 100};
+
+    for (i32 b = 0; b < v->num_bars; b++)
+    {
+        f64 peak_power = f->peak_power[b];
+        if (peak_power <= 0)
+        {
+            continue;
+        }
+
+        f64 peak_db = power_to_db(peak_power);
+        if (peak_db < DB_BOTTOM)
+        {
+            continue;
+        }
+        if (peak_db > DB_TOP)
+        {
+            peak_db = DB_TOP;
+        }
+
+        f64 norm = (f64)(peak_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+        i32 y = h - (i32)(norm * h);
+        i32 x = b * stride;
+        DrawRectangle(x, y, BAR_PIXEL_WIDTH, 1, peak_color);
+    }
+
+    for (i32 b = 0; b < v->num_bars; b++)
+    {
+        i32 x = b * stride;
+        f64 max_hold_power = f->max_hold_power[b];
+        if (max_hold_power > 0.0)
+        {
+            f64 max_hold_db = power_to_db(max_hold_power);
+            if (max_hold_db >= DB_BOTTOM)
+            {
+                if (max_hold_db > DB_TOP)
+                {
+                    max_hold_db = DB_TOP;
+                }
+
+                f64 max_norm = (f64)(max_hold_db - DB_BOTTOM) / (DB_TOP - DB_BOTTOM);
+                i32 max_y = h - (i32)(max_norm * h);
+                DrawRectangle(x, max_y, BAR_PIXEL_WIDTH, 1, max_hold_color);
+            }
+        }
+    }
+
+    EndTextureMode();
+}
+
+i32
+spectrum_view_set_waterfall(spectrum_view_t *v, spectrum_state_t *s, i32 enabled)
+{
+    if (enabled && !waterfall_resize(&v->waterfall, s->num_bars))
+    {
+        return 0;
+    }
+
+    v->waterfall.enabled = enabled;
+    relayout(v, s);
+    return 1;
+}
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "spsc_ring.h"
+
+i32
+spsc_ring_init(spsc_ring_t *r, ul min_capacity)
+{
+    memset(r, 0, sizeof(*r));
+
+    ul capacity = 1;
+    while (capacity < min_capacity)
+    {
+        capacity <<= 1;
+    }
+
+    r->data = (f32 *)calloc(capacity, sizeof(f32));
+    if (!r->data)
+    {
+        return 0;
+    }
+
+    r->capacity = capacity;
+    r->mask = capacity - 1;
+    return 1;
+}
+
+void
+spsc_ring_destroy(spsc_ring_t *r)
+{
+    free(r->data);
+    memset(r, 0, sizeof(*r));
+}
+
+ul
+spsc_ring_push(spsc_ring_t *r, const f32 *src, ul n)
+{
+    // Acquire: the consumer is done reading the slots it has released
+    ul write = r->write;
+    ul space = r->capacity - (write - __atomic_load_n(&r->read, __ATOMIC_ACQUIRE));
+    if (n > space)
+    {
+        n = space;
+    }
+
+    ul pos = write & r->mask;
+    ul first = r->capacity - pos;
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(r->data + pos, src, first * sizeof(f32));
+    memcpy(r->data, src + first, (n - first) * sizeof(f32));
+
+    // Release: the samples are visible before the consumer can see the new count
+    __atomic_store_n(&r->write, write + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+ul
+spsc_ring_pop(spsc_ring_t *r, f32 *dst, ul n)
+{
+    ul read = r->read;
+    ul avail = __atomic_load_n(&r->write, __ATOMIC_ACQUIRE) - read;
+    if (n > avail)
+    {
+        n = avail;
+    }
+
+    ul pos = read & r->mask;
+    ul first = r->capacity - pos;
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(dst, r->data + pos, first * sizeof(f32));
+    memcpy(dst + first, r->data, (n - first) * sizeof(f32));
+
+    // Release: the slots are copied out before the producer may overwrite them
+    __atomic_store_n(&r->read, read + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+ul
+spsc_ring_count(const spsc_ring_t *r)
+{
+    ul read = __atomic_load_n(&r->read, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&r->write, __ATOMIC_ACQUIRE) - read;
+}
+
+ul
+spsc_ring_discard(spsc_ring_t *r)
+{
+    ul read = r->read;
+    ul write = __atomic_load_n(&r->write, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&r->read, write, __ATOMIC_RELEASE);
+    return write - read;
+}
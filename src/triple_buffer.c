@@ -0,0 +1,34 @@
+#include "triple_buffer.h"
+
+#define TRIPLE_BUFFER_FRESH 0x4u
+#define TRIPLE_BUFFER_SLOT  0x3u
+
+void
+triple_buffer_init(triple_buffer_t *t)
+{
+    t->back = 0;
+    t->middle = 1;
+    t->front = 2;
+}
+
+void
+triple_buffer_publish(triple_buffer_t *t)
+{
+    // Release: the slot contents are visible before the reader can take the slot
+    u32 old = __atomic_exchange_n(&t->middle, (u32)t->back | TRIPLE_BUFFER_FRESH, __ATOMIC_ACQ_REL);
+    t->back = (i32)(old & TRIPLE_BUFFER_SLOT);
+}
+
+i32
+triple_buffer_acquire(triple_buffer_t *t)
+{
+    if (!(__atomic_load_n(&t->middle, __ATOMIC_RELAXED) & TRIPLE_BUFFER_FRESH))
+    {
+        return 0;
+    }
+
+    // Acquire: pairs with the writer's release so the slot contents are complete
+    u32 old = __atomic_exchange_n(&t->middle, (u32)t->front, __ATOMIC_ACQ_REL);
+    t->front = (i32)(old & TRIPLE_BUFFER_SLOT);
+    return 1;
+}
@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "waterfall.h"
+
+// Black -> blue -> magenta -> orange -> yellow -> white, evenly spaced over the dB range
+global const Color PALETTE_STOPS[] = {
+    {0, 0, 0, 255}, {20, 10, 90, 255}, {150, 20, 140, 255}, {240, 90, 40, 255}, {255, 210, 40, 255}, {255, 255, 230, 255},
+};
+
+void
+waterfall_init(waterfall_t *w)
+{
+    memset(w, 0, sizeof(*w));
+
+    i32 segments = (i32)(sizeof(PALETTE_STOPS) / sizeof(PALETTE_STOPS[0])) - 1;
+    for (i32 i = 0; i < 256; i++)
+    {
+        f64 t = (f64)i / 255.0 * (f64)segments;
+        i32 seg = (i32)t;
+        if (seg >= segments)
+        {
+            seg = segments - 1;
+        }
+
+        f64 f = t - (f64)seg;
+        Color a = PALETTE_STOPS[seg];
+        Color b = PALETTE_STOPS[seg + 1];
+        w->palette[i] = (Color){
+            (u8)lround(a.r + (b.r - a.r) * f),
+            (u8)lround(a.g + (b.g - a.g) * f),
+            (u8)lround(a.b + (b.b - a.b) * f),
+            255,
+        };
+    }
+}
+
+void
+waterfall_destroy(waterfall_t *w)
+{
+    if (w->tex.id)
+    {
+        UnloadTexture(w->tex);
+    }
+    free(w->pending);
+    w->tex = (Texture2D){0};
+    w->pending = NULL;
+    w->width = 0;
+    w->pending_write = 0;
+    w->pending_read = 0;
+}
+
+i32
+waterfall_resize(waterfall_t *w, i32 num_bars)
+{
+    if (num_bars == w->width && w->tex.id)
+    {
+        return 1;
+    }
+
+    Color *pending = (Color *)malloc((size_t)num_bars * WATERFALL_MAX_PENDING_ROWS * sizeof(Color));
+    if (!pending)
+    {
+        return 0;
+    }
+
+    Image img = GenImageColor(num_bars, WATERFALL_HISTORY_ROWS, BLACK);
+    Texture2D tex = LoadTextureFromImage(img);
+    UnloadImage(img);
+    if (!tex.id)
+    {
+        free(pending);
+        return 0;
+    }
+    SetTextureWrap(tex, TEXTURE_WRAP_REPEAT);
+
+    waterfall_destroy(w);
+    w->tex = tex;
+    w->pending = pending;
+    w->width = num_bars;
+    w->head = 0;
+    return 1;
+}
+
+void
+waterfall_push(waterfall_t *w, const f64 *bar_power, i32 count)
+{
+    if (!w->pending || count != w->width)
+    {
+        return;
+    }
+
+    // The consumer owns the oldest slot while uploading it, so a full ring drops the new row
+    u32 write = w->pending_write;
+    if (write - __atomic_load_n(&w->pending_read, __ATOMIC_ACQUIRE) == WATERFALL_MAX_PENDING_ROWS)
+    {
+        return;
+    }
+
+    Color *row = w->pending + (size_t)(write % WATERFALL_MAX_PENDING_ROWS) * (size_t)w->width;
+    f64 scale = 255.0 / (DB_TOP - DB_BOTTOM);
+    for (i32 b = 0; b < count; b++)
+    {
+        f64 db = 10.0 * log10(bar_power[b] + EPSILON_POWER) + DB_OFFSET;
+        f64 level = (db - DB_BOTTOM) * scale;
+        i32 index = (level <= 0.0) ? 0 : ((level >= 255.0) ? 255 : (i32)level);
+        row[b] = w->palette[index];
+    }
+
+    __atomic_store_n(&w->pending_write, write + 1, __ATOMIC_RELEASE);
+}
+
+void
+waterfall_upload(waterfall_t *w)
+{
+    u32 write = __atomic_load_n(&w->pending_write, __ATOMIC_ACQUIRE);
+    for (u32 read = w->pending_read; read != write; read++)
+    {
+        const Color *row = w->pending + (size_t)(read % WATERFALL_MAX_PENDING_ROWS) * (size_t)w->width;
+        UpdateTextureRec(w->tex, (Rectangle){0, (f32)w->head, (f32)w->width, 1}, row);
+        w->head = (w->head + 1) % WATERFALL_HISTORY_ROWS;
+        __atomic_store_n(&w->pending_read, read + 1, __ATOMIC_RELEASE);
+    }
+}
+
+void
+waterfall_draw(const waterfall_t *w, Rectangle dst)
+{
+    if (!w->tex.id)
+    {
+        return;
+    }
+
+    // Rows head .. head + N - 1 (wrapping) run oldest to newest; the negative height flips
+    // them so the newest lands at the top of dst
+    Rectangle src = {0, (f32)w->head, (f32)w->width, -(f32)WATERFALL_HISTORY_ROWS};
+    DrawTexturePro(w->tex, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+}
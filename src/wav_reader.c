@@ -0,0 +1,341 @@
+#define _DEFAULT_SOURCE // madvise (posix_madvise cannot drop pages on glibc)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wav_reader.h"
+#include "simd.h"
+#include "spectrum_log.h"
+
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_FLOAT      0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+internal u32
+read_u16(const u8 *p)
+{
+    return (u32)p[0] | ((u32)p[1] << 8);
+}
+
+internal u32
+read_u32(const u8 *p)
+{
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+internal u64
+read_u64(const u8 *p)
+{
+    return (u64)read_u32(p) | ((u64)read_u32(p + 4) << 32);
+}
+
+// Walks the chunks for fmt and data (RF64 keeps the real data size in ds64).
+// Returns NULL on success, otherwise what is wrong with the file.
+internal const char *
+parse_header(wav_reader_t *r)
+{
+    const u8 *file = r->map;
+    usize size = r->map_size;
+    if (size < 12 || memcmp(file + 8, "WAVE", 4) != 0)
+    {
+        return "not a WAV file";
+    }
+
+    i32 rf64 = memcmp(file, "RF64", 4) == 0;
+    if (!rf64 && memcmp(file, "RIFF", 4) != 0)
+    {
+        return "not a WAV file";
+    }
+
+    u64 ds64_data_size = 0;
+    u32 tag = 0;
+    u32 block_align = 0;
+    u64 data_size = 0;
+    i32 have_fmt = 0;
+    i32 have_data = 0;
+    usize pos = 12;
+    while (pos + 8 <= size && !(have_fmt && have_data))
+    {
+        const u8 *chunk = file + pos;
+        u64 chunk_size = read_u32(chunk + 4);
+        usize body = pos + 8;
+        usize available = size - body;
+
+        if (memcmp(chunk, "ds64", 4) == 0 && chunk_size >= 16 && available >= 16)
+        {
+            ds64_data_size = read_u64(chunk + 16);
+        }
+        else if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && available >= 16)
+        {
+            tag = read_u16(chunk + 8);
+            r->channels = (i32)read_u16(chunk + 10);
+            r->sample_rate = (i32)read_u32(chunk + 12);
+            block_align = read_u16(chunk + 20);
+            r->bits = (i32)read_u16(chunk + 22);
+
+            // The sub-format GUID starts with the plain format tag
+            if (tag == WAV_FORMAT_EXTENSIBLE && chunk_size >= 40 && available >= 40)
+            {
+                tag = read_u16(chunk + 32);
+            }
+            have_fmt = 1;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            // A writer that never finalized the header leaves the size too large: take what the file holds
+            data_size = (rf64 && chunk_size == 0xFFFFFFFFu) ? ds64_data_size : chunk_size;
+            if (data_size > available)
+            {
+                data_size = available;
+            }
+            r->data_offset = body;
+            have_data = 1;
+        }
+
+        if (chunk_size > available)
+        {
+            break;
+        }
+        pos = body + (usize)chunk_size + (usize)(chunk_size & 1);
+    }
+
+    if (!have_fmt || !have_data)
+    {
+        return "missing fmt or data chunk";
+    }
+
+    if (tag == WAV_FORMAT_PCM && (r->bits == 8 || r->bits == 16 || r->bits == 24 || r->bits == 32))
+    {
+        r->sample_format = WAV_SAMPLE_PCM;
+    }
+    else if (tag == WAV_FORMAT_FLOAT && (r->bits == 32 || r->bits == 64))
+    {
+        r->sample_format = WAV_SAMPLE_FLOAT;
+    }
+    else
+    {
+        return "unsupported sample format (PCM 8/16/24/32-bit or float 32/64-bit only)";
+    }
+
+    r->frame_bytes = r->channels * (r->bits / 8);
+    if (r->channels < 1 || r->sample_rate <= 0 || (i32)block_align < r->frame_bytes)
+    {
+        return "invalid fmt chunk";
+    }
+    r->frame_bytes = (i32)block_align;
+
+    r->frame_count = (i64)(data_size / block_align);
+    if (r->frame_count == 0)
+    {
+        return "no audio data";
+    }
+
+    return NULL;
+}
+
+i32
+wav_reader_open(wav_reader_t *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+
+    i32 fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to open WAV: %s (%s)", path, strerror(errno));
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to load WAV: %s (empty or unreadable)", path);
+        close(fd);
+        return 0;
+    }
+
+    // The mapping keeps the file referenced; the descriptor is not needed afterwards
+    void *map = mmap(NULL, (usize)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to map WAV: %s (%s)", path, strerror(errno));
+        return 0;
+    }
+    r->map = (u8 *)map;
+    r->map_size = (usize)st.st_size;
+
+    const char *error = parse_header(r);
+    if (error)
+    {
+        spectrum_log(SPECTRUM_LOG_ERROR, "Failed to load WAV: %s (%s)", path, error);
+        wav_reader_close(r);
+        return 0;
+    }
+
+    madvise(r->map, (r->map_size < WAV_READAHEAD_BYTES) ? r->map_size : WAV_READAHEAD_BYTES, MADV_WILLNEED);
+    return 1;
+}
+
+void
+wav_reader_close(wav_reader_t *r)
+{
+    if (r->map)
+    {
+        munmap(r->map, r->map_size);
+    }
+    memset(r, 0, sizeof(*r));
+}
+
+internal void
+advise_chunk(const wav_reader_t *r, usize chunk, i32 advice)
+{
+    usize offset = chunk * WAV_READAHEAD_BYTES;
+    if (offset >= r->map_size)
+    {
+        return;
+    }
+
+    usize length = r->map_size - offset;
+    madvise(r->map + offset, (length < WAV_READAHEAD_BYTES) ? length : WAV_READAHEAD_BYTES, advice);
+}
+
+// On entering a new chunk, asks for the next one and drops the one two behind. Seeks and
+// loops only cost a few page faults: dropped pages are read back from the page cache.
+internal void
+advise_cursor(const wav_reader_t *r, usize start, usize end)
+{
+    usize first = start / WAV_READAHEAD_BYTES;
+    usize last = (end - 1) / WAV_READAHEAD_BYTES;
+    for (usize c = first + 1; c <= last; c++)
+    {
+        advise_chunk(r, c + 1, MADV_WILLNEED);
+        if (c >= 2)
+        {
+            advise_chunk(r, c - 2, MADV_DONTNEED);
+        }
+    }
+}
+
+// WAV is little endian like every target this builds for, so float samples are copied as is
+internal f32
+decode_sample(const u8 *p, i32 bits, i32 sample_format)
+{
+    if (sample_format == WAV_SAMPLE_FLOAT)
+    {
+        if (bits == 32)
+        {
+            f32 v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        f64 v;
+        memcpy(&v, p, sizeof(v));
+        return (f32)v;
+    }
+
+    if (bits == 8)
+    {
+        return ((f32)p[0] - 128.0f) * (1.0f / 128.0f);
+    }
+    if (bits == 16)
+    {
+        return (f32)(i16)read_u16(p) * (1.0f / 32768.0f);
+    }
+    if (bits == 24)
+    {
+        // Placed in the top three bytes for the sign, then scaled back down (exact)
+        i32 v = (i32)(((u32)p[0] << 8) | ((u32)p[1] << 16) | ((u32)p[2] << 24)) / 256;
+        return (f32)v * (1.0f / 8388608.0f);
+    }
+
+    return (f32)((f64)(i32)read_u32(p) * (1.0 / 2147483648.0));
+}
+
+void
+wav_reader_read_mono(const wav_reader_t *r, i64 frame, i32 count, f32 *dst)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    usize start = r->data_offset + (usize)frame * (usize)r->frame_bytes;
+    usize end = start + (usize)count * (usize)r->frame_bytes;
+    advise_cursor(r, start, end);
+
+    const u8 *src = r->map + start;
+    i32 stride = r->frame_bytes;
+    i32 bits = r->bits;
+    i32 sample_format = r->sample_format;
+
+    // Packed 32-bit float frames at a float-aligned offset are read in place
+    i32 packed_f32 = sample_format == WAV_SAMPLE_FLOAT && bits == 32 && stride == 4 * r->channels && (r->data_offset % sizeof(f32)) == 0;
+    if (packed_f32 && r->channels == 1)
+    {
+        memcpy(dst, src, (usize)count * sizeof(f32));
+        return;
+    }
+    if (packed_f32 && r->channels == 2)
+    {
+        simd_kernels()->downmix_stereo((const f32 *)(const void *)src, dst, count);
+        return;
+    }
+
+    if (r->channels == 1)
+    {
+        for (i32 i = 0; i < count; i++)
+        {
+            dst[i] = decode_sample(src + (usize)i * (usize)stride, bits, sample_format);
+        }
+        return;
+    }
+
+    i32 sample_bytes = bits / 8;
+    for (i32 i = 0; i < count; i++)
+    {
+        const u8 *p = src + (usize)i * (usize)stride;
+        dst[i] = 0.5f * (decode_sample(p, bits, sample_format) + decode_sample(p + sample_bytes, bits, sample_format));
+    }
+}
+
+void
+wav_reader_read_planar(const wav_reader_t *r, i64 frame, i32 count, i32 channels, f32 *dst, i32 stride)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    usize start = r->data_offset + (usize)frame * (usize)r->frame_bytes;
+    usize end = start + (usize)count * (usize)r->frame_bytes;
+    advise_cursor(r, start, end);
+
+    const u8 *src = r->map + start;
+    i32 frame_bytes = r->frame_bytes;
+    i32 bits = r->bits;
+    i32 sample_format = r->sample_format;
+
+    i32 packed_f32 = sample_format == WAV_SAMPLE_FLOAT && bits == 32 && frame_bytes == 4 * r->channels && (r->data_offset % sizeof(f32)) == 0;
+    if (packed_f32 && channels == r->channels)
+    {
+        simd_kernels()->deinterleave((const f32 *)(const void *)src, channels, dst, stride, count);
+        return;
+    }
+
+    i32 sample_bytes = bits / 8;
+    for (i32 c = 0; c < channels; c++)
+    {
+        const u8 *p = src + (usize)c * (usize)sample_bytes;
+        f32 *out = dst + (usize)c * (usize)stride;
+        for (i32 i = 0; i < count; i++)
+        {
+            out[i] = decode_sample(p + (usize)i * (usize)frame_bytes, bits, sample_format);
+        }
+    }
+}
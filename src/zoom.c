@@ -0,0 +1,216 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zoom.h"
+
+#define ZOOM_PI 3.14159265358979323846
+
+internal void
+free_buffers(zoom_state_t *z)
+{
+    free(z->taps);
+    free(z->delay_re);
+    free(z->delay_im);
+    free(z->base_re);
+    free(z->base_im);
+    free(z->power);
+    SPECTRUM_FFTW(free)(z->window);
+    SPECTRUM_FFTW(free)(z->fft_in);
+    SPECTRUM_FFTW(free)(z->fft_out);
+    z->taps = z->delay_re = z->delay_im = z->base_re = z->base_im = z->power = NULL;
+    z->window = NULL;
+    z->fft_in = z->fft_out = NULL;
+}
+
+i32
+zoom_init(zoom_state_t *z, f64 sample_rate)
+{
+    memset(z, 0, sizeof(*z));
+    z->sample_rate = sample_rate;
+    z->bin_hz = sample_rate / ((f64)ZOOM_DECIMATION * (f64)ZOOM_FFT_SIZE);
+
+    z->taps = (f64 *)malloc(ZOOM_FIR_TAPS * sizeof(f64));
+    z->delay_re = (f64 *)calloc(2 * ZOOM_FIR_TAPS, sizeof(f64));
+    z->delay_im = (f64 *)calloc(2 * ZOOM_FIR_TAPS, sizeof(f64));
+    z->base_re = (f64 *)calloc(2 * ZOOM_FFT_SIZE, sizeof(f64));
+    z->base_im = (f64 *)calloc(2 * ZOOM_FFT_SIZE, sizeof(f64));
+    z->power = (f64 *)calloc(ZOOM_FFT_SIZE, sizeof(f64));
+    z->window = SPECTRUM_FFTW(alloc_real)(ZOOM_FFT_SIZE);
+    z->fft_in = SPECTRUM_FFTW(alloc_complex)(ZOOM_FFT_SIZE);
+    z->fft_out = SPECTRUM_FFTW(alloc_complex)(ZOOM_FFT_SIZE);
+    if (!z->taps || !z->delay_re || !z->delay_im || !z->base_re || !z->base_im || !z->power || !z->window || !z->fft_in || !z->fft_out)
+    {
+        free_buffers(z);
+        return 0;
+    }
+
+    // One spectrum per ZOOM_HOP decimated samples (~1 s): not worth measuring, so plan directly
+    fft_plan_lock();
+    z->plan = SPECTRUM_FFTW(plan_dft_1d)(ZOOM_FFT_SIZE, z->fft_in, z->fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    fft_plan_unlock();
+    if (!z->plan)
+    {
+        free_buffers(z);
+        return 0;
+    }
+
+    // Blackman-windowed sinc, cutoff at the decimated Nyquist: the transition band spans the
+    // outer half, so the displayed middle half is flat and what aliases into it is >70 dB down
+    f64 cutoff = 0.5 / (f64)ZOOM_DECIMATION;
+    f64 mid = 0.5 * (f64)(ZOOM_FIR_TAPS - 1);
+    f64 sum = 0.0;
+    for (i32 k = 0; k < ZOOM_FIR_TAPS; k++)
+    {
+        f64 t = (f64)k - mid;
+        f64 sinc = (fabs(t) < 1e-9) ? 2.0 * cutoff : sin(2.0 * ZOOM_PI * cutoff * t) / (ZOOM_PI * t);
+        f64 w = 0.42 - 0.5 * cos(2.0 * ZOOM_PI * k / (ZOOM_FIR_TAPS - 1)) + 0.08 * cos(4.0 * ZOOM_PI * k / (ZOOM_FIR_TAPS - 1));
+        z->taps[k] = sinc * w;
+        sum += z->taps[k];
+    }
+    for (i32 k = 0; k < ZOOM_FIR_TAPS; k++)
+    {
+        z->taps[k] /= sum;
+    }
+
+    for (i32 i = 0; i < ZOOM_FFT_SIZE; i++)
+    {
+        z->window[i] = (spectrum_real_t)(0.5 * (1.0 - cos((2.0 * ZOOM_PI * i) / (f64)(ZOOM_FFT_SIZE - 1))));
+    }
+
+    zoom_set_center(z, 0.0);
+    return 1;
+}
+
+void
+zoom_destroy(zoom_state_t *z)
+{
+    if (z->plan)
+    {
+        fft_plan_lock();
+        SPECTRUM_FFTW(destroy_plan)(z->plan);
+        fft_plan_unlock();
+    }
+    free_buffers(z);
+    memset(z, 0, sizeof(*z));
+}
+
+void
+zoom_reset(zoom_state_t *z)
+{
+    z->osc_re = 1.0;
+    z->osc_im = 0.0;
+    memset(z->delay_re, 0, 2 * ZOOM_FIR_TAPS * sizeof(f64));
+    memset(z->delay_im, 0, 2 * ZOOM_FIR_TAPS * sizeof(f64));
+    memset(z->base_re, 0, 2 * ZOOM_FFT_SIZE * sizeof(f64));
+    memset(z->base_im, 0, 2 * ZOOM_FFT_SIZE * sizeof(f64));
+    memset(z->power, 0, ZOOM_FFT_SIZE * sizeof(f64));
+    z->delay_pos = 0;
+    z->decim_phase = 0;
+    z->base_pos = 0;
+    z->base_filled = 0;
+    z->base_since_fft = 0;
+    z->spectra = 0;
+}
+
+void
+zoom_set_center(zoom_state_t *z, f64 center_hz)
+{
+    z->center_hz = center_hz;
+    f64 w = -2.0 * ZOOM_PI * center_hz / z->sample_rate;
+    z->step_re = cos(w);
+    z->step_im = sin(w);
+    zoom_reset(z);
+}
+
+f64
+zoom_display_span_hz(const zoom_state_t *z)
+{
+    return 0.5 * z->sample_rate / (f64)ZOOM_DECIMATION;
+}
+
+internal void
+compute_zoom_spectrum(zoom_state_t *z)
+{
+    // Oldest to newest decimated samples are contiguous at base + base_pos
+    const f64 *re = z->base_re + z->base_pos;
+    const f64 *im = z->base_im + z->base_pos;
+    for (i32 i = 0; i < ZOOM_FFT_SIZE; i++)
+    {
+        z->fft_in[i][0] = (spectrum_real_t)re[i] * z->window[i];
+        z->fft_in[i][1] = (spectrum_real_t)im[i] * z->window[i];
+    }
+
+    SPECTRUM_FFTW(execute_dft)(z->plan, z->fft_in, z->fft_out);
+
+    // A real tone A*cos mixes down to A/2; with Hann coherent gain 0.5 that is |X| = A*N/4,
+    // so (4/N)^2 gives A^2 like the full-band bins. FFT order is 0..N/2-1, -N/2..-1.
+    f64 scale = 4.0 / (f64)ZOOM_FFT_SIZE;
+    f64 scale_sq = scale * scale;
+    i32 half = ZOOM_FFT_SIZE / 2;
+    for (i32 k = 0; k < ZOOM_FFT_SIZE; k++)
+    {
+        i32 src = (k + half) % ZOOM_FFT_SIZE;
+        f64 xr = (f64)z->fft_out[src][0];
+        f64 xi = (f64)z->fft_out[src][1];
+        z->power[k] = (xr * xr + xi * xi) * scale_sq;
+    }
+
+    z->spectra++;
+}
+
+void
+zoom_process(zoom_state_t *z, const spectrum_real_t *samples, i32 count)
+{
+    f64 osc_re = z->osc_re;
+    f64 osc_im = z->osc_im;
+    for (i32 i = 0; i < count; i++)
+    {
+        f64 x = (f64)samples[i];
+        i32 pos = z->delay_pos;
+        z->delay_re[pos] = z->delay_re[pos + ZOOM_FIR_TAPS] = x * osc_re;
+        z->delay_im[pos] = z->delay_im[pos + ZOOM_FIR_TAPS] = x * osc_im;
+        z->delay_pos = (pos + 1 == ZOOM_FIR_TAPS) ? 0 : pos + 1;
+
+        f64 next_re = osc_re * z->step_re - osc_im * z->step_im;
+        osc_im = osc_re * z->step_im + osc_im * z->step_re;
+        osc_re = next_re;
+
+        if (++z->decim_phase < ZOOM_DECIMATION)
+        {
+            continue;
+        }
+        z->decim_phase = 0;
+
+        // Symmetric taps: direction over the delay line does not matter
+        const f64 *dr = z->delay_re + z->delay_pos;
+        const f64 *di = z->delay_im + z->delay_pos;
+        f64 acc_re = 0.0;
+        f64 acc_im = 0.0;
+        for (i32 k = 0; k < ZOOM_FIR_TAPS; k++)
+        {
+            acc_re += z->taps[k] * dr[k];
+            acc_im += z->taps[k] * di[k];
+        }
+
+        i32 bpos = z->base_pos;
+        z->base_re[bpos] = z->base_re[bpos + ZOOM_FFT_SIZE] = acc_re;
+        z->base_im[bpos] = z->base_im[bpos + ZOOM_FFT_SIZE] = acc_im;
+        z->base_pos = (bpos + 1 == ZOOM_FFT_SIZE) ? 0 : bpos + 1;
+        if (z->base_filled < ZOOM_FFT_SIZE)
+        {
+            z->base_filled++;
+        }
+
+        if (++z->base_since_fft >= ZOOM_HOP && z->base_filled == ZOOM_FFT_SIZE)
+        {
+            z->base_since_fft = 0;
+            compute_zoom_spectrum(z);
+        }
+    }
+
+    // Keep the phasor on the unit circle against rounding drift
+    f64 mag = sqrt(osc_re * osc_re + osc_im * osc_im);
+    z->osc_re = osc_re / mag;
+    z->osc_im = osc_im / mag;
+}
@@ -0,0 +1,776 @@
+// Microbenchmarks for the spectrum pipeline hot paths.
+//
+// Times the analysis stages one at a time on synthetic signals, headless (no window, audio
+// device or font): the per-hop front-end, FFT and bin power, the bin-to-bar mapping, bar
+// smoothing, peak tracking, bar reallocation and the capture ring push/pop. Every case is
+// calibrated to run for at least --min-time, then measured BENCH_REPEATS times; the fastest
+// run is reported as ns/op and samples/s. A sample is the unit the stage consumes: input
+// samples (frames x channels) for the front-end and the ring, FFT bins for the bar mapping
+// and bars for the rest.
+//
+// Results are written as JSON with one case per line. --compare reads a file written by an
+// earlier run and exits non-zero if any case got slower by more than --tolerance percent.
+//
+// spectrum.c is included whole so its internal stages can be called one at a time; the
+// build links the rest of the analysis core (the libspectrum objects other than spectrum.o).
+
+#include "../src/spectrum.c"
+
+#include "perf.h"
+#include "spsc_ring.h"
+
+#define BENCH_SAMPLE_RATE       48000
+#define BENCH_HOP_DIVISOR       (FFT_WINDOW_SIZE / FFT_HOP_SIZE) // same overlap as the app default
+#define BENCH_SIGNAL_HOPS       16                               // hops of synthetic input cycled through
+#define BENCH_REPEATS           5
+#define BENCH_MAX_ITERATIONS    100000000
+#define BENCH_DEFAULT_MIN_TIME  0.05 // seconds per measured run
+#define BENCH_DEFAULT_TOLERANCE 10.0 // percent slower than the baseline that counts as a regression
+#define BENCH_DEFAULT_RIGOR     FFT_PLAN_RIGOR_ESTIMATE
+#define BENCH_MAX_CASES         256
+#define BENCH_NAME_LENGTH       64
+
+global const i32 FFT_SIZES[] = {1024, 4096, 16384, 65536};
+global const i32 BAR_COUNTS[] = {50, 200, 1000};
+global const i32 OCTAVE_INDICES[] = {0, 1, 4}; // 1/1, 1/3, 1/24
+global const i32 CHANNEL_COUNTS[] = {1, 2, 8};
+global const i32 BLOCK_FRAMES[] = {INPUT_LOW_LATENCY_FRAMES_PER_BUFFER, INPUT_FRAMES_PER_BUFFER};
+
+#define COUNT_OF(a) ((i32)(sizeof(a) / sizeof((a)[0])))
+
+typedef struct
+{
+    spectrum_state_t s;
+    i32 has_spectrum;
+    f32 *signal;       // BENCH_SIGNAL_HOPS hops of interleaved input
+    f64 *targets[2];   // bar targets the smoothing alternates between
+    f64 *smoothed_alt; // swapped in for bar_smoothed on every other update_peaks
+
+    spsc_ring_t ring;
+    f32 *block;
+    f32 *scratch;
+    i32 block_frames;
+    i32 channels;
+} bench_ctx_t;
+
+// Runs the stage iters times and returns the nanoseconds spent in it
+typedef u64 (*bench_fn_t)(bench_ctx_t *c, i64 iters);
+
+typedef struct
+{
+    char name[BENCH_NAME_LENGTH];
+    const char *op;
+    i32 fft_size;
+    i32 bars;
+    i32 octave_index; // -1 where the stage does not map bands
+    i32 channels;
+    f64 samples_per_op;
+    i64 iterations;
+    f64 ns_per_op;
+} bench_result_t;
+
+typedef struct
+{
+    f64 min_time;
+    const char *filter;
+    bench_result_t results[BENCH_MAX_CASES];
+    i32 count;
+} bench_run_t;
+
+// Tones at 440 Hz x (channel + 1) over white noise, different on every channel
+internal f32 *
+generate_signal(i32 frames, i32 channels)
+{
+    f32 *out = (f32 *)malloc((size_t)frames * (size_t)channels * sizeof(f32));
+    if (!out)
+    {
+        return NULL;
+    }
+
+    u32 rng = 0x12345678u;
+    for (i32 i = 0; i < frames; i++)
+    {
+        for (i32 c = 0; c < channels; c++)
+        {
+            rng = rng * 1664525u + 1013904223u;
+            f64 noise = ((f64)(rng >> 8) / (f64)(1u << 24)) * 2.0 - 1.0;
+            f64 tone = sin(2.0 * SPECTRUM_PI * 440.0 * (f64)(c + 1) * (f64)i / (f64)BENCH_SAMPLE_RATE);
+            out[(size_t)i * (size_t)channels + (size_t)c] = (f32)(0.5 * tone + 0.01 * noise);
+        }
+    }
+
+    return out;
+}
+
+// Bar powers spread over -60 ... -10 dBFS
+internal f64 *
+generate_bar_powers(i32 bars, u32 seed)
+{
+    f64 *out = (f64 *)malloc((size_t)bars * sizeof(f64));
+    if (!out)
+    {
+        return NULL;
+    }
+
+    u32 rng = seed;
+    for (i32 b = 0; b < bars; b++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        f64 db = -60.0 + 50.0 * ((f64)(rng >> 8) / (f64)(1u << 24));
+        out[b] = pow(10.0, db / 10.0);
+    }
+
+    return out;
+}
+
+internal void
+ctx_free(bench_ctx_t *c)
+{
+    if (c->has_spectrum)
+    {
+        spectrum_destroy(&c->s);
+    }
+    free(c->signal);
+    free(c->targets[0]);
+    free(c->targets[1]);
+    free(c->smoothed_alt);
+    spsc_ring_destroy(&c->ring);
+    free(c->block);
+    free(c->scratch);
+    memset(c, 0, sizeof(*c));
+}
+
+internal i32
+ctx_init_spectrum(bench_ctx_t *c, i32 fft_size, i32 bars, i32 octave_index, i32 channels)
+{
+    memset(c, 0, sizeof(*c));
+    spectrum_state_t *s = &c->s;
+    if (!spectrum_init(s, BENCH_SAMPLE_RATE, fft_size, fft_size / BENCH_HOP_DIVISOR, bars))
+    {
+        spectrum_destroy(s);
+        return 0;
+    }
+    c->has_spectrum = 1;
+
+    // Time the plans the analyser settles on, with the background planner idle for this size
+    s->fft_plan = fft_plan_get(fft_size);
+    for (i32 batch = 2; batch <= FFT_MAX_BATCH_HOPS; batch *= 2)
+    {
+        fft_plan_get_batch(fft_size, batch);
+    }
+    if (!s->fft_plan)
+    {
+        ctx_free(c);
+        return 0;
+    }
+    spectrum_set_input_channels(s, channels);
+    spectrum_set_fractional_octave(s, FRACTIONAL_OCTAVES[octave_index], octave_index);
+    c->channels = channels;
+
+    c->signal = generate_signal(s->hop_size * BENCH_SIGNAL_HOPS, channels);
+    c->targets[0] = generate_bar_powers(s->num_bars, 0x1u);
+    c->targets[1] = generate_bar_powers(s->num_bars, 0x2u);
+    c->smoothed_alt = generate_bar_powers(s->num_bars, 0x3u);
+    if (!c->signal || !c->targets[0] || !c->targets[1] || !c->smoothed_alt)
+    {
+        ctx_free(c);
+        return 0;
+    }
+
+    memcpy(s->bar_target, c->targets[0], (size_t)s->num_bars * sizeof(f64));
+    memcpy(s->bar_smoothed, c->targets[1], (size_t)s->num_bars * sizeof(f64));
+    return 1;
+}
+
+internal i32
+ctx_init_ring(bench_ctx_t *c, i32 block_frames, i32 channels)
+{
+    memset(c, 0, sizeof(*c));
+    c->block_frames = block_frames;
+    c->channels = channels;
+
+    // Sized like the capture ring: two seconds, at least two of the largest windows
+    ul ring_frames = (ul)BENCH_SAMPLE_RATE * 2;
+    if (ring_frames < (ul)(FFT_MAX_WINDOW_SIZE * 2))
+    {
+        ring_frames = (ul)(FFT_MAX_WINDOW_SIZE * 2);
+    }
+
+    c->block = generate_signal(block_frames, channels);
+    c->scratch = (f32 *)malloc((size_t)block_frames * (size_t)channels * sizeof(f32));
+    if (!c->block || !c->scratch || !spsc_ring_init(&c->ring, ring_frames * (ul)channels))
+    {
+        ctx_free(c);
+        return 0;
+    }
+
+    return 1;
+}
+
+// One hop of new live frames through downmix, HPF and window, the r2c transform and bin
+// power, as spectrum_update_windows runs it for a single window
+internal u64
+bench_fft_window(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    size_t hop_samples = (size_t)s->hop_size * (size_t)s->input_channels;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        s->window_index = 0;
+        s->stream_pos = 0;
+        prepare_fft_window(s, NULL, c->signal + (size_t)(i % BENCH_SIGNAL_HOPS) * hop_samples, s->hop_size, s->fft_in);
+        SPECTRUM_FFTW(execute_dft_r2c)(s->fft_plan->plan, s->fft_in, s->fft_out);
+        compute_bin_power(s, s->fft_out, s->bin_power);
+    }
+    return perf_now() - t;
+}
+
+internal u64
+bench_bar_targets(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        compute_bar_targets(s, s->bin_power, s->bar_target);
+    }
+    return perf_now() - t;
+}
+
+// The targets alternate so both the attack and the release branch run
+internal u64
+bench_smooth_db(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        smooth_bars_db(s, c->targets[i & 1], s->bar_smoothed, s->seconds_per_window);
+    }
+    return perf_now() - t;
+}
+
+internal u64
+bench_smooth_linear(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        smooth_bars_linear(s, c->targets[i & 1], s->bar_smoothed, s->seconds_per_window);
+    }
+    return perf_now() - t;
+}
+
+// Alternating smoothed bars keep the bars moving between new peaks, hold and decay
+internal u64
+bench_update_peaks(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    f64 *own = s->bar_smoothed;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        s->bar_smoothed = (i & 1) ? c->smoothed_alt : own;
+        update_peaks(s, s->seconds_per_window);
+    }
+    u64 elapsed = perf_now() - t;
+    s->bar_smoothed = own;
+    return elapsed;
+}
+
+// Every op resizes between the case's bar count and about 10% more, as a window resize does
+internal u64
+bench_reallocate_bars(bench_ctx_t *c, i64 iters)
+{
+    spectrum_state_t *s = &c->s;
+    i32 bars = s->num_bars;
+    i32 counts[2] = {bars + bars / 10 + 1, bars};
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        spectrum_set_num_bars(s, counts[i & 1]);
+    }
+    u64 elapsed = perf_now() - t;
+
+    spectrum_set_num_bars(s, counts[1]);
+    return elapsed;
+}
+
+// One capture block into the ring, as the audio callback pushes it. A full ring is emptied
+// (two atomic stores) so every push copies the whole block.
+internal u64
+bench_ring_push(bench_ctx_t *c, i64 iters)
+{
+    ul n = (ul)c->block_frames * (ul)c->channels;
+    u64 t = perf_now();
+    for (i64 i = 0; i < iters; i++)
+    {
+        if (c->ring.capacity - spsc_ring_count(&c->ring) < n)
+        {
+            spsc_ring_discard(&c->ring);
+        }
+        spsc_ring_push(&c->ring, c->block, n);
+    }
+    return perf_now() - t;
+}
+
+// One block out of the ring, as the analysis thread pops it; refills are not timed
+internal u64
+bench_ring_pop(bench_ctx_t *c, i64 iters)
+{
+    ul n = (ul)c->block_frames * (ul)c->channels;
+    u64 elapsed = 0;
+    i64 done = 0;
+    while (done < iters)
+    {
+        while (c->ring.capacity - spsc_ring_count(&c->ring) >= n)
+        {
+            spsc_ring_push(&c->ring, c->block, n);
+        }
+
+        u64 t = perf_now();
+        while (done < iters && spsc_ring_count(&c->ring) >= n)
+        {
+            spsc_ring_pop(&c->ring, c->scratch, n);
+            done++;
+        }
+        elapsed += perf_now() - t;
+    }
+    return elapsed;
+}
+
+internal i32
+case_wanted(const bench_run_t *run, const char *name)
+{
+    return run->count < BENCH_MAX_CASES && (!run->filter || strstr(name, run->filter));
+}
+
+// Grows the iteration count until one run fills min_time (the calibration doubles as the
+// warm-up), then keeps the fastest of BENCH_REPEATS runs
+internal void
+run_case(bench_run_t *run, bench_result_t *r, bench_fn_t fn, bench_ctx_t *c)
+{
+    u64 min_ns = (u64)(run->min_time * 1e9);
+    i64 iters = 1;
+    for (;;)
+    {
+        u64 ns = fn(c, iters);
+        if (ns >= min_ns || iters >= BENCH_MAX_ITERATIONS)
+        {
+            break;
+        }
+
+        f64 scale = (ns > 0) ? 1.2 * (f64)min_ns / (f64)ns : 10.0;
+        i64 next = (i64)((f64)iters * ((scale < 10.0) ? scale : 10.0));
+        iters = (next > iters) ? next : iters + 1;
+        if (iters > BENCH_MAX_ITERATIONS)
+        {
+            iters = BENCH_MAX_ITERATIONS;
+        }
+    }
+
+    f64 best = INFINITY;
+    for (i32 k = 0; k < BENCH_REPEATS; k++)
+    {
+        f64 per_op = (f64)fn(c, iters) / (f64)iters;
+        if (per_op < best)
+        {
+            best = per_op;
+        }
+    }
+
+    r->iterations = iters;
+    r->ns_per_op = best;
+    run->count++;
+
+    fprintf(stderr, "  %-40s %14.1f ns/op %12.2f Msamples/s\n", r->name, r->ns_per_op, r->samples_per_op / r->ns_per_op * 1e3);
+}
+
+internal bench_result_t *
+new_result(bench_run_t *run, const char *name, const char *op, i32 fft_size, i32 bars, i32 octave_index, i32 channels)
+{
+    bench_result_t *r = &run->results[run->count];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->op = op;
+    r->fft_size = fft_size;
+    r->bars = bars;
+    r->octave_index = octave_index;
+    r->channels = channels;
+    return r;
+}
+
+internal void
+bench_front_end(bench_run_t *run)
+{
+    for (i32 f = 0; f < COUNT_OF(FFT_SIZES); f++)
+    {
+        for (i32 ch = 0; ch < COUNT_OF(CHANNEL_COUNTS); ch++)
+        {
+            char name[BENCH_NAME_LENGTH];
+            snprintf(name, sizeof(name), "fft_window/n=%d/ch=%d", FFT_SIZES[f], CHANNEL_COUNTS[ch]);
+            bench_ctx_t c;
+            if (!case_wanted(run, name) || !ctx_init_spectrum(&c, FFT_SIZES[f], BAR_COUNTS[0], 4, CHANNEL_COUNTS[ch]))
+            {
+                continue;
+            }
+
+            bench_result_t *r = new_result(run, name, "fft_window", FFT_SIZES[f], 0, -1, CHANNEL_COUNTS[ch]);
+            r->samples_per_op = (f64)c.s.hop_size * (f64)CHANNEL_COUNTS[ch];
+            run_case(run, r, bench_fft_window, &c);
+            ctx_free(&c);
+        }
+    }
+}
+
+internal void
+bench_band_mapping(bench_run_t *run)
+{
+    for (i32 f = 0; f < COUNT_OF(FFT_SIZES); f++)
+    {
+        for (i32 b = 0; b < COUNT_OF(BAR_COUNTS); b++)
+        {
+            for (i32 o = 0; o < COUNT_OF(OCTAVE_INDICES); o++)
+            {
+                i32 octave = OCTAVE_INDICES[o];
+                char name[BENCH_NAME_LENGTH];
+                snprintf(name, sizeof(name), "bar_targets/n=%d/bars=%d/oct=1:%d", FFT_SIZES[f], BAR_COUNTS[b], (i32)(1.0 / FRACTIONAL_OCTAVES[octave] + 0.5));
+                bench_ctx_t c;
+                if (!case_wanted(run, name) || !ctx_init_spectrum(&c, FFT_SIZES[f], BAR_COUNTS[b], octave, 1))
+                {
+                    continue;
+                }
+
+                // A real spectrum to map; the band map is built by the first call
+                bench_fft_window(&c, BENCH_SIGNAL_HOPS);
+                bench_result_t *r = new_result(run, name, "bar_targets", FFT_SIZES[f], BAR_COUNTS[b], octave, 1);
+                r->samples_per_op = (f64)c.s.fft_bins;
+                run_case(run, r, bench_bar_targets, &c);
+                ctx_free(&c);
+            }
+        }
+    }
+}
+
+internal void
+bench_bar_traces(bench_run_t *run)
+{
+    const char *ops[] = {"smooth_bars_db", "smooth_bars_linear", "update_peaks", "reallocate_bars"};
+    bench_fn_t fns[] = {bench_smooth_db, bench_smooth_linear, bench_update_peaks, bench_reallocate_bars};
+    for (i32 k = 0; k < COUNT_OF(ops); k++)
+    {
+        for (i32 b = 0; b < COUNT_OF(BAR_COUNTS); b++)
+        {
+            char name[BENCH_NAME_LENGTH];
+            snprintf(name, sizeof(name), "%s/bars=%d", ops[k], BAR_COUNTS[b]);
+            bench_ctx_t c;
+            if (!case_wanted(run, name) || !ctx_init_spectrum(&c, FFT_WINDOW_SIZE, BAR_COUNTS[b], 4, 1))
+            {
+                continue;
+            }
+
+            bench_result_t *r = new_result(run, name, ops[k], FFT_WINDOW_SIZE, BAR_COUNTS[b], -1, 1);
+            r->samples_per_op = (f64)BAR_COUNTS[b];
+            run_case(run, r, fns[k], &c);
+            ctx_free(&c);
+        }
+    }
+}
+
+internal void
+bench_capture_ring(bench_run_t *run)
+{
+    const char *ops[] = {"ring_push", "ring_pop"};
+    bench_fn_t fns[] = {bench_ring_push, bench_ring_pop};
+    for (i32 k = 0; k < COUNT_OF(ops); k++)
+    {
+        for (i32 f = 0; f < COUNT_OF(BLOCK_FRAMES); f++)
+        {
+            for (i32 ch = 0; ch < COUNT_OF(CHANNEL_COUNTS); ch++)
+            {
+                char name[BENCH_NAME_LENGTH];
+                snprintf(name, sizeof(name), "%s/frames=%d/ch=%d", ops[k], BLOCK_FRAMES[f], CHANNEL_COUNTS[ch]);
+                bench_ctx_t c;
+                if (!case_wanted(run, name) || !ctx_init_ring(&c, BLOCK_FRAMES[f], CHANNEL_COUNTS[ch]))
+                {
+                    continue;
+                }
+
+                bench_result_t *r = new_result(run, name, ops[k], 0, 0, -1, CHANNEL_COUNTS[ch]);
+                r->samples_per_op = (f64)BLOCK_FRAMES[f] * (f64)CHANNEL_COUNTS[ch];
+                run_case(run, r, fns[k], &c);
+                ctx_free(&c);
+            }
+        }
+    }
+}
+
+internal void
+write_json(FILE *out, const bench_run_t *run)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"precision\": \"%s\",\n", SPECTRUM_PRECISION_LABEL);
+    fprintf(out, "  \"simd\": \"%s\",\n", simd_isa_name(simd_kernels()->isa));
+    fprintf(out, "  \"sample_rate\": %d,\n", BENCH_SAMPLE_RATE);
+    fprintf(out, "  \"min_time_s\": %g,\n", run->min_time);
+    fprintf(out, "  \"results\": [\n");
+    for (i32 i = 0; i < run->count; i++)
+    {
+        const bench_result_t *r = &run->results[i];
+        f64 frac = (r->octave_index >= 0) ? FRACTIONAL_OCTAVES[r->octave_index] : 0.0;
+        fprintf(
+            out,
+            "    {\"name\": \"%s\", \"op\": \"%s\", \"fft_size\": %d, \"bars\": %d, \"fractional_octave\": %.6f, \"channels\": %d, \"iterations\": %lld, "
+            "\"ns_per_op\": %.3f, \"samples_per_op\": %.0f, \"samples_per_s\": %.6e}%s\n",
+            r->name, r->op, r->fft_size, r->bars, frac, r->channels, (long long)r->iterations, r->ns_per_op, r->samples_per_op,
+            r->samples_per_op / r->ns_per_op * 1e9, (i < run->count - 1) ? "," : ""
+        );
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Reads the name and ns_per_op of every result line of a file written by write_json
+internal i32
+read_baseline(const char *path, bench_result_t *results, i32 capacity)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        return -1;
+    }
+
+    char line[1024];
+    i32 count = 0;
+    while (count < capacity && fgets(line, sizeof(line), f))
+    {
+        const char *name = strstr(line, "\"name\": \"");
+        const char *ns = strstr(line, "\"ns_per_op\": ");
+        if (!name || !ns)
+        {
+            continue;
+        }
+
+        name += strlen("\"name\": \"");
+        const char *end = strchr(name, '"');
+        bench_result_t *r = &results[count];
+        i32 length = (end && end - name < BENCH_NAME_LENGTH) ? (i32)(end - name) : 0;
+        if (length == 0 || sscanf(ns + strlen("\"ns_per_op\": "), "%lf", &r->ns_per_op) != 1)
+        {
+            continue;
+        }
+
+        memcpy(r->name, name, (size_t)length);
+        r->name[length] = '\0';
+        count++;
+    }
+
+    fclose(f);
+    return count;
+}
+
+// Prints every case against the baseline. Returns the number of cases slower than tolerance.
+internal i32
+compare_baseline(const bench_run_t *run, const bench_result_t *base, i32 base_count, f64 tolerance)
+{
+    i32 regressions = 0;
+    fprintf(stderr, "\n  %-40s %14s %14s %9s\n", "case", "baseline ns", "current ns", "change");
+    for (i32 i = 0; i < run->count; i++)
+    {
+        const bench_result_t *r = &run->results[i];
+        const bench_result_t *b = NULL;
+        for (i32 j = 0; j < base_count && !b; j++)
+        {
+            if (strcmp(base[j].name, r->name) == 0)
+            {
+                b = &base[j];
+            }
+        }
+
+        if (!b || b->ns_per_op <= 0.0)
+        {
+            fprintf(stderr, "  %-40s %14s %14.1f %9s\n", r->name, "-", r->ns_per_op, "new");
+            continue;
+        }
+
+        f64 change = (r->ns_per_op / b->ns_per_op - 1.0) * 100.0;
+        const char *verdict = "";
+        if (change > tolerance)
+        {
+            verdict = "  SLOWER";
+            regressions++;
+        }
+        else if (change < -tolerance)
+        {
+            verdict = "  faster";
+        }
+        fprintf(stderr, "  %-40s %14.1f %14.1f %+8.1f%%%s\n", r->name, b->ns_per_op, r->ns_per_op, change, verdict);
+    }
+
+    fprintf(stderr, "\n%d of %d cases slower than the baseline by more than %.1f%%\n", regressions, run->count, tolerance);
+    return regressions;
+}
+
+internal void
+print_usage(const char *prog)
+{
+    fprintf(
+        stderr,
+        "Usage:\n"
+        "  %s [options]\n\n"
+        "Options:\n"
+        "      --out <path>          Write the JSON results to path (default: stdout)\n"
+        "      --compare <path>      Compare against results saved by an earlier run; exit 1 on a regression\n"
+        "      --tolerance <pct>     Slowdown that counts as a regression (default: %.0f)\n"
+        "      --min-time <s>        Minimum duration of one measured run (default: %.2f)\n"
+        "      --filter <text>       Only run cases whose name contains text (e.g. bar_targets/n=4096)\n"
+        "      --rigor <name>        FFTW planning for the FFT cases: estimate|measure|patient|exhaustive (default: %s;\n"
+        "                            measure and up read and write the wisdom cache like the app)\n"
+        "  -h, --help                Show this help\n",
+        prog, BENCH_DEFAULT_TOLERANCE, BENCH_DEFAULT_MIN_TIME, fft_plan_rigor_name(BENCH_DEFAULT_RIGOR)
+    );
+}
+
+// Planning messages join the progress lines on stderr; stdout carries only the JSON
+internal void
+log_to_stderr(i32 level, const char *message, void *user)
+{
+    (void)user;
+    const char *prefix = (level == SPECTRUM_LOG_WARNING) ? "WARNING: " : ((level == SPECTRUM_LOG_ERROR) ? "ERROR: " : "");
+    fprintf(stderr, "%s%s\n", prefix, message);
+}
+
+int
+main(int argc, char **argv)
+{
+    local_persist bench_run_t run;
+    local_persist bench_result_t baseline[BENCH_MAX_CASES];
+    const char *out_path = NULL;
+    const char *compare_path = NULL;
+    f64 tolerance = BENCH_DEFAULT_TOLERANCE;
+    i32 rigor = BENCH_DEFAULT_RIGOR;
+    run.min_time = BENCH_DEFAULT_MIN_TIME;
+
+    for (i32 i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "Error: unknown option or missing value: %s\n\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        const char *value = argv[++i];
+        if (strcmp(arg, "--out") == 0)
+        {
+            out_path = value;
+        }
+        else if (strcmp(arg, "--compare") == 0)
+        {
+            compare_path = value;
+        }
+        else if (strcmp(arg, "--filter") == 0)
+        {
+            run.filter = value;
+        }
+        else if (strcmp(arg, "--rigor") == 0)
+        {
+            rigor = fft_plan_rigor_from_name(value);
+            if (rigor < 0)
+            {
+                fprintf(stderr, "Error: --rigor expects estimate, measure, patient or exhaustive.\n\n");
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--tolerance") == 0 || strcmp(arg, "--min-time") == 0)
+        {
+            char *end = NULL;
+            f64 v = strtod(value, &end);
+            if (!end || *end != '\0' || v <= 0.0)
+            {
+                fprintf(stderr, "Error: %s expects a positive number.\n\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+
+            if (strcmp(arg, "--tolerance") == 0)
+            {
+                tolerance = v;
+            }
+            else
+            {
+                run.min_time = v;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Error: unknown option: %s\n\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    i32 baseline_count = 0;
+    if (compare_path)
+    {
+        baseline_count = read_baseline(compare_path, baseline, BENCH_MAX_CASES);
+        if (baseline_count < 0)
+        {
+            fprintf(stderr, "ERROR: Failed to open baseline: %s\n", compare_path);
+            return 1;
+        }
+    }
+
+    FILE *out = stdout;
+    if (out_path)
+    {
+        out = fopen(out_path, "w");
+        if (!out)
+        {
+            fprintf(stderr, "ERROR: Failed to open output: %s\n", out_path);
+            return 1;
+        }
+    }
+
+    spectrum_set_log(log_to_stderr, NULL);
+    fft_plan_configure(rigor, 0);
+    simd_init();
+    fprintf(
+        stderr, "Spectrum pipeline benchmarks (%s, %s kernels, %s plans, %g s per run)\n", SPECTRUM_PRECISION_LABEL, simd_isa_name(simd_kernels()->isa),
+        fft_plan_rigor_name(rigor), run.min_time
+    );
+
+    bench_front_end(&run);
+    bench_band_mapping(&run);
+    bench_bar_traces(&run);
+    bench_capture_ring(&run);
+
+    write_json(out, &run);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    fft_plan_cache_destroy();
+
+    if (run.count == 0)
+    {
+        fprintf(stderr, "ERROR: No benchmark cases ran\n");
+        return 1;
+    }
+
+    if (compare_path && compare_baseline(&run, baseline, baseline_count, tolerance) > 0)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+// Accuracy report for PRECISION=single builds.
+//
+// Built once per precision against libspectrum: each build streams the same synthetic
+// signals through spectrum_push_frames and reads the result back with spectrum_read_bins
+// and spectrum_read_bands. The double build writes its results as a reference (--out);
+// the single build reads it (--compare) and reports how far its bins and bands drift from
+// it. Exits non-zero if any band inside the displayed dB range deviates by more than
+// REPORT_MAX_DISPLAY_ERROR_DB.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "redefines.h"
+#include "config.h"
+#include "fft_plan.h"
+#include "spectrum.h"
+
+#define REPORT_SAMPLE_RATE          48000
+#define REPORT_OCTAVE_INDEX         4   // 1/24 octave
+#define REPORT_SECONDS              2.0 // long enough for the bar smoothing to settle
+#define REPORT_MAX_DISPLAY_ERROR_DB 0.01
+#define REPORT_PI                   3.14159265358979323846
+
+typedef struct
+{
+    const char *name;
+    f64 freq_hz[3];
+    f64 level_dbfs[3];
+    f64 noise_dbfs;
+    f64 dc_offset;
+} test_signal_t;
+
+typedef struct
+{
+    i32 num_bins;
+    i32 num_bands;
+    f64 *bins;
+    f64 *bands;
+} report_result_t;
+
+global const test_signal_t TEST_SIGNALS[] = {
+    {"1 kHz @ -6 dBFS", {1000.0, 0.0, 0.0}, {-6.0, 0.0, 0.0}, -200.0, 0.0},
+    {"1 kHz @ -60 dBFS", {1000.0, 0.0, 0.0}, {-60.0, 0.0, 0.0}, -200.0, 0.0},
+    {"25 Hz + DC offset", {25.0, 0.0, 0.0}, {-12.0, 0.0, 0.0}, -200.0, 0.25},
+    {"Multi-tone 63/1k/12k", {63.0, 1000.0, 12000.0}, {-10.0, -40.0, -70.0}, -200.0, 0.0},
+    {"White noise @ -20 dBFS", {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, -20.0, 0.0},
+    {"Tone over noise floor", {440.0, 0.0, 0.0}, {-3.0, 0.0, 0.0}, -90.0, 0.0},
+};
+
+#define NUM_TEST_SIGNALS ((i32)(sizeof(TEST_SIGNALS) / sizeof(TEST_SIGNALS[0])))
+
+internal f32 *
+generate_signal(const test_signal_t *sig, i32 frames)
+{
+    f32 *out = (f32 *)malloc((size_t)frames * sizeof(f32));
+    if (!out)
+    {
+        return NULL;
+    }
+
+    u32 rng = 0x12345678u;
+    f64 noise_amp = pow(10.0, sig->noise_dbfs / 20.0) * sqrt(3.0);
+    for (i32 i = 0; i < frames; i++)
+    {
+        f64 x = sig->dc_offset;
+        for (i32 t = 0; t < 3; t++)
+        {
+            if (sig->freq_hz[t] > 0.0)
+            {
+                x += pow(10.0, sig->level_dbfs[t] / 20.0) * sin(2.0 * REPORT_PI * sig->freq_hz[t] * (f64)i / (f64)REPORT_SAMPLE_RATE);
+            }
+        }
+
+        rng = rng * 1664525u + 1013904223u;
+        x += noise_amp * (((f64)rng / 4294967295.0) * 2.0 - 1.0);
+        out[i] = (f32)x;
+    }
+
+    return out;
+}
+
+internal i32
+report_num_bars(void)
+{
+    return (WINDOW_WIDTH - (MARGIN_LEFT + MARGIN_RIGHT)) / (BAR_PIXEL_WIDTH + BAR_GAP);
+}
+
+// Streams one signal through the library in capture-sized blocks, like the live input path.
+internal i32
+analyze_signal(const test_signal_t *sig, report_result_t *r)
+{
+    spectrum_state_t s = {0};
+    i32 frames = (i32)(REPORT_SECONDS * REPORT_SAMPLE_RATE);
+    f32 *samples = generate_signal(sig, frames);
+    if (!samples || !spectrum_init(&s, REPORT_SAMPLE_RATE, FFT_WINDOW_SIZE, FFT_HOP_SIZE, report_num_bars()))
+    {
+        free(samples);
+        spectrum_destroy(&s);
+        return 0;
+    }
+
+    spectrum_set_fractional_octave(&s, FRACTIONAL_OCTAVES[REPORT_OCTAVE_INDEX], REPORT_OCTAVE_INDEX);
+    i32 ok = 1;
+    for (i32 i = 0; i < frames && ok; i += INPUT_FRAMES_PER_BUFFER)
+    {
+        i32 count = (frames - i < INPUT_FRAMES_PER_BUFFER) ? frames - i : INPUT_FRAMES_PER_BUFFER;
+        ok = spectrum_push_frames(&s, samples + i, count);
+    }
+
+    r->num_bins = spectrum_read_bins(&s, NULL, 0);
+    r->num_bands = spectrum_read_bands(&s, NULL, NULL, 0);
+    r->bins = (f64 *)malloc((size_t)r->num_bins * sizeof(f64));
+    r->bands = (f64 *)malloc((size_t)r->num_bands * sizeof(f64));
+    if (ok && r->bins && r->bands)
+    {
+        spectrum_read_bins(&s, r->bins, r->num_bins);
+        spectrum_read_bands(&s, NULL, r->bands, r->num_bands);
+    }
+    else
+    {
+        ok = 0;
+    }
+
+    free(samples);
+    spectrum_destroy(&s);
+    return ok;
+}
+
+internal void
+free_result(report_result_t *r)
+{
+    free(r->bins);
+    free(r->bands);
+    r->bins = NULL;
+    r->bands = NULL;
+}
+
+// Reference file: a header line, then per signal its bin and band counts followed by the
+// bin powers and band levels in dB, one value per line at full f64 precision.
+internal i32
+write_reference(const char *path, const report_result_t *results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        return 0;
+    }
+
+    fprintf(f, "precision_report %s %d %d %d %d\n", SPECTRUM_PRECISION_LABEL, FFT_WINDOW_SIZE, FFT_HOP_SIZE, REPORT_SAMPLE_RATE, NUM_TEST_SIGNALS);
+    for (i32 t = 0; t < NUM_TEST_SIGNALS; t++)
+    {
+        fprintf(f, "%d %d\n", results[t].num_bins, results[t].num_bands);
+        for (i32 k = 0; k < results[t].num_bins; k++)
+        {
+            fprintf(f, "%.17g\n", results[t].bins[k]);
+        }
+        for (i32 b = 0; b < results[t].num_bands; b++)
+        {
+            fprintf(f, "%.17g\n", results[t].bands[b]);
+        }
+    }
+
+    return fclose(f) == 0;
+}
+
+// Reads a file written by write_reference into results. Returns 0 if it cannot be read or
+// was written with a different FFT size, hop, sample rate or signal set.
+internal i32
+read_reference(const char *path, char *label, report_result_t *results)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        return 0;
+    }
+
+    i32 fft_size = 0;
+    i32 hop_size = 0;
+    i32 sample_rate = 0;
+    i32 num_signals = 0;
+    i32 ok = fscanf(f, "precision_report %7s %d %d %d %d", label, &fft_size, &hop_size, &sample_rate, &num_signals) == 5;
+    ok = ok && fft_size == FFT_WINDOW_SIZE && hop_size == FFT_HOP_SIZE && sample_rate == REPORT_SAMPLE_RATE && num_signals == NUM_TEST_SIGNALS;
+    for (i32 t = 0; t < NUM_TEST_SIGNALS && ok; t++)
+    {
+        report_result_t *r = &results[t];
+        ok = fscanf(f, "%d %d", &r->num_bins, &r->num_bands) == 2 && r->num_bins > 0 && r->num_bands > 0;
+        if (!ok)
+        {
+            break;
+        }
+
+        r->bins = (f64 *)malloc((size_t)r->num_bins * sizeof(f64));
+        r->bands = (f64 *)malloc((size_t)r->num_bands * sizeof(f64));
+        ok = r->bins && r->bands;
+        for (i32 k = 0; k < r->num_bins && ok; k++)
+        {
+            ok = fscanf(f, "%lf", &r->bins[k]) == 1;
+        }
+        for (i32 b = 0; b < r->num_bands && ok; b++)
+        {
+            ok = fscanf(f, "%lf", &r->bands[b]) == 1;
+        }
+    }
+
+    fclose(f);
+    return ok;
+}
+
+internal f64
+power_to_db(f64 power)
+{
+    return 10.0 * log10(power + EPSILON_POWER) + DB_OFFSET;
+}
+
+// Prints the deviation table against the reference. Returns the worst band deviation inside
+// the displayed dB range, or a negative value if the layouts do not match.
+internal f64
+compare_results(const char *ref_label, const report_result_t *ref, const report_result_t *cur)
+{
+    printf("Precision report: %s/libspectrum vs %s/libspectrum\n", SPECTRUM_PRECISION_LABEL, ref_label);
+    printf(
+        "FFT %d, hop %d, %d Hz, 1/%.0f octave, %d bands, display range %.0f..%.0f dB\n\n", FFT_WINDOW_SIZE, FFT_HOP_SIZE, REPORT_SAMPLE_RATE,
+        1.0 / FRACTIONAL_OCTAVES[REPORT_OCTAVE_INDEX], cur[0].num_bands, DB_BOTTOM, DB_TOP
+    );
+    printf("%-26s %16s %16s %16s %16s\n", "Signal", "bands max |dB|", "bands mean |dB|", "bands all |dB|", "bins max |dB|");
+
+    f64 worst_display = 0.0;
+    for (i32 t = 0; t < NUM_TEST_SIGNALS; t++)
+    {
+        if (ref[t].num_bins != cur[t].num_bins || ref[t].num_bands != cur[t].num_bands)
+        {
+            fprintf(
+                stderr, "ERROR: %s: reference has %d bins and %d bands, this build %d and %d\n", TEST_SIGNALS[t].name, ref[t].num_bins, ref[t].num_bands,
+                cur[t].num_bins, cur[t].num_bands
+            );
+            return -1.0;
+        }
+
+        f64 max_display = 0.0;
+        f64 sum_display = 0.0;
+        i32 count_display = 0;
+        f64 max_all = 0.0;
+        for (i32 b = 0; b < cur[t].num_bands; b++)
+        {
+            f64 err = fabs(cur[t].bands[b] - ref[t].bands[b]);
+            max_all = fmax(max_all, err);
+            if (ref[t].bands[b] >= DB_BOTTOM)
+            {
+                max_display = fmax(max_display, err);
+                sum_display += err;
+                count_display++;
+            }
+        }
+
+        f64 max_bins = 0.0;
+        for (i32 k = 0; k < cur[t].num_bins; k++)
+        {
+            f64 ref_db = power_to_db(ref[t].bins[k]);
+            if (ref_db >= DB_BOTTOM)
+            {
+                max_bins = fmax(max_bins, fabs(power_to_db(cur[t].bins[k]) - ref_db));
+            }
+        }
+
+        printf(
+            "%-26s %16.6f %16.6f %16.6f %16.6f\n", TEST_SIGNALS[t].name, max_display, (count_display > 0) ? sum_display / count_display : 0.0, max_all, max_bins
+        );
+        worst_display = fmax(worst_display, max_display);
+    }
+
+    printf("\nWorst band deviation inside display range: %.6f dB (limit %.3f dB)\n", worst_display, REPORT_MAX_DISPLAY_ERROR_DB);
+    return worst_display;
+}
+
+internal void
+print_usage(const char *prog)
+{
+    fprintf(
+        stderr,
+        "Usage:\n"
+        "  %s --out <path>        Write this build's results as the reference\n"
+        "  %s --compare <path>    Compare this build against a reference; exit 1 above %.3f dB\n",
+        prog, prog, REPORT_MAX_DISPLAY_ERROR_DB
+    );
+}
+
+int
+main(int argc, char **argv)
+{
+    if (argc != 3 || (strcmp(argv[1], "--out") != 0 && strcmp(argv[1], "--compare") != 0))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    local_persist report_result_t results[NUM_TEST_SIGNALS];
+    local_persist report_result_t reference[NUM_TEST_SIGNALS];
+    fft_plan_configure(FFT_PLAN_RIGOR_ESTIMATE, 0);
+
+    i32 status = 0;
+    for (i32 t = 0; t < NUM_TEST_SIGNALS && status == 0; t++)
+    {
+        if (!analyze_signal(&TEST_SIGNALS[t], &results[t]))
+        {
+            fprintf(stderr, "ERROR: Failed to analyze %s\n", TEST_SIGNALS[t].name);
+            status = 1;
+        }
+    }
+
+    if (status == 0 && strcmp(argv[1], "--out") == 0)
+    {
+        if (!write_reference(argv[2], results))
+        {
+            fprintf(stderr, "ERROR: Failed to write reference: %s\n", argv[2]);
+            status = 1;
+        }
+    }
+    else if (status == 0)
+    {
+        char ref_label[8] = {0};
+        if (!read_reference(argv[2], ref_label, reference))
+        {
+            fprintf(stderr, "ERROR: Failed to read reference (or it was written with other settings): %s\n", argv[2]);
+            status = 1;
+        }
+        else
+        {
+            f64 worst = compare_results(ref_label, reference, results);
+            status = (worst >= 0.0 && worst <= REPORT_MAX_DISPLAY_ERROR_DB) ? 0 : 1;
+        }
+    }
+
+    for (i32 t = 0; t < NUM_TEST_SIGNALS; t++)
+    {
+        free_result(&results[t]);
+        free_result(&reference[t]);
+    }
+    fft_plan_cache_destroy();
+
+    return status;
+}